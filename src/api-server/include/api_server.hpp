@@ -4,10 +4,21 @@
 #include <grpc/support/time.h>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <functional>
 #include <thread>
+#include <unordered_map>
 #include "logger.hpp" 
+#include "arena_pool.hpp"
+#include "thread_pool.hpp"
+#include "status_cache.hpp"
 #include "task.grpc.pb.h"       
 #include "task.pb.h"
 
@@ -15,68 +26,347 @@ namespace dts {
 
 using dts::proto::Task;
 using dts::proto::TaskResponse;
+using dts::proto::TaskBatch;
+using dts::proto::BatchAck;
+using dts::proto::CancelRequest;
+using dts::proto::CancelResponse;
+using dts::proto::QueryRequest;
+using dts::proto::SubscribeRequest;
+using dts::proto::TaskResult;
 using dts::proto::TaskService;
 using AsyncTaskService = dts::proto::TaskService::AsyncService;
 
 // 前向声明
 class AsyncServer;
 
-// 通用异步上下文（一次写成，终身复用）
-template <class Service, class Request, class Response>
-class AsyncCallContext {
+// CQ 上所有 tag 的公共基类：DriveCompletionQueue 只认它
+struct ServerTag {
+    virtual ~ServerTag() = default;
+    virtual void Proceed(bool ok) = 0;
+};
+
+// 业务回调执行器：CQ 线程只搬运事件，回调投到线程池执行，处理完再从池线程异步 Finish。
+// inflight 统计已投递、尚未执行完的回调数，停机时据此等回调收尾再关 CQ。
+class HandlerExecutor {
+public:
+    HandlerExecutor(std::size_t threads, std::size_t queue_capacity)
+        : pool_(threads, queue_capacity) {}
+
+    template <class F>
+    void Post(F&& fn) {
+        inflight_.fetch_add(1, std::memory_order_relaxed);
+        pool_.enqueue([this, f = std::forward<F>(fn)]() mutable {
+            f();
+            inflight_.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    std::size_t Inflight() const { return inflight_.load(std::memory_order_acquire); }
+
+    // 等到所有已投递的回调执行完
+    void Drain() const {
+        while (Inflight() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+private:
+    ThreadPool pool_;
+    std::atomic<std::size_t> inflight_{0};
+};
+
+// 一个 (一元 RPC 类型, CQ) 组合的上下文账本：上下文在挂起/接入/退役时更新，
+// 控制器按 starved 与 busy_peak 调整 target，不足时通过 spawn 补挂。
+struct ArmedPool {
+    std::atomic<int>            armed{0};       // 挂着等请求
+    std::atomic<int>            busy{0};        // 已接入、处理中
+    std::atomic<int>            busy_peak{0};   // 本采样周期内 busy 的峰值，控制器读后清零
+    std::atomic<int>            target{0};      // 控制器给出的上下文总数目标
+    std::atomic<int>            live{0};        // 现存上下文数（armed + busy + 复位中），只在目标变化时增减
+    std::atomic<std::uint64_t>  accepted{0};
+    std::atomic<std::uint64_t>  starved{0};     // 接入后本池已无预挂上下文 = 下一个请求要排队等
+    std::function<void()>       spawn;          // 在所属 CQ 上新挂一个上下文
+
+    void OnCreate() { live.fetch_add(1, std::memory_order_relaxed); }
+    void OnDestroy() { live.fetch_sub(1, std::memory_order_relaxed); }
+    void OnArm() { armed.fetch_add(1, std::memory_order_relaxed); }
+    void OnAccept() {
+        if (armed.fetch_sub(1, std::memory_order_relaxed) == 1)
+            starved.fetch_add(1, std::memory_order_relaxed);
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        int now = busy.fetch_add(1, std::memory_order_relaxed) + 1;
+        int peak = busy_peak.load(std::memory_order_relaxed);
+        while (now > peak && !busy_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    }
+    // 调用结束：返回 true 表示该上下文应退役（现存数超过目标，已从 live 中扣除）。
+    // 按 live 而不是 armed + busy 判断：复位中的上下文两边都不计，会被误当成缺额
+    bool OnFinish() {
+        busy.fetch_sub(1, std::memory_order_relaxed);
+        int n = live.load(std::memory_order_relaxed);
+        while (n > target.load(std::memory_order_relaxed)) {
+            if (live.compare_exchange_weak(n, n - 1, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+};
+
+// 通用一元调用上下文（一次写成，终身复用）
+// RequestMethod 是生成代码里的 AsyncService::RequestXxx，四个一元 RPC 共用这一份状态机。
+// 一次调用结束后原地复位再挂回 CQ：ServerContext/responder 在 optional 里重建，
+// 请求/响应从 Reset 过的同一个 arena 重新切，对象本身和 ProceedFunc 都不再 delete/new。
+template <class Service, class Request, class Response, auto RequestMethod>
+class AsyncCallContext : public ServerTag {
 public:
-    using ProceedFunc = std::function<void(AsyncCallContext*)>;
+    // 业务处理：填 response_，返回非 OK 时以该状态结束调用
+    using ProceedFunc = std::function<grpc::Status(AsyncCallContext*)>;
+
+    // 进程内累计：allocated = 构造次数，rearmed = 原地复用次数
+    struct PoolStats {
+        std::size_t allocated;
+        std::size_t rearmed;
+    };
+    static PoolStats Stats() {
+        return {allocated_.load(std::memory_order_relaxed),
+                rearmed_.load(std::memory_order_relaxed)};
+    }
 
+    // exec 非空时回调在执行器上跑，CQ 线程不被业务阻塞；pool 非空时参与自适应预挂
     AsyncCallContext(Service* svc,
                      grpc::ServerCompletionQueue* cq,
-                     ProceedFunc pf)
-        : service_(svc), cq_(cq), responder_(&ctx_),
+                     ProceedFunc pf,
+                     HandlerExecutor* exec = nullptr,
+                     ArmedPool* pool = nullptr)
+        : arena_(ArenaPool::Acquire()),
+          service_(svc), cq_(cq), exec_(exec), pool_(pool),
           proceed_(std::move(pf)), status_(CallStatus::CREATE) {
-        RequestNext();          // 第一次注册
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+        if (pool_) pool_->OnCreate();
+        Arm();                  // 第一次注册
     }
 
-    void Proceed(bool ok = true) {
+    void Proceed(bool ok = true) override {
         if (!ok) {
-            delete this;
+            if (pool_) {
+                if (status_ == CallStatus::CREATE) pool_->armed.fetch_sub(1, std::memory_order_relaxed);
+                else                               pool_->busy.fetch_sub(1, std::memory_order_relaxed);
+                pool_->OnDestroy();
+            }
+            delete this;        // 服务器关闭：不再重挂
             return;
         }
 
         switch (status_) {
         case CallStatus::CREATE:
-            if (proceed_) proceed_(this);
-            status_ = CallStatus::FINISH;
-            responder_.Finish(response_, grpc::Status::OK, this);
+            if (pool_) pool_->OnAccept();
+            status_ = CallStatus::FINISH;   // 先切状态：卸载后 Finish 可能在别的线程发出
+            if (exec_) exec_->Post([this] { Respond(); });
+            else       Respond();
             break;
 
         case CallStatus::FINISH:
-            {
-                // 1. 保存现场
-                auto* svc = service_;
-                auto* cq  = cq_;
-                auto  pf  = proceed_;
-                // 2. 自杀
-                delete this;
-                // 3. 同线程立即注册新对象（防止 CQ 饿死）
-                new AsyncCallContext<Service,Request,Response>(svc, cq, pf);
+            if (pool_ && pool_->OnFinish()) {
+                delete this;    // 现存数超过目标：退役，预挂数随负载回落
+                return;
             }
-            return;   // 必须 return，不再访问已销毁内存
+            status_ = CallStatus::REARM;
+            Rearm();            // 同线程立即重挂（防止 CQ 饿死）
+            break;
+
+        case CallStatus::REARM:
+            break;              // 只是复位中的过渡状态，不会有事件
         }
     }
 
-    void RequestNext();
+    grpc::ServerContext& context() { return *ctx_; }
+
+    // 业务回调里调用：本次不随回调返回而回包，改由之后（任意线程）的 Reply 结束调用，
+    // 回调的返回值随之忽略。用于等别处的结果时不占着 CQ/执行器线程
+    void Defer() { deferred_ = true; }
+    void Reply(const grpc::Status& st) {
+        reply_ = st;
+        if (Arrive()) Finish(reply_);
+    }
 
-    grpc::ServerContext   ctx_;
-    Request               request_;
-    Response              response_;
+    // 请求/响应分配在本对象独占的 arena 上，每次复位只 Reset，首块内存一直留着
+    ArenaPool::Handle     arena_;
+    Request*              request_ = nullptr;
+    Response*             response_ = nullptr;
 
 private:
     enum class CallStatus { CREATE, FINISH, REARM };
-    Service*                                    service_;
+
+    // 跑业务回调并发出 Finish；gRPC 允许在任意线程发起操作
+    void Respond() {
+        deferred_ = false;
+        arrived_.store(0, std::memory_order_relaxed);
+        grpc::Status st = proceed_ ? proceed_(this) : grpc::Status::OK;
+        if (!deferred_)   Finish(st);
+        else if (Arrive()) Finish(reply_);       // Reply 已在回调返回前到达
+    }
+
+    void Finish(const grpc::Status& st) {
+        if (st.ok()) responder_->Finish(*response_, st, this);
+        else         responder_->FinishWithError(st, this);
+    }
+
+    // 延迟回包的两方（回调返回、Reply）都到了才 Finish，后到的一方发出；
+    // 之后本对象可能已被复位，先到的一方不能再碰它
+    bool Arrive() { return arrived_.fetch_add(1, std::memory_order_acq_rel) == 1; }
+
+    void Arm() {
+        request_  = google::protobuf::Arena::CreateMessage<Request>(arena_.get());
+        response_ = google::protobuf::Arena::CreateMessage<Response>(arena_.get());
+        ctx_.emplace();
+        responder_.emplace(&*ctx_);
+        status_ = CallStatus::CREATE;
+        if (pool_) pool_->OnArm();
+        (service_->*RequestMethod)(&*ctx_, request_, &*responder_, cq_, cq_, this);
+    }
+
+    void Rearm() {
+        responder_.reset();     // 先于 ctx_ 析构，它持有 ctx_ 的指针
+        ctx_.reset();
+        arena_.get()->Reset();
+        rearmed_.fetch_add(1, std::memory_order_relaxed);
+        Arm();
+    }
+
+    Service*                                                    service_;
+    grpc::ServerCompletionQueue*                                cq_;
+    HandlerExecutor*                                            exec_;
+    ArmedPool*                                                  pool_;
+    std::optional<grpc::ServerContext>                          ctx_;
+    std::optional<grpc::ServerAsyncResponseWriter<Response>>    responder_;
+    ProceedFunc                                                 proceed_;
+    CallStatus                                                  status_;
+    bool                                                        deferred_ = false;
+    std::atomic<int>                                            arrived_{0};
+    grpc::Status                                                reply_;
+
+    static inline std::atomic<std::size_t> allocated_{0};
+    static inline std::atomic<std::size_t> rearmed_{0};
+};
+
+using SubmitTaskCall  = AsyncCallContext<AsyncTaskService, Task, TaskResponse,
+                                         &AsyncTaskService::RequestSubmitTask>;
+using CancelTaskCall  = AsyncCallContext<AsyncTaskService, CancelRequest, CancelResponse,
+                                         &AsyncTaskService::RequestCancelTask>;
+using QueryStatusCall = AsyncCallContext<AsyncTaskService, QueryRequest, Task,
+                                         &AsyncTaskService::RequestQueryStatus>;
+
+// 批量提交流：一条 HTTP/2 流上连续收批次，每批处理完按序回一条 ack。
+// 读 → 处理 → 写 严格交替，同一时刻只挂一个操作，单个 tag 足够；
+// 客户端不等 ack 就能继续写，流控窗口内的批次都已在路上。
+class SubmitTasksStream final : public ServerTag {
+public:
+    using BatchFunc = std::function<void(const TaskBatch&, BatchAck*)>;
+
+    SubmitTasksStream(AsyncTaskService* svc, grpc::ServerCompletionQueue* cq, BatchFunc fn,
+                      HandlerExecutor* exec = nullptr);
+    void Proceed(bool ok) override;
+
+private:
+    enum class Step { kAccept, kRead, kWrite, kFinish };
+
+    void HandleAndWrite();
+
+    AsyncTaskService*                                   service_;
+    grpc::ServerCompletionQueue*                        cq_;
+    BatchFunc                                           handle_;
+    HandlerExecutor*                                    exec_;
+    grpc::ServerContext                                 ctx_;
+    grpc::ServerAsyncReaderWriter<BatchAck, TaskBatch>  stream_;
+    // 跨批次复用：Clear 保留已分配的子消息，稳态下收发不再分配
+    TaskBatch                                           batch_;
+    BatchAck                                            ack_;
+    Step                                                step_ = Step::kAccept;
+};
+
+// 结果订阅流（服务端流）：接入后登记到 AsyncServer，由 PublishResult 从任意线程推送。
+// 同一时刻最多一个 Write 在途（gRPC 的要求，也是天然的流控）；写的期间积压的结果
+// 在下一次写时合成一条消息（最多 kMaxBatch 条），发布越快每条消息带的结果越多。
+// 积压超过 kMaxPending 说明客户端读不动，直接断开；客户端可凭游标重连续传。
+class ListenResultsCall final : public ServerTag {
+public:
+    static constexpr std::size_t kMaxPending = 1024;
+    static constexpr int kMaxBatch = 64;
+
+    ListenResultsCall(AsyncServer* server, AsyncTaskService* svc, grpc::ServerCompletionQueue* cq);
+    void Proceed(bool ok) override;             // accept / write / finish 完成
+
+    // 以下由 AsyncServer 在该 client 的结果日志锁内调用，序号天然连续
+    // 接入：first_seq 是下一条要发的序号，随即发出首条消息
+    void Begin(std::uint64_t first_seq, bool gap, std::vector<std::shared_ptr<const Task>> replay);
+    void Push(std::shared_ptr<const Task> task);
+    // 任意线程调用
+    void Close(const grpc::Status& status);
+
+    const std::string& client_id() const { return request_.client_id(); }
+    std::uint64_t resume_after() const { return request_.resume_after(); }
+
+private:
+    // 客户端断开/取消的通知，与主 tag 分开计数
+    struct DoneTag : ServerTag {
+        explicit DoneTag(ListenResultsCall* o) : owner(o) {}
+        void Proceed(bool) override { owner->OnDone(); }
+        ListenResultsCall* owner;
+    };
+
+    enum class Step { kAccept, kIdle, kWrite, kFinish, kClosed };
+
+    void OnDone();
+    void WriteBatchLocked();
+    void FinishLocked();
+    // done 已回来且没有在途操作时注销并自毁
+    void MaybeDestroy(std::unique_lock<std::mutex>& lk);
+
+    AsyncServer*                                server_;
+    AsyncTaskService*                           service_;
     grpc::ServerCompletionQueue*                cq_;
-    grpc::ServerAsyncResponseWriter<Response>   responder_;
-    ProceedFunc                                 proceed_;
-    CallStatus                                  status_;
+    grpc::ServerContext                         ctx_;
+    grpc::ServerAsyncWriter<TaskResult>         writer_;
+    SubscribeRequest                            request_;
+    DoneTag                                     done_tag_;
+
+    std::mutex                                  mu_;
+    std::deque<std::shared_ptr<const Task>>     pending_;       // 还没写出的结果
+    std::uint64_t                               pending_seq_ = 0;   // pending_.front() 的序号
+    bool                                        gap_ = false;       // 下一条消息带 gap 标记
+    TaskResult                                  out_;           // 在途的那条消息，复用
+    grpc::Status                                close_status_;
+    Step                                        step_ = Step::kAccept;
+    int                                         ops_ = 1;       // 挂在 CQ 上未回来的操作数
+    bool                                        done_ = false;
+    bool                                        closing_ = false;
 };
+
+// 自适应控制的边界（每个 (RPC 类型, CQ) 的上下文数，每个 CQ 的轮询线程数）
+struct AdaptiveLimits {
+    int min_contexts = 1;
+    int max_contexts = 256;                         // 卸载模式下不生效：固定按 max_inflight 均分
+    int min_threads_per_cq = 1;
+    int max_threads_per_cq = 2;
+    std::chrono::milliseconds tick{100};            // 采样周期
+    int shrink_after_ticks = 10;                    // 连续这么多个周期不饥饿才收缩
+};
+
+// 控制器当前的取值，供监控/日志读取
+struct ServerMetrics {
+    struct Cq {
+        int threads = 0;
+        double utilization = 0;                     // 上一周期轮询线程忙于处理事件的比例
+        int armed = 0;                              // 三种一元 RPC 合计
+        int busy = 0;
+        int target = 0;
+        int live = 0;                               // 现存上下文数，稳态下等于 target
+        std::uint64_t accepted = 0;
+        std::uint64_t starved = 0;
+    };
+    std::vector<Cq> cqs;
+    int armed = 0;
+    int target = 0;
+    int live = 0;
+    int threads = 0;
+};
+
 // 高性能异步服务器（零手写状态机）
 class AsyncServer final {
 public:
@@ -89,19 +379,155 @@ public:
     // 业务注册点：只写函数，不写类
     using SubmitTaskFunc = std::function<void(Task*, TaskResponse*)>;
     void SetSubmitTaskHandler(SubmitTaskFunc f) { submit_task_ = std::move(f); }
+    // 批量提交：未注册时逐个回 SUCCESS
+    using SubmitBatchFunc = SubmitTasksStream::BatchFunc;
+    void SetSubmitBatchHandler(SubmitBatchFunc f) { submit_batch_ = std::move(f); }
+    // 查询：未注册时一律 NOT_FOUND
+    using QueryStatusFunc = std::function<grpc::Status(const QueryRequest&, Task*)>;
+    void SetQueryStatusHandler(QueryStatusFunc f) { query_status_ = std::move(f); }
+    // 取消：未注册时回 success=false
+    using CancelTaskFunc = std::function<grpc::Status(const CancelRequest&, CancelResponse*)>;
+    void SetCancelTaskHandler(CancelTaskFunc f) { cancel_task_ = std::move(f); }
+
+    // 开启业务回调卸载（须在 Run 之前）：回调在 threads 个池线程上执行。
+    // 开启后每种一元 RPC 预挂的上下文数固定为 max_inflight（不参与自适应）：上下文要么挂着等请求、要么在处理中，
+    // 处理越慢挂着的越少，超出的请求留在 gRPC 侧排队，不会在线程池里越堆越多。
+    void EnableHandlerOffload(std::size_t threads, std::size_t max_inflight);
+    // 自适应预挂与 CQ 线程数的边界（须在 Run 之前）
+    void SetAdaptiveLimits(const AdaptiveLimits& limits) { limits_ = limits; }
+    ServerMetrics Metrics() const;
+
+    // QueryStatus 前置缓存（须在 Run 之前）：同 task_id 的并发查询合并成一次后端调用，
+    // 结果按 TTL 缓存；PublishResult 推送的状态迁移会让对应条目失效
+    void EnableStatusCache(const StatusCacheOptions& opts = {});
+    // 后端不经 PublishResult 改了状态时手动失效
+    void InvalidateStatus(const std::string& task_id);
+    StatusCache::Stats StatusCacheStats() const;
+
+    // 带 idempotency_key 的 SubmitTask 在窗口内只执行一次，重复请求拿到第一次的回包
+    void SetIdempotencyWindow(std::chrono::milliseconds ttl, std::size_t max_keys) {
+        idem_ttl_ = ttl;
+        idem_max_ = max_keys;
+    }
+
+    // 已投递、尚未处理完的回调数（未开启卸载时恒为 0）
+    std::size_t HandlersInflight() const { return executor_ ? executor_->Inflight() : 0; }
+
+    // 结果回放（须在 Run 之前）：每个 client_id 保留最近 ring 条结果供断线重连续传，
+    // 最多跟踪 max_clients 个 client_id，超出时淘汰最久没有活动且无人订阅的。
+    // 默认 ring = kMaxPending：因积压被断开（RESOURCE_EXHAUSTED）的订阅者落后不超过这么多，
+    // 重连能补齐；调得更小则这种续传必然报 gap
+    void SetResultReplay(std::size_t ring, std::size_t max_clients) {
+        replay_ring_ = std::min(ring, ListenResultsCall::kMaxPending);   // 回放一次写不完就没意义
+        replay_clients_ = std::max<std::size_t>(max_clients, 1);
+    }
+
+    // 给结果编号、记入回放环并推给该 client_id 的所有订阅流（任意线程可调）；返回推送到的流数
+    std::size_t PublishResult(const Task& task);
+    std::size_t SubscriberCount() const;
 
 private:
-    void DriveCompletionQueue(grpc::ServerCompletionQueue* cq);
-    void OnSubmitTask(AsyncCallContext<AsyncTaskService, Task, TaskResponse>* ctx);
+    friend class ListenResultsCall;
 
-    std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+    // 每个 CQ 一份：轮询线程、忙碌计时和退役闹钟
+    struct CqSlot {
+        // 闹钟到点时被某个轮询线程取到，该线程随即退出
+        struct RetireTag : ServerTag { void Proceed(bool) override {} };
+
+        std::unique_ptr<grpc::ServerCompletionQueue> cq;
+        std::vector<std::thread>    threads;            // 增减与回收都在 metrics_mu_ 下
+        std::atomic<int>            live_threads{0};
+        std::mutex                  exited_mu;
+        std::vector<std::thread::id> exited;            // 已退役、等控制器 join 的线程
+        std::atomic<std::uint64_t>  busy_ns{0};         // 累计处理事件耗时
+        std::uint64_t               last_busy_ns = 0;   // 以下两项在 metrics_mu_ 下读写
+        double                      utilization = 0;
+        grpc::Alarm                 retire_alarm;
+        RetireTag                   retire_tag;
+        std::atomic<bool>           retire_pending{false};
+        std::vector<ArmedPool*>     pools;              // 该 CQ 上的三种一元 RPC
+    };
+
+    void DriveCompletionQueue(CqSlot* slot);
+    void StartPollThread(CqSlot* slot);
+    void ReapPollThreads(CqSlot* slot);   // 调用方持 metrics_mu_
+    void ControlLoop();
+    void ControlTick();
+    grpc::Status OnSubmitTask(SubmitTaskCall* ctx);
+    void RunSubmit(SubmitTaskCall* ctx);
+    grpc::Status OnCancelTask(CancelTaskCall* ctx);
+    grpc::Status OnQueryStatus(QueryStatusCall* ctx);
+    void OnSubmitBatch(const TaskBatch& batch, BatchAck* ack);
+
+    // 每个 client_id 一份：序号、回放环和订阅流，都在 mu 下读写
+    struct ResultLog {
+        std::mutex                                  mu;
+        std::uint64_t                               next_seq = 1;
+        std::deque<std::shared_ptr<const Task>>     ring;       // ring.front() 的序号 = next_seq - ring.size()
+        std::vector<ListenResultsCall*>             subs;
+        std::string                                 client_id;
+        bool                                        idle = false;   // 在 idle_ 里（无人订阅）
+        std::list<ResultLog*>::iterator             idle_pos;
+    };
+
+    // 不存在就建（期间会临时换成写锁）；返回的引用在 lk 持有期间有效
+    ResultLog& LogFor(const std::string& client_id, std::shared_lock<std::shared_mutex>& lk);
+    void EvictLogLocked();                // 调用方持写锁
+    void TouchLogLocked(ResultLog& log);  // 调用方持 log.mu：按订阅有无进出 idle_，有活动的挪到队尾
+    void Subscribe(ListenResultsCall* call);
+    void Unsubscribe(ListenResultsCall* call);
+
+    std::vector<std::unique_ptr<CqSlot>> slots_;
+    std::vector<std::unique_ptr<ArmedPool>> pools_;
     AsyncTaskService service_;
     std::unique_ptr<grpc::Server> server_;
     std::atomic<bool> shutdown_{false};
-    std::vector<std::thread> cq_threads_;
     int listen_port_ = 0;
 
+    AdaptiveLimits limits_;
+    struct PoolHistory {
+        std::uint64_t starved = 0;
+        int quiet_ticks = 0;
+        int min = 0, max = 0;               // 该池上下文数的上下界（卸载模式下 min == max）
+    };
+    std::vector<PoolHistory> history_;      // 与 pools_ 一一对应，Run 之后仅控制器线程访问
+    std::thread controller_;
+    std::mutex ctl_mu_;
+    std::condition_variable ctl_cv_;
+    mutable std::mutex metrics_mu_;         // 保护线程数调整与 Metrics() 读取
+
     SubmitTaskFunc submit_task_;          // 业务回调
+    SubmitBatchFunc submit_batch_;
+    QueryStatusFunc query_status_;
+    CancelTaskFunc cancel_task_;
+
+    std::unique_ptr<StatusCache> status_cache_;   // 为空 = 每次查询直达后端
+
+    // 提交去重表：key → 第一次执行的状态；按插入顺序过期。执行中的重复请求延迟回包，
+    // 挂在 waiters 上由执行方结束时一并回复，不占 CQ/执行器线程；执行失败时条目删掉，key 可以重试
+    struct IdemFlight {
+        std::shared_ptr<const TaskResponse> response;    // 为空 = 第一次还在执行
+        std::vector<SubmitTaskCall*>        waiters;     // 在 idem_mu_ 下追加/取走
+    };
+    struct IdemExpiry {
+        std::chrono::steady_clock::time_point at;
+        std::string                           key;
+        const IdemFlight*                     flight;    // 同 key 失败后重建的条目不被旧记录过期
+    };
+    std::mutex idem_mu_;
+    std::unordered_map<std::string, std::shared_ptr<IdemFlight>> idem_;
+    std::deque<IdemExpiry> idem_order_;
+    std::chrono::milliseconds idem_ttl_{60'000};
+    std::size_t idem_max_ = 65'536;
+    std::unique_ptr<HandlerExecutor> executor_;   // 为空 = 回调直接在 CQ 线程上跑
+    std::size_t max_inflight_ = 0;
+
+    mutable std::shared_mutex subs_mu_;   // 日志表：查找走读锁，新建/淘汰走写锁
+    std::unordered_map<std::string, std::unique_ptr<ResultLog>> logs_;
+    std::mutex idle_mu_;                  // 在 subs_mu_ 与日志锁之后拿
+    std::list<ResultLog*> idle_;          // 无人订阅的日志，按最后活动从旧到新；淘汰取队首
+    std::size_t replay_ring_ = ListenResultsCall::kMaxPending;
+    std::size_t replay_clients_ = 1024;
 };
 
 } // namespace dts
\ No newline at end of file
@@ -0,0 +1,90 @@
+// status_cache.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <grpcpp/support/status.h>
+#include "task.pb.h"
+
+namespace dts {
+
+struct StatusCacheOptions {
+    std::chrono::milliseconds ttl{200};     // 轮询场景下足够短，状态迁移另有主动失效
+    std::size_t shards = 16;
+    std::size_t max_entries_per_shard = 4096;
+};
+
+// QueryStatus 前置缓存：按 task_id 分片，短 TTL。
+// 未命中时同一 task_id 的并发查询只有一个去后端取（single-flight），其余把回调挂上去，
+// 由取回结果的线程依次调用，等待方的线程不阻塞；只缓存 OK 的结果，错误照样合并但不留存。
+class StatusCache {
+public:
+    using Loader = std::function<grpc::Status(proto::Task*)>;
+    // task 只在 status OK 时有意义，仅在回调期间有效
+    using Done = std::function<void(const grpc::Status& status, const proto::Task& task)>;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t loads = 0;            // 实际打到后端的次数
+        std::uint64_t coalesced = 0;        // 等别人取回来的次数
+        std::uint64_t invalidations = 0;
+    };
+
+    explicit StatusCache(const StatusCacheOptions& opts = {});
+
+    StatusCache(const StatusCache&) = delete;
+    StatusCache& operator=(const StatusCache&) = delete;
+
+    // 命中或由本线程加载时在调用线程上回调 done；合并到进行中的加载时立即返回，
+    // done 稍后在加载方线程上调用。loader 在调用线程上执行，抛异常按 INTERNAL 交付
+    void Get(const std::string& task_id, const Loader& loader, Done done);
+    // 同步版本：合并时阻塞等加载方，只给不在 CQ/执行器线程上的调用方用
+    grpc::Status Get(const std::string& task_id, proto::Task* out, const Loader& loader);
+
+    // 状态迁移时调用：丢掉缓存值，进行中的那次加载结果也不再入缓存
+    void Invalidate(const std::string& task_id);
+
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        grpc::Status status;
+        proto::Task  task;
+    };
+    // 一次进行中的加载：发起方持有，挂在条目上供后来者登记回调
+    struct Flight {
+        std::vector<Done> waiters;                            // 在分片锁下追加/取走
+    };
+    struct Entry {
+        std::shared_ptr<const Result> value;                  // 为空 = 无缓存值
+        Clock::time_point             expires;
+        std::shared_ptr<Flight>       flight;                 // 非空 = 有加载在进行；失效时摘掉
+    };
+    struct Shard {
+        std::mutex                             mu;
+        std::unordered_map<std::string, Entry> map;
+    };
+
+    Shard& ShardFor(const std::string& task_id);
+    void   Trim(Shard& shard, Clock::time_point now);   // 调用方持锁
+
+    StatusCacheOptions                  opts_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> loads_{0};
+    std::atomic<std::uint64_t> coalesced_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
+
+} // namespace dts
@@ -1,17 +1,192 @@
 #include "api_server.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace dts {
 
-/* ---------- AsyncCallContext 实现 ---------- */
-template <typename S, typename Rq, typename Rp>
-void AsyncCallContext<S, Rq, Rp>::RequestNext() {
-    status_ = CallStatus::CREATE;
-    service_->RequestSubmitTask(&ctx_, &request_, &responder_, cq_, cq_, this);
+/* ---------- SubmitTasksStream 实现 ---------- */
+SubmitTasksStream::SubmitTasksStream(AsyncTaskService* svc,
+                                     grpc::ServerCompletionQueue* cq,
+                                     BatchFunc fn,
+                                     HandlerExecutor* exec)
+    : service_(svc), cq_(cq), handle_(std::move(fn)), exec_(exec), stream_(&ctx_) {
+    service_->RequestSubmitTasks(&ctx_, &stream_, cq_, cq_, this);
 }
 
-/* 显式实例化（防止模板多次定义） */
-template class AsyncCallContext<AsyncTaskService, Task, TaskResponse>;
+void SubmitTasksStream::Proceed(bool ok) {
+    switch (step_) {
+    case Step::kAccept:
+        if (!ok) {                        // 服务器关闭
+            delete this;
+            return;
+        }
+        // 先挂下一个监听，再处理本条流，保证新连接随时能接入
+        new SubmitTasksStream(service_, cq_, handle_, exec_);
+        step_ = Step::kRead;
+        stream_.Read(&batch_, this);
+        return;
+
+    case Step::kRead:
+        if (!ok) {                        // 客户端 WritesDone 或断开
+            step_ = Step::kFinish;
+            stream_.Finish(grpc::Status::OK, this);
+            return;
+        }
+        step_ = Step::kWrite;             // 先切状态：卸载后 Write 可能在池线程发出
+        if (exec_) exec_->Post([this] { HandleAndWrite(); });
+        else       HandleAndWrite();
+        return;
+
+    case Step::kWrite:
+        if (!ok) {
+            step_ = Step::kFinish;
+            stream_.Finish(grpc::Status(grpc::StatusCode::UNAVAILABLE, "ack write failed"), this);
+            return;
+        }
+        step_ = Step::kRead;
+        stream_.Read(&batch_, this);
+        return;
+
+    case Step::kFinish:
+        delete this;
+        return;
+    }
+}
+
+void SubmitTasksStream::HandleAndWrite() {
+    ack_.Clear();
+    ack_.set_batch_id(batch_.batch_id());
+    handle_(batch_, &ack_);
+    batch_.Clear();
+    stream_.Write(ack_, this);
+}
+
+/* ---------- ListenResultsCall 实现 ---------- */
+ListenResultsCall::ListenResultsCall(AsyncServer* server,
+                                     AsyncTaskService* svc,
+                                     grpc::ServerCompletionQueue* cq)
+    : server_(server), service_(svc), cq_(cq), writer_(&ctx_), done_tag_(this) {
+    ctx_.AsyncNotifyWhenDone(&done_tag_);     // 必须在 Request 之前登记
+    service_->RequestListenResults(&ctx_, &request_, &writer_, cq_, cq_, this);
+}
+
+void ListenResultsCall::Proceed(bool ok) {
+    std::unique_lock<std::mutex> lk(mu_);
+    --ops_;
+    switch (step_) {
+    case Step::kAccept:
+        if (!ok) {                            // 服务器关闭，调用没开始，done tag 不会回来
+            lk.unlock();
+            delete this;
+            return;
+        }
+        // 登记期间占住一个计数，防止 done 先回来把自己删掉
+        ops_ += 2;                            // done tag + 登记中
+        step_ = Step::kIdle;
+        lk.unlock();
+        if (!server_->shutdown_.load(std::memory_order_acquire)) {
+            new ListenResultsCall(server_, service_, cq_);
+        }
+        server_->Subscribe(this);
+        lk.lock();
+        --ops_;
+        MaybeDestroy(lk);
+        return;
+
+    case Step::kWrite:
+        if (!ok) {                            // 对端已断，剩下的丢掉，等 done
+            pending_.clear();
+            step_ = Step::kClosed;
+            MaybeDestroy(lk);
+            return;
+        }
+        if (!pending_.empty()) {
+            WriteBatchLocked();
+            return;
+        }
+        step_ = Step::kIdle;
+        if (closing_) FinishLocked();
+        return;
+
+    case Step::kFinish:
+        step_ = Step::kClosed;
+        MaybeDestroy(lk);
+        return;
+
+    case Step::kIdle:
+    case Step::kClosed:
+        return;                               // 不会有事件落在这两个状态
+    }
+}
+
+void ListenResultsCall::Begin(std::uint64_t first_seq, bool gap,
+                              std::vector<std::shared_ptr<const Task>> replay) {
+    std::lock_guard<std::mutex> lk(mu_);
+    pending_seq_ = first_seq;
+    gap_ = gap;
+    pending_.assign(std::make_move_iterator(replay.begin()), std::make_move_iterator(replay.end()));
+    if (done_ || closing_ || step_ != Step::kIdle) return;
+    WriteBatchLocked();                       // 首条消息没有结果也要发：客户端靠它拿到游标
+}
+
+void ListenResultsCall::Push(std::shared_ptr<const Task> task) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (done_ || closing_ || (step_ != Step::kIdle && step_ != Step::kWrite)) return;
+    if (pending_.size() >= kMaxPending) {
+        // 慢消费者：丢弃积压，写完在途的那条后断开；客户端凭游标重连从回放环续传
+        pending_.clear();
+        closing_ = true;
+        close_status_ = grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "subscriber too slow");
+        if (step_ == Step::kIdle) FinishLocked();
+        return;
+    }
+    pending_.push_back(std::move(task));
+    if (step_ == Step::kIdle) WriteBatchLocked();
+}
+
+void ListenResultsCall::Close(const grpc::Status& status) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (done_ || closing_) return;
+    closing_ = true;
+    close_status_ = status;
+    if (step_ == Step::kIdle) FinishLocked();  // 写到一半的等队列写完再 Finish
+}
+
+void ListenResultsCall::WriteBatchLocked() {
+    step_ = Step::kWrite;
+    ++ops_;
+    const auto n = std::min<std::size_t>(pending_.size(), kMaxBatch);
+    out_.Clear();                             // 保留已分配的 tasks，稳态下不再分配
+    out_.set_first_seq(pending_seq_);
+    out_.set_gap(gap_);
+    gap_ = false;
+    for (std::size_t i = 0; i < n; ++i) {
+        *out_.add_tasks() = *pending_.front();
+        pending_.pop_front();
+    }
+    pending_seq_ += n;
+    writer_.Write(out_, this);
+}
+
+void ListenResultsCall::FinishLocked() {
+    step_ = Step::kFinish;
+    ++ops_;
+    writer_.Finish(close_status_, this);
+}
+
+void ListenResultsCall::OnDone() {
+    std::unique_lock<std::mutex> lk(mu_);
+    --ops_;
+    done_ = true;
+    MaybeDestroy(lk);
+}
+
+void ListenResultsCall::MaybeDestroy(std::unique_lock<std::mutex>& lk) {
+    if (!done_ || ops_ > 0) return;
+    lk.unlock();
+    server_->Unsubscribe(this);               // 拿日志锁摘掉自己，正在 Push 的发布者退出后才轮到
+    delete this;
+}
 
 /* ---------- AsyncServer 实现 ---------- */
 AsyncServer::AsyncServer() = default;
@@ -23,60 +198,484 @@ void AsyncServer::Run(uint16_t port) {
     builder.AddListeningPort(addr, grpc::InsecureServerCredentials(), &listen_port_);
     builder.RegisterService(&service_);
 
-    size_t cq_count = std::thread::hardware_concurrency();
+    // CQ 只能在 Build 前添加，数量固定；随负载伸缩的是每个 CQ 的轮询线程和预挂上下文
+    size_t cq_count = std::max(1u, std::thread::hardware_concurrency());
     for (size_t i = 0; i < cq_count; ++i) {
-        cqs_.emplace_back(builder.AddCompletionQueue());
+        auto slot = std::make_unique<CqSlot>();
+        slot->cq = builder.AddCompletionQueue();
+        slots_.push_back(std::move(slot));
     }
 
     server_ = builder.BuildAndStart();
     LOG(INFO) << "AsyncServer listening on " << listen_port_;
 
+    // 初始预挂：按 CPU 数，可用环境变量覆盖，之后由控制器在 [min, max] 内伸缩。
+    // 卸载模式下上下文数就是在途上限：按 CQ 均分 max_inflight 且固定不变。
+    const int n = static_cast<int>(cq_count);
     int c = std::thread::hardware_concurrency() * 2;
-    const char* env = std::getenv("DTS_INITIAL_CONTEXT");
-    if (env) c = std::stoi(env);
+    if (const char* env = std::getenv("DTS_INITIAL_CONTEXT")) c = std::stoi(env);
+    limits_.max_contexts = std::max(limits_.max_contexts, limits_.min_contexts);
+
+    auto* exec = executor_.get();
+    for (int k = 0; k < n; ++k) {
+        auto* cq = slots_[k]->cq.get();
+        PoolHistory bounds;
+        if (executor_) {
+            const int m = static_cast<int>(max_inflight_);
+            bounds.min = bounds.max = m / n + (k < m % n ? 1 : 0);
+        } else {
+            bounds.min = limits_.min_contexts;
+            bounds.max = limits_.max_contexts;
+        }
+        const int initial = std::clamp((c + n - 1) / n, bounds.min, bounds.max);
+        auto add_pool = [&](std::function<void(ArmedPool*)> make) {
+            auto pool = std::make_unique<ArmedPool>();
+            ArmedPool* p = pool.get();
+            p->target.store(initial, std::memory_order_relaxed);
+            p->spawn = [make = std::move(make), p] { make(p); };
+            slots_[k]->pools.push_back(p);
+            pools_.push_back(std::move(pool));
+            history_.push_back(bounds);
+            for (int i = 0; i < initial; ++i) p->spawn();
+        };
+        add_pool([this, cq, exec](ArmedPool* p) {
+            new SubmitTaskCall(&service_, cq,
+                               [this](SubmitTaskCall* ctx) { return OnSubmitTask(ctx); }, exec, p);
+        });
+        add_pool([this, cq, exec](ArmedPool* p) {
+            new QueryStatusCall(&service_, cq,
+                                [this](QueryStatusCall* ctx) { return OnQueryStatus(ctx); }, exec, p);
+        });
+        add_pool([this, cq, exec](ArmedPool* p) {
+            new CancelTaskCall(&service_, cq,
+                               [this](CancelTaskCall* ctx) { return OnCancelTask(ctx); }, exec, p);
+        });
 
-    for (int i = 0; i < c; ++i) {
-        auto* cq = cqs_[i % cq_count].get();
-        new AsyncCallContext<AsyncTaskService, Task, TaskResponse>(
-            &service_, cq,
-            [this](auto* ctx) { OnSubmitTask(ctx); });
+        // 流是长连接，每个 CQ 挂一个监听即可：接入一条就立刻补一个
+        new SubmitTasksStream(&service_, cq,
+                              [this](const TaskBatch& b, BatchAck* a) { OnSubmitBatch(b, a); },
+                              exec);
+        new ListenResultsCall(this, &service_, cq);
     }
 
-    cq_threads_.reserve(cq_count);
-    for (auto& cq : cqs_) {
-        cq_threads_.emplace_back([this, cq_ptr = cq.get()] {
-            DriveCompletionQueue(cq_ptr);
-        });
+    for (auto& slot : slots_) {
+        for (int i = 0; i < limits_.min_threads_per_cq; ++i) StartPollThread(slot.get());
     }
+    controller_ = std::thread([this] { ControlLoop(); });
+}
+
+void AsyncServer::EnableHandlerOffload(std::size_t threads, std::size_t max_inflight) {
+    max_inflight_ = std::max<std::size_t>(1, max_inflight);
+    // 队列容量按在途上限留足：上下文数封顶了同时投递的回调数，enqueue 不会自旋
+    executor_ = std::make_unique<HandlerExecutor>(std::max<std::size_t>(1, threads),
+                                                  std::max<std::size_t>(1024, 4 * max_inflight_ + 64));
+}
+
+void AsyncServer::EnableStatusCache(const StatusCacheOptions& opts) {
+    status_cache_ = std::make_unique<StatusCache>(opts);
+}
+
+void AsyncServer::InvalidateStatus(const std::string& task_id) {
+    if (status_cache_) status_cache_->Invalidate(task_id);
+}
+
+StatusCache::Stats AsyncServer::StatusCacheStats() const {
+    return status_cache_ ? status_cache_->stats() : StatusCache::Stats{};
 }
 
 void AsyncServer::Shutdown() {
-    shutdown_ = true;
-    server_->Shutdown();
-    for (auto& cq : cqs_) cq->Shutdown();
-    for (auto& t : cq_threads_)
-        if (t.joinable()) t.join();
+    if (!server_ || shutdown_.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lk(ctl_mu_);
+    }
+    ctl_cv_.notify_all();
+    if (controller_.joinable()) controller_.join();   // 之后不会再有补挂/增减线程
+    {
+        std::shared_lock<std::shared_mutex> lk(subs_mu_);
+        for (auto& [_, log] : logs_) {
+            std::lock_guard<std::mutex> g(log->mu);
+            for (auto* call : log->subs)
+                call->Close(grpc::Status(grpc::StatusCode::UNAVAILABLE, "server shutting down"));
+        }
+    }
+    // 给在途调用一点收尾时间，到点强制取消，不让卡住的订阅流拖住停机
+    server_->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+    // 池里还没跑完的回调会往 CQ 上发 Finish/Write，必须在关 CQ 之前等它们收尾
+    if (executor_) executor_->Drain();
+    for (auto& slot : slots_) slot->cq->Shutdown();
+    for (auto& slot : slots_) {
+        for (auto& t : slot->threads)
+            if (t.joinable()) t.join();
+    }
+}
+
+void AsyncServer::StartPollThread(CqSlot* slot) {
+    slot->live_threads.fetch_add(1, std::memory_order_relaxed);
+    slot->threads.emplace_back([this, slot] { DriveCompletionQueue(slot); });
 }
 
-void AsyncServer::DriveCompletionQueue(grpc::ServerCompletionQueue* cq) {
+void AsyncServer::ReapPollThreads(CqSlot* slot) {
+    std::vector<std::thread::id> ids;
+    {
+        std::lock_guard<std::mutex> g(slot->exited_mu);
+        ids.swap(slot->exited);
+    }
+    for (auto id : ids) {
+        auto it = std::find_if(slot->threads.begin(), slot->threads.end(),
+                               [id](const std::thread& t) { return t.get_id() == id; });
+        if (it == slot->threads.end()) continue;
+        it->join();                           // 已登记退出，join 不会久等
+        slot->threads.erase(it);
+    }
+}
+
+void AsyncServer::DriveCompletionQueue(CqSlot* slot) {
+    auto* cq = slot->cq.get();
     void* tag;
     bool ok;
     while (true) {
         // 被 Shutdown() 唤醒后返回 false
         if (!cq->Next(&tag, &ok)) break;
-        if (tag) static_cast<AsyncCallContext<AsyncTaskService,Task,TaskResponse>*>(tag)->Proceed(ok);
+        if (tag == &slot->retire_tag) {
+            slot->retire_pending.store(false, std::memory_order_release);
+            if (ok && !shutdown_.load(std::memory_order_acquire)) {
+                {
+                    std::lock_guard<std::mutex> g(slot->exited_mu);
+                    slot->exited.push_back(std::this_thread::get_id());
+                }
+                slot->live_threads.fetch_sub(1, std::memory_order_relaxed);
+                return;                       // 被控制器退役，其余线程继续轮询；由控制器下一轮 join
+            }
+            continue;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        if (tag) static_cast<ServerTag*>(tag)->Proceed(ok);
+        slot->busy_ns.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count(),
+            std::memory_order_relaxed);
     }
     // 排空剩余事件
     while (cq->Next(&tag, &ok)) {
-        if (tag) static_cast<AsyncCallContext<AsyncTaskService,Task,TaskResponse>*>(tag)->Proceed(ok);
+        if (tag && tag != &slot->retire_tag) static_cast<ServerTag*>(tag)->Proceed(ok);
+    }
+    slot->live_threads.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/* ---------- 自适应控制 ---------- */
+void AsyncServer::ControlLoop() {
+    std::unique_lock<std::mutex> lk(ctl_mu_);
+    while (!shutdown_.load(std::memory_order_acquire)) {
+        ctl_cv_.wait_for(lk, limits_.tick, [this] { return shutdown_.load(std::memory_order_acquire); });
+        if (shutdown_.load(std::memory_order_acquire)) break;
+        lk.unlock();
+        ControlTick();
+        lk.lock();
+    }
+}
+
+void AsyncServer::ControlTick() {
+    bool changed = false;
+
+    // 1. 预挂上下文：饥饿就翻倍，连续安静就收缩到峰值的 1.5 倍
+    for (std::size_t i = 0; i < pools_.size(); ++i) {
+        ArmedPool& p = *pools_[i];
+        PoolHistory& h = history_[i];
+        const std::uint64_t starved = p.starved.load(std::memory_order_relaxed);
+        const int peak   = p.busy_peak.exchange(p.busy.load(std::memory_order_relaxed),
+                                                std::memory_order_relaxed);
+        const int target = p.target.load(std::memory_order_relaxed);
+        int next = target;
+        if (starved != h.starved) {
+            next = std::min(h.max, std::max(target + 1, target * 2));
+            h.quiet_ticks = 0;
+        } else if (++h.quiet_ticks >= limits_.shrink_after_ticks) {
+            next = std::max(h.min, std::min(target, peak + peak / 2 + 1));
+            h.quiet_ticks = 0;
+        }
+        h.starved = starved;
+        if (next != target) {
+            p.target.store(next, std::memory_order_relaxed);
+            changed = true;
+        }
+        // 只在目标上调时补足差额；下调的由多出来的上下文在调用结束时自行退役
+        if (next > target) {
+            for (int have = p.live.load(std::memory_order_relaxed); have < next; ++have) p.spawn();
+        }
+    }
+
+    // 2. 轮询线程：按上一周期的忙碌比例增减
+    std::unique_lock<std::mutex> lk(metrics_mu_);
+    const double window_ns = std::chrono::duration<double, std::nano>(limits_.tick).count();
+    for (auto& slot : slots_) {
+        ReapPollThreads(slot.get());
+        const std::uint64_t busy = slot->busy_ns.load(std::memory_order_relaxed);
+        const int threads = slot->live_threads.load(std::memory_order_relaxed);
+        slot->utilization = (busy - slot->last_busy_ns) / (window_ns * std::max(1, threads));
+        slot->last_busy_ns = busy;
+
+        if (slot->utilization > 0.75 && threads < limits_.max_threads_per_cq) {
+            StartPollThread(slot.get());
+            changed = true;
+        } else if (slot->utilization < 0.10 && threads > limits_.min_threads_per_cq &&
+                   !slot->retire_pending.exchange(true, std::memory_order_acq_rel)) {
+            slot->retire_alarm.Set(slot->cq.get(), gpr_now(GPR_CLOCK_MONOTONIC), &slot->retire_tag);
+            changed = true;
+        }
+    }
+
+    lk.unlock();
+
+    if (changed) {
+        auto m = Metrics();
+        LOG(INFO) << "AsyncServer adaptive: contexts=" << m.armed << "/" << m.target
+                  << " poll_threads=" << m.threads;
+    }
+}
+
+ServerMetrics AsyncServer::Metrics() const {
+    std::lock_guard<std::mutex> lk(metrics_mu_);
+    ServerMetrics m;
+    m.cqs.reserve(slots_.size());
+    for (auto& slot : slots_) {
+        ServerMetrics::Cq c;
+        c.threads = slot->live_threads.load(std::memory_order_relaxed);
+        c.utilization = slot->utilization;
+        for (ArmedPool* p : slot->pools) {
+            c.armed    += p->armed.load(std::memory_order_relaxed);
+            c.busy     += p->busy.load(std::memory_order_relaxed);
+            c.target   += p->target.load(std::memory_order_relaxed);
+            c.live     += p->live.load(std::memory_order_relaxed);
+            c.accepted += p->accepted.load(std::memory_order_relaxed);
+            c.starved  += p->starved.load(std::memory_order_relaxed);
+        }
+        m.armed   += c.armed;
+        m.target  += c.target;
+        m.live    += c.live;
+        m.threads += c.threads;
+        m.cqs.push_back(c);
     }
+    return m;
+}
+
+AsyncServer::ResultLog& AsyncServer::LogFor(const std::string& client_id,
+                                            std::shared_lock<std::shared_mutex>& lk) {
+    for (;;) {
+        auto it = logs_.find(client_id);
+        if (it != logs_.end()) return *it->second;
+        lk.unlock();
+        {
+            std::unique_lock<std::shared_mutex> w(subs_mu_);
+            if (!logs_.count(client_id)) {
+                if (logs_.size() >= replay_clients_) EvictLogLocked();
+                auto log = std::make_unique<ResultLog>();
+                log->client_id = client_id;
+                TouchLogLocked(*log);
+                logs_.emplace(client_id, std::move(log));
+            }
+        }
+        lk.lock();                            // 换锁的间隙里可能又被淘汰，重新找
+    }
+}
+
+void AsyncServer::EvictLogLocked() {
+    // 持写锁时没有别人改订阅，idle_ 队首就是最久没动静且没人订阅的
+    ResultLog* victim = nullptr;
+    {
+        std::lock_guard<std::mutex> g(idle_mu_);
+        if (idle_.empty()) return;
+        victim = idle_.front();
+        idle_.pop_front();
+    }
+    logs_.erase(victim->client_id);
+}
+
+void AsyncServer::TouchLogLocked(ResultLog& log) {
+    std::lock_guard<std::mutex> g(idle_mu_);
+    if (!log.subs.empty()) {
+        if (log.idle) idle_.erase(log.idle_pos);
+        log.idle = false;
+    } else if (log.idle) {
+        idle_.splice(idle_.end(), idle_, log.idle_pos);
+    } else {
+        log.idle_pos = idle_.insert(idle_.end(), &log);
+        log.idle = true;
+    }
+}
+
+void AsyncServer::Subscribe(ListenResultsCall* call) {
+    std::shared_lock<std::shared_mutex> lk(subs_mu_);
+    ResultLog& log = LogFor(call->client_id(), lk);
+    std::lock_guard<std::mutex> g(log.mu);
+
+    // 游标之后还在环里的补发；比环还旧的标 gap；比 next_seq 还新（服务端重启过）也标 gap
+    const std::uint64_t oldest = log.next_seq - log.ring.size();
+    std::uint64_t from = log.next_seq;
+    bool gap = false;
+    if (call->resume_after() > 0) {
+        from = call->resume_after() + 1;
+        if (from < oldest) {
+            from = oldest;
+            gap = true;
+        } else if (from > log.next_seq) {
+            from = log.next_seq;
+            gap = true;
+        }
+    }
+    std::vector<std::shared_ptr<const Task>> replay(log.ring.end() - (log.next_seq - from),
+                                                    log.ring.end());
+    call->Begin(from, gap, std::move(replay));
+    log.subs.push_back(call);
+    TouchLogLocked(log);
+}
+
+void AsyncServer::Unsubscribe(ListenResultsCall* call) {
+    std::shared_lock<std::shared_mutex> lk(subs_mu_);
+    auto it = logs_.find(call->client_id());
+    if (it == logs_.end()) return;
+    // 拿日志锁，等正在 Push 的发布者退出
+    std::lock_guard<std::mutex> g(it->second->mu);
+    auto& subs = it->second->subs;
+    subs.erase(std::remove(subs.begin(), subs.end(), call), subs.end());
+    TouchLogLocked(*it->second);
+}
+
+std::size_t AsyncServer::PublishResult(const Task& task) {
+    InvalidateStatus(task.task_id());     // 状态已迁移，缓存里的旧状态作废
+    auto result = std::make_shared<const Task>(task);
+    std::shared_lock<std::shared_mutex> lk(subs_mu_);
+    ResultLog& log = LogFor(task.client_id(), lk);
+    std::lock_guard<std::mutex> g(log.mu);
+    if (log.subs.empty()) TouchLogLocked(log);   // 有订阅的不在 idle_ 里，不用挪
+    ++log.next_seq;
+    log.ring.push_back(result);
+    if (log.ring.size() > replay_ring_) log.ring.pop_front();
+    for (auto* call : log.subs) call->Push(result);
+    return log.subs.size();
+}
+
+std::size_t AsyncServer::SubscriberCount() const {
+    std::shared_lock<std::shared_mutex> lk(subs_mu_);
+    std::size_t n = 0;
+    for (auto& [_, log] : logs_) {
+        std::lock_guard<std::mutex> g(log->mu);
+        n += log->subs.size();
+    }
+    return n;
 }
 
 /* ---------- 业务逻辑 = 普通函数 ---------- */
-void AsyncServer::OnSubmitTask(AsyncCallContext<AsyncTaskService, Task, TaskResponse>* ctx) {
+grpc::Status AsyncServer::OnSubmitTask(SubmitTaskCall* ctx) {
+    if (ctx->request_->idempotency_key().empty()) {
+        RunSubmit(ctx);
+        return grpc::Status::OK;
+    }
+
+    // 客户端重试带同一个 key：窗口内见过的直接回第一次的结果
+    const std::string key = ctx->request_->idempotency_key();
+    std::shared_ptr<IdemFlight> flight;
+    std::shared_ptr<const TaskResponse> seen;
+    {
+        std::lock_guard<std::mutex> lk(idem_mu_);
+        const auto now = std::chrono::steady_clock::now();
+        while (!idem_order_.empty() && (idem_order_.front().at <= now || idem_.size() > idem_max_)) {
+            const IdemExpiry& old = idem_order_.front();
+            if (auto it = idem_.find(old.key); it != idem_.end() && it->second.get() == old.flight)
+                idem_.erase(it);              // 执行中被挤出的条目由执行方持有，等待者照样收到回包
+            idem_order_.pop_front();
+        }
+        auto [it, fresh] = idem_.try_emplace(key);
+        if (fresh) {
+            flight = it->second = std::make_shared<IdemFlight>();
+            idem_order_.push_back(IdemExpiry{now + idem_ttl_, key, flight.get()});
+        } else if (it->second->response) {
+            seen = it->second->response;
+        } else {
+            ctx->Defer();                     // 第一次还在执行：不在这里等，由执行方回包
+            it->second->waiters.push_back(ctx);
+            return grpc::Status::OK;
+        }
+    }
+    if (seen) {
+        ctx->response_->CopyFrom(*seen);
+        return grpc::Status::OK;
+    }
+
+    grpc::Status st;
+    try {
+        RunSubmit(ctx);
+    } catch (const std::exception& ex) {
+        st = grpc::Status(grpc::StatusCode::INTERNAL, ex.what());
+    } catch (...) {
+        st = grpc::Status(grpc::StatusCode::INTERNAL, "submit handler failed");
+    }
+    std::shared_ptr<TaskResponse> copy;
+    if (st.ok()) {
+        copy = std::make_shared<TaskResponse>();
+        copy->CopyFrom(*ctx->response_);
+    }
+    std::vector<SubmitTaskCall*> waiters;
+    {
+        std::lock_guard<std::mutex> lk(idem_mu_);
+        waiters.swap(flight->waiters);
+        if (st.ok()) {
+            flight->response = copy;
+        } else if (auto it = idem_.find(key); it != idem_.end() && it->second == flight) {
+            idem_.erase(it);                  // 失败不占着 key，客户端重试时重新执行
+        }
+    }
+    // 等着的重复请求：成功拿同一份回包；失败回 ABORTED，客户端按重试策略再发
+    const grpc::Status retry(grpc::StatusCode::ABORTED, "first attempt with this idempotency key failed");
+    for (auto* w : waiters) {
+        if (st.ok()) w->response_->CopyFrom(*copy);
+        w->Reply(st.ok() ? st : retry);
+    }
+    return st;
+}
+
+void AsyncServer::RunSubmit(SubmitTaskCall* ctx) {
     // 用户注册的高性能回调（无状态机噪音）
-    ctx->response_.mutable_task()->CopyFrom(ctx->request_);
-    ctx->response_.mutable_task()->set_state(dts::proto::SUCCESS);
+    if (submit_task_) {
+        submit_task_(ctx->request_, ctx->response_);
+        return;
+    }
+    // 默认回显：请求与回包同在一个 arena 上，Swap 只交换指针，附件不会被复制
+    ctx->response_->mutable_task()->Swap(ctx->request_);
+    ctx->response_->mutable_task()->set_state(dts::proto::SUCCESS);
+}
+
+grpc::Status AsyncServer::OnCancelTask(CancelTaskCall* ctx) {
+    if (cancel_task_) return cancel_task_(*ctx->request_, ctx->response_);
+    ctx->response_->set_success(false);
+    return grpc::Status::OK;
+}
+
+grpc::Status AsyncServer::OnQueryStatus(QueryStatusCall* ctx) {
+    if (query_status_ && status_cache_) {
+        // 合并到别人的加载上时不在这里等：由取回结果的线程回包
+        const QueryRequest& req = *ctx->request_;
+        ctx->Defer();
+        status_cache_->Get(req.task_id(), [&](Task* out) { return query_status_(req, out); },
+                           [ctx](const grpc::Status& st, const Task& task) {
+                               if (st.ok()) ctx->response_->CopyFrom(task);
+                               ctx->Reply(st);
+                           });
+        return grpc::Status::OK;
+    }
+    if (query_status_) return query_status_(*ctx->request_, ctx->response_);
+    return grpc::Status(grpc::StatusCode::NOT_FOUND, "no query backend");
+}
+
+void AsyncServer::OnSubmitBatch(const TaskBatch& batch, BatchAck* ack) {
+    if (submit_batch_) {
+        submit_batch_(batch, ack);
+        return;
+    }
+    ack->mutable_acks()->Reserve(batch.tasks_size());
+    for (const auto& t : batch.tasks()) {
+        auto* a = ack->add_acks();
+        a->set_task_id(t.task_id());
+        a->set_state(dts::proto::SUCCESS);
+    }
 }
 
 } // namespace dts
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "status_cache.hpp"
+#include <algorithm>
+
+namespace dts {
+
+StatusCache::StatusCache(const StatusCacheOptions& opts) : opts_(opts) {
+    opts_.shards = std::max<std::size_t>(1, opts_.shards);
+    opts_.max_entries_per_shard = std::max<std::size_t>(1, opts_.max_entries_per_shard);
+    shards_.reserve(opts_.shards);
+    for (std::size_t i = 0; i < opts_.shards; ++i) shards_.push_back(std::make_unique<Shard>());
+}
+
+StatusCache::Shard& StatusCache::ShardFor(const std::string& task_id) {
+    return *shards_[std::hash<std::string>{}(task_id) % shards_.size()];
+}
+
+void StatusCache::Get(const std::string& task_id, const Loader& loader, Done done) {
+    Shard& shard = ShardFor(task_id);
+    std::shared_ptr<const Result> hit;
+    std::shared_ptr<Flight> flight;
+    {
+        std::lock_guard<std::mutex> lk(shard.mu);
+        const auto now = Clock::now();
+        auto it = shard.map.find(task_id);
+        if (it != shard.map.end() && it->second.value && it->second.expires > now) {
+            hit = it->second.value;
+        } else if (it != shard.map.end() && it->second.flight) {
+            // 挂到进行中的那次加载上，不等
+            it->second.flight->waiters.push_back(std::move(done));
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            if (it == shard.map.end()) {
+                if (shard.map.size() >= opts_.max_entries_per_shard) Trim(shard, now);
+                it = shard.map.emplace(task_id, Entry{}).first;
+            }
+            it->second.value.reset();
+            flight = it->second.flight = std::make_shared<Flight>();
+        }
+    }
+    if (hit) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        done(hit->status, hit->task);
+        return;
+    }
+
+    // 由本线程去后端取，同 key 的后来者都挂在 flight 上
+    loads_.fetch_add(1, std::memory_order_relaxed);
+    auto r = std::make_shared<Result>();
+    try {
+        r->status = loader(&r->task);
+    } catch (const std::exception& ex) {
+        r->status = grpc::Status(grpc::StatusCode::INTERNAL, ex.what());
+    } catch (...) {
+        r->status = grpc::Status(grpc::StatusCode::INTERNAL, "status loader failed");
+    }
+    std::vector<Done> waiters;
+    {
+        std::lock_guard<std::mutex> lk(shard.mu);
+        waiters.swap(flight->waiters);
+        auto it = shard.map.find(task_id);
+        // 加载期间被失效过的结果可能已过时：只交给已在等的请求，不入缓存，
+        // 条目也可能已被失效后的新一轮加载占用，不动它
+        if (it != shard.map.end() && it->second.flight == flight) {
+            Entry& e = it->second;
+            e.flight.reset();
+            if (r->status.ok()) {
+                e.value   = r;
+                e.expires = Clock::now() + opts_.ttl;
+            } else {
+                shard.map.erase(it);
+            }
+        }
+    }
+    done(r->status, r->task);
+    for (auto& w : waiters) w(r->status, r->task);
+}
+
+grpc::Status StatusCache::Get(const std::string& task_id, proto::Task* out, const Loader& loader) {
+    std::promise<grpc::Status> ready;
+    auto result = ready.get_future();
+    Get(task_id, loader, [&](const grpc::Status& status, const proto::Task& task) {
+        if (status.ok()) out->CopyFrom(task);
+        ready.set_value(status);
+    });
+    return result.get();
+}
+
+void StatusCache::Invalidate(const std::string& task_id) {
+    Shard& shard = ShardFor(task_id);
+    std::lock_guard<std::mutex> lk(shard.mu);
+    auto it = shard.map.find(task_id);
+    if (it == shard.map.end()) return;
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+    if (it->second.flight) {
+        // 之后的查询重新去后端取，不再挂到失效前发出的那次加载上
+        it->second.value.reset();
+        it->second.flight.reset();
+    } else {
+        shard.map.erase(it);
+    }
+}
+
+void StatusCache::Trim(Shard& shard, Clock::time_point now) {
+    // 先清过期的；还满就随便丢掉一半空闲条目，正在加载的保留
+    std::erase_if(shard.map, [now](const auto& kv) {
+        return !kv.second.flight && kv.second.expires <= now;
+    });
+    if (shard.map.size() < opts_.max_entries_per_shard) return;
+    std::size_t drop = shard.map.size() / 2;
+    for (auto it = shard.map.begin(); it != shard.map.end() && drop > 0;) {
+        if (it->second.flight) {
+            ++it;
+        } else {
+            it = shard.map.erase(it);
+            --drop;
+        }
+    }
+}
+
+StatusCache::Stats StatusCache::stats() const {
+    return {hits_.load(std::memory_order_relaxed), loads_.load(std::memory_order_relaxed),
+            coalesced_.load(std::memory_order_relaxed), invalidations_.load(std::memory_order_relaxed)};
+}
+
+} // namespace dts
@@ -0,0 +1,76 @@
+// arena_pool.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <google/protobuf/arena.h>
+
+namespace dts {
+
+// 可复用的 Arena：自带首块内存，Reset 之后首块保留，下一次分配只需指针推进
+class ReusableArena {
+public:
+    explicit ReusableArena(std::size_t initial_block_size);
+
+    ReusableArena(const ReusableArena&) = delete;
+    ReusableArena& operator=(const ReusableArena&) = delete;
+
+    google::protobuf::Arena* get() noexcept { return &arena_; }
+
+    // 释放首块之外的所有内存，并析构挂在 arena 上的消息
+    void Reset() { arena_.Reset(); }
+
+private:
+    static google::protobuf::ArenaOptions MakeOptions(char* block, std::size_t size);
+
+    std::unique_ptr<char[]> block_;
+    google::protobuf::Arena arena_;
+};
+
+// 每线程 Arena 池：Acquire 取出一个 arena，Handle 析构时 Reset 并放回当前线程的空闲表
+class ArenaPool {
+public:
+    static constexpr std::size_t kInitialBlockSize   = 8 * 1024;
+    static constexpr std::size_t kMaxCachedPerThread = 64;
+
+    // RAII 句柄，只能移动
+    class Handle {
+    public:
+        Handle() = default;
+        explicit Handle(ReusableArena* arena) noexcept : arena_(arena) {}
+        ~Handle() { reset(); }
+
+        Handle(Handle&& other) noexcept : arena_(other.arena_) { other.arena_ = nullptr; }
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                arena_ = other.arena_;
+                other.arena_ = nullptr;
+            }
+            return *this;
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        google::protobuf::Arena* get() const noexcept {
+            return arena_ ? arena_->get() : nullptr;
+        }
+        explicit operator bool() const noexcept { return arena_ != nullptr; }
+
+        // 归还给当前线程的池（可以与 Acquire 不在同一线程）
+        void reset();
+
+    private:
+        ReusableArena* arena_ = nullptr;
+    };
+
+    static Handle Acquire();
+
+    // 当前线程缓存的空闲 arena 数（测试/监控用）
+    static std::size_t CachedOnThisThread();
+
+private:
+    static void Release(ReusableArena* arena);
+};
+
+} // namespace dts
@@ -0,0 +1,169 @@
+// callback_client.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/client_callback.h>
+#include "grpc_client.hpp"
+
+namespace dts {
+
+// 基于 gRPC callback API 的客户端：没有自己的 CQ 线程，完成通知直接在 gRPC 内部线程上回调。
+// 两种用法：
+//   1. 完成令牌：submit(task, [](Task&&, grpc::Status) {...})，每次调用一个对象、没有 promise/future；
+//   2. 调用方自备的调用对象（SubmitCall/ListenCall）：由调用方持有并反复使用，
+//      请求/响应消息、字段缓冲与反应器都跨调用复用，每次提交只就地重建 ClientContext，不走堆分配。
+// 回调跑在 gRPC 线程上，不能阻塞；ClientOptions 里只有连接池与通道参数生效。
+
+// 可复用的提交调用：填 request()、交给 CallbackClient::Start，完成后可以再次 Start。
+// 请求/响应消息和反应器跨调用复用；ClientContext 不能复用，每次 Start 在原地 emplace 一个新的。
+// OnComplete 里再次 Start 时先只做记号，等 OnComplete 返回、gRPC 不再碰这次调用后才发起下一次
+class SubmitCall {
+public:
+    virtual ~SubmitCall() = default;
+
+    PbTask& request() { return request_; }
+    TaskResponse& response() { return response_; }
+    // 每次调用的超时（0 = 不设），Start 时套到新建的 ClientContext 上
+    void set_timeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+
+protected:
+    // 在 gRPC 线程上调用；可以在这里直接再次 Start。没有再次 Start 时，返回后不再碰本对象，
+    // 由别的线程等到完成通知后即可销毁
+    virtual void OnComplete(const grpc::Status& status) = 0;
+
+private:
+    friend class CallbackClient;
+
+    // 随调用对象常驻；gRPC 在回调 OnDone 之前已经释放这次调用，之后可以绑定下一次
+    class Reactor final : public grpc::ClientUnaryReactor {
+    public:
+        explicit Reactor(SubmitCall* owner) : owner_(owner) {}
+
+        std::optional<grpc::ClientContext> context;
+
+        void OnDone(const grpc::Status& status) override;
+
+    private:
+        SubmitCall* owner_;
+    };
+
+    PbTask                    request_;
+    TaskResponse              response_;
+    std::chrono::milliseconds timeout_{0};
+    Reactor                   reactor_{this};
+};
+
+// 结果订阅反应器：每条结果回调一次 OnResult，流结束（含 Cancel）回调一次 OnClosed。
+// 一次性使用；断线后新建一个，用 cursor() 作为 Listen 的 resume_after 续传
+class ListenCall : public grpc::ClientReadReactor<TaskResult> {
+public:
+    void Cancel() { context_.TryCancel(); }
+    // 已交付的最大结果序号；在 OnClosed 之后读取
+    std::uint64_t cursor() const { return cursor_; }
+
+protected:
+    virtual void OnResult(Task&& task) = 0;
+    // 游标之后有结果已滚出服务端回放环，first_seq 之前的需要自行查询补齐
+    virtual void OnGap(std::uint64_t first_seq) { (void)first_seq; }
+    virtual void OnClosed(const grpc::Status& status) = 0;
+
+private:
+    friend class CallbackClient;
+    void OnReadDone(bool ok) final;
+    void OnDone(const grpc::Status& status) final { OnClosed(status); }
+
+    grpc::ClientContext context_;
+    SubscribeRequest    request_;
+    TaskResult          message_;
+    std::uint64_t       cursor_ = 0;
+};
+
+namespace detail {
+
+inline Task Deliver(TaskResponse& r) { return TaskFromProto(std::move(*r.mutable_task())); }
+inline Task Deliver(PbTask& r) { return TaskFromProto(std::move(r)); }
+inline bool Deliver(CancelResponse& r) { return r.success(); }
+
+// 完成令牌版的一元调用：请求/响应/上下文与令牌同在一个对象里，OnDone 里交付并自毁
+template <class Request, class Response, class Token>
+class TokenCall final : public grpc::ClientUnaryReactor {
+public:
+    template <class T>
+    explicit TokenCall(T&& token) : token_(std::forward<T>(token)) {}
+
+    grpc::ClientContext context;
+    Request             request;
+    Response            response;
+
+    void OnDone(const grpc::Status& status) override {
+        using Result = decltype(Deliver(response));
+        token_(status.ok() ? Deliver(response) : Result{}, status);
+        delete this;
+    }
+
+private:
+    Token token_;
+};
+
+} // namespace detail
+
+class CallbackClient {
+public:
+    explicit CallbackClient(const std::string& target, const ClientOptions& options = {});
+
+    // ---- 完成令牌：token(Task&& / bool, grpc::Status)，在 gRPC 线程上调用 ----
+    template <class Token>
+    void submit(Task task, Token&& token) {
+        auto* call = new detail::TokenCall<PbTask, TaskResponse, std::decay_t<Token>>(
+            std::forward<Token>(token));
+        TaskToProto(std::move(task), &call->request);
+        NextStub().async()->SubmitTask(&call->context, &call->request, &call->response, call);
+        call->StartCall();
+    }
+
+    template <class Token>
+    void query_status(const std::string& task_id, Token&& token) {
+        auto* call = new detail::TokenCall<QueryRequest, PbTask, std::decay_t<Token>>(
+            std::forward<Token>(token));
+        call->request.set_task_id(task_id);
+        NextStub().async()->QueryStatus(&call->context, &call->request, &call->response, call);
+        call->StartCall();
+    }
+
+    template <class Token>
+    void cancel_task(const std::string& task_id, Token&& token) {
+        auto* call = new detail::TokenCall<CancelRequest, CancelResponse, std::decay_t<Token>>(
+            std::forward<Token>(token));
+        call->request.set_task_id(task_id);
+        NextStub().async()->CancelTask(&call->context, &call->request, &call->response, call);
+        call->StartCall();
+    }
+
+    // ---- 调用方自备反应器 ----
+    // 发起一次提交；同一个 call 上一次调用的 OnComplete 之前不能再次 Start（OnComplete 里可以）
+    void Start(SubmitCall* call);
+    // 开始订阅；call 在 OnClosed 之前必须存活，提前结束用 call->Cancel()
+    void Listen(ListenCall* call, const std::string& client_id, std::uint64_t resume_after = 0);
+
+    std::size_t channel_count() const { return stubs_.size(); }
+
+private:
+    friend class SubmitCall;
+
+    void Launch(SubmitCall* call);
+    TaskService::Stub& NextStub() {
+        return *stubs_[next_.fetch_add(1, std::memory_order_relaxed) % stubs_.size()];
+    }
+
+    std::vector<std::unique_ptr<TaskService::Stub>> stubs_;
+    std::atomic<std::size_t> next_{0};
+};
+
+} // namespace dts
@@ -2,17 +2,27 @@
 #include "task.pb.h"
 #include "task.grpc.pb.h"
 #include <grpcpp/grpcpp.h>
+#include <grpcpp/alarm.h>
 #include <grpcpp/create_channel.h>
 #include <grpcpp/client_context.h>
 #include <grpcpp/support/async_stream.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <optional>
 #include <future>
 #include <memory>
 #include <atomic>
 #include <functional>
 #include "thread_pool.hpp"
+#include "arena_pool.hpp"
 #include "task.hpp"
 #include "utils.hpp"
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 namespace dts {
 
@@ -25,6 +35,8 @@ using QueryRequest = ::dts::proto::QueryRequest;
 using SubscribeRequest = ::dts::proto::SubscribeRequest;
 using TaskResult = ::dts::proto::TaskResult;
 using TaskService = ::dts::proto::TaskService;
+using TaskBatch = ::dts::proto::TaskBatch;
+using BatchAck = ::dts::proto::BatchAck;
 
 class GrpcClient;
 using Callback = std::function<void(const Task& result, grpc::Status status)>;
@@ -41,10 +53,43 @@ private:
 
 // ---------- 异步上下文 ----------
 
-struct IAsyncTag { 
-    virtual ~IAsyncTag() = default;
-    grpc::Status status;
+struct IAsyncTag;
+
+// 存活调用表：客户端析构时据此取消还没结束的调用（主要是监听流），CQ 才能排空
+struct CallRegistry {
+    std::mutex mu;
+    std::condition_variable drained;      // live 变空时通知
+    std::unordered_set<IAsyncTag*> live;
+    bool closing = false;                 // 析构已开始：内部重试/对冲不再发起新调用
+};
+
+// CQ 上的事件目标：CQ 线程把取到的 tag 都当作它来分发
+struct CqTag {
+    virtual ~CqTag() = default;
     virtual void Proceed(bool ok) = 0;
+};
+
+// 一次 RPC 调用：带 ClientContext、最终状态和所在通道的计数
+struct IAsyncTag : CqTag {
+    virtual ~IAsyncTag() {
+        Unregister();
+        if (load) load->fetch_sub(1, std::memory_order_relaxed);
+    }
+    // 客户端析构时调用（持 registry 锁）：让这个 tag 尽快走到终态
+    virtual void Abort() { context.TryCancel(); }
+    // 覆盖了 Abort 的派生类要在自己的析构函数开头调用，免得 Abort 碰到已析构的成员
+    void Unregister() {
+        if (!registry) return;
+        std::lock_guard<std::mutex> lk(registry->mu);
+        registry->live.erase(this);
+        if (registry->live.empty()) registry->drained.notify_all();
+        registry = nullptr;
+    }
+    grpc::Status status;
+    // 放在基类里：最后析构，派生类的 reader/stream 析构时 call 仍然有效
+    grpc::ClientContext context;
+    std::atomic<int>* load = nullptr;     // 所在通道的在途计数，调用结束（tag 析构）时归还
+    CallRegistry* registry = nullptr;
     virtual void ProceedImpl(bool ok) = 0;
  };
 
@@ -57,46 +102,102 @@ protected:
     ~AsyncTagBase() = default; 
 };
 
+// 重试策略：只重试 retry_on 里的状态码；退避 = min(max, initial * multiplier^(n-1))，再乘 1 ± jitter。
+// 所有尝试共用一个截止时间，截止时间内放不下下一次退避就不再重试。
+struct RetryPolicy {
+    int max_attempts = 3;                 // 含第一次；1 = 不重试
+    std::chrono::milliseconds initial_backoff{50};
+    std::chrono::milliseconds max_backoff{1'000};
+    double multiplier = 2.0;
+    double jitter = 0.2;
+    std::vector<grpc::StatusCode> retry_on{grpc::StatusCode::UNAVAILABLE,
+                                           grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                           grpc::StatusCode::ABORTED};
+
+    bool Retryable(grpc::StatusCode code) const {
+        return std::find(retry_on.begin(), retry_on.end(), code) != retry_on.end();
+    }
+    // 第 attempt 次失败之后的等待时间
+    std::chrono::milliseconds Backoff(int attempt) const;
+};
+
+// QueryStatus 对冲：第一次发出后过了 delay 还没回包，就换一条通道再发一次，先回来的赢。
+// delay 取最近查询延迟的 quantile 分位（样本不足时用 initial_delay）。
+// 某次尝试以 non_fatal 里的状态码失败时不作数，等其余尝试；其它错误直接作为结果。
+struct HedgePolicy {
+    int max_attempts = 1;                 // 含第一次；1 = 不对冲
+    double quantile = 0.95;
+    std::chrono::milliseconds initial_delay{50};
+    std::chrono::milliseconds min_delay{1};
+    std::vector<grpc::StatusCode> non_fatal{grpc::StatusCode::UNAVAILABLE,
+                                            grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                            grpc::StatusCode::ABORTED};
+
+    bool NonFatal(grpc::StatusCode code) const {
+        return std::find(non_fatal.begin(), non_fatal.end(), code) != non_fatal.end();
+    }
+};
+
+// 单次调用的覆盖项；零值/空值表示沿用 ClientOptions
+struct CallOptions {
+    std::chrono::milliseconds timeout{0};
+    std::optional<RetryPolicy> retry;
+};
+
+// 最近 N 次调用延迟的环形窗口，分位数按需现算
+class LatencyWindow {
+public:
+    static constexpr std::size_t kSize = 256;
+    void Record(std::chrono::steady_clock::duration d);
+    // 样本不足 32 个时返回 fallback
+    std::chrono::microseconds Quantile(double q, std::chrono::microseconds fallback) const;
+
+private:
+    std::array<std::atomic<std::uint32_t>, kSize> us_{};
+    std::atomic<std::size_t> count_{0};
+};
+
 struct AsyncSubmitTag : AsyncTagBase<AsyncSubmitTag> {
-    explicit AsyncSubmitTag(std::shared_ptr<std::promise<Task>> p,
-                            Callback cb = {})
-        : promise(std::move(p)), callback(std::move(cb)) {}
-    void ProceedImpl(bool ok) {
-        switch (step_) {
-        case kLaunch:
-            if (!ok) {
-                status = grpc::Status(grpc::StatusCode::INTERNAL, "StartCall failed");
-                step_ = kFinish;          // 直接跳到结束
-            } else {
-                step_ = kFinish;
-            }
-            // 无论 ok 与否都调 Finish，让 gRPC 再回包一次
-            reader->Finish(&response, &status, this);
-            break;
+    AsyncSubmitTag(GrpcClient* c, std::shared_ptr<std::promise<Task>> p, Callback cb = {})
+        : client(c), promise(std::move(p)), callback(std::move(cb)) {}
+    ~AsyncSubmitTag() override { Unregister(); }
 
-        case kFinish:
-            if (!ok) {
-                // Finish 本身失败，覆盖 status
-                status = grpc::Status(grpc::StatusCode::INTERNAL, "Finish cq !ok");
-            }
-            SetResult();
-            delete this;
-            break;
-        }
+    void ProceedImpl(bool ok) override;   // 需要回调 GrpcClient 发起重试，实现在 .cpp
+    void Abort() override {
+        context.TryCancel();
+        if (backoff_pending.load(std::memory_order_acquire)) alarm.Cancel();
     }
-    enum Step { kLaunch, kFinish } step_{kLaunch};
-    TaskResponse response;
+
+    // kBackoff：在 alarm 上等重试；kFinish：调用已发出，等回包
+    enum Step { kBackoff, kFinish } step_{kFinish};
+    GrpcClient* client;
+    grpc::CompletionQueue* cq = nullptr;  // 重试的 alarm 和调用都挂在同一个 CQ 上
+    int attempt = 1;
+    RetryPolicy retry;
+    std::optional<std::chrono::system_clock::time_point> deadline;
+    grpc::Alarm alarm;
+    std::atomic<bool> backoff_pending{false};
+
+    // 请求/响应都挂在本次调用的 arena 上，tag 析构时整块 Reset 归还
+    ArenaPool::Handle arena = ArenaPool::Acquire();
+    PbTask* request = nullptr;
+    TaskResponse* response =
+        google::protobuf::Arena::CreateMessage<TaskResponse>(arena.get());
     std::unique_ptr<grpc::ClientAsyncResponseReader<TaskResponse>> reader;
-    grpc::ClientContext context;
     std::shared_ptr<std::promise<Task>> promise;
     Callback callback;
 
     void SetResult() {
         std::call_once(once_, [&] {
             if (status.ok()) {
-                Task task = TaskFromProto(response.task());
-                promise->set_value(std::move(task));
-                if (callback) callback(task, status);
+                // 附件缓冲区直接从回包里接管
+                Task task = TaskFromProto(std::move(*response->mutable_task()));
+                if (callback) {
+                    promise->set_value(task);     // 回调还要用，不能 move 走
+                    callback(task, status);
+                } else {
+                    promise->set_value(std::move(task));
+                }
             } else {
                 promise->set_exception(std::make_exception_ptr(GrpcError(status)));
                 if (callback) callback(Task{}, status);
@@ -126,7 +227,6 @@ struct AsyncCancelTag  : AsyncTagBase<AsyncCancelTag> {
     CancelResponse response;
     std::promise<bool> promise;
     std::unique_ptr<grpc::ClientAsyncResponseReader<CancelResponse>> reader;
-    grpc::ClientContext context;
 };
 
 struct AsyncQueryTag   : AsyncTagBase<AsyncQueryTag> {
@@ -134,7 +234,7 @@ struct AsyncQueryTag   : AsyncTagBase<AsyncQueryTag> {
     void ProceedImpl(bool ok) {
         if (step_ == kLaunch && ok) {
             step_ = kFinish;
-            reader->Finish(&response, &status, this);
+            reader->Finish(response, &status, this);
             return;
         }
         if (!ok && step_ == kLaunch) status = grpc::Status(grpc::StatusCode::INTERNAL, "cq !ok");
@@ -143,16 +243,18 @@ struct AsyncQueryTag   : AsyncTagBase<AsyncQueryTag> {
     }
 
     enum Step { kLaunch, kFinish } step_{kLaunch};
-    QueryRequest request;
-    PbTask response;
+    ArenaPool::Handle arena = ArenaPool::Acquire();
+    QueryRequest* request =
+        google::protobuf::Arena::CreateMessage<QueryRequest>(arena.get());
+    PbTask* response =
+        google::protobuf::Arena::CreateMessage<PbTask>(arena.get());
     std::promise<Task> promise;
     std::unique_ptr<grpc::ClientAsyncResponseReader<PbTask>> reader;
-    grpc::ClientContext context;
 
     void SetResult() {
         std::call_once(once_, [&] {
             if (status.ok()) {
-                Task task = TaskFromProto(response);
+                Task task = TaskFromProto(std::move(*response));
                 promise.set_value(std::move(task));
             } else {
                 promise.set_exception(std::make_exception_ptr(GrpcError(status)));
@@ -164,102 +266,304 @@ private:
     std::once_flag once_;
 };
 
+// 对冲查询：本 tag 自己是对冲定时器的 tag，每次尝试是一个子 tag。
+// 定时器和所有尝试挂在同一个 CQ 上，事件都在同一个线程处理，状态不需要加锁。
+struct AsyncHedgedQueryTag : AsyncTagBase<AsyncHedgedQueryTag> {
+    struct Attempt : AsyncTagBase<Attempt> {
+        explicit Attempt(AsyncHedgedQueryTag* o) : owner(o) {}
+        void ProceedImpl(bool ok) override { owner->OnAttemptDone(this, ok); }
+
+        AsyncHedgedQueryTag* owner;
+        PbTask response;
+        std::unique_ptr<grpc::ClientAsyncResponseReader<PbTask>> reader;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    AsyncHedgedQueryTag(GrpcClient* c, grpc::CompletionQueue* q) : client(c), cq(q) {}
+    ~AsyncHedgedQueryTag() override { Unregister(); }
+
+    void ProceedImpl(bool ok) override;   // 对冲定时器到点
+    void OnAttemptDone(Attempt* a, bool ok);
+    // 各次尝试自己在存活表里，由客户端逐个取消；这里只需停掉定时器
+    void Abort() override {
+        if (timer_pending.load(std::memory_order_acquire)) timer.Cancel();
+    }
+    void MaybeDelete() {
+        if (done && outstanding == 0 && !timer_pending.load(std::memory_order_acquire)) delete this;
+    }
+
+    GrpcClient* client;
+    grpc::CompletionQueue* cq;
+    QueryRequest request;
+    HedgePolicy policy;
+    std::chrono::milliseconds delay{0};
+    std::optional<std::chrono::system_clock::time_point> deadline;
+    std::promise<Task> promise;
+
+    grpc::Alarm timer;
+    std::atomic<bool> timer_pending{false};
+    std::vector<std::unique_ptr<Attempt>> attempts;
+    int outstanding = 0;
+    bool done = false;
+};
+
+// 结果订阅流。流以 retry_on 里的状态码断开时，按 ClientOptions::retry 退避后带上游标重连，
+// 服务端从回放环补发，回调看到的结果不重不漏；连续失败次数在收到消息后清零。
+// 游标已滚出回放环时回调一次 DATA_LOSS（流照常继续）；放弃重连或被取消时以最终状态回调一次。
 struct AsyncListenTag : AsyncTagBase<AsyncListenTag> {
-    enum Step { kStart = 0, kRead, kFinish, kDone };
+    enum Step { kBackoff, kStart, kRead, kFinish, kDone };
+
+    AsyncListenTag(GrpcClient* c, Callback cb) : client(c), callback(std::move(cb)) {}
+    ~AsyncListenTag() override { Unregister(); }
+
+    void ProceedImpl(bool ok) override;   // 需要回调 GrpcClient 重连，实现在 .cpp
+    void Abort() override {
+        context.TryCancel();
+        if (backoff_pending.load(std::memory_order_acquire)) alarm.Cancel();
+    }
+
+    /* 统一入口：任何路径想结束流，都调到这儿 */
+    void TransitionToFinish() {
+        step_ = kFinish;
+        reader->Finish(&status, this);   // 恰好一次 Finish
+    }
+
+    GrpcClient* client;
+    grpc::CompletionQueue* cq = nullptr;
+    Callback callback;
+    SubscribeRequest request;
+    TaskResult response;
+    std::unique_ptr<grpc::ClientAsyncReader<TaskResult>> reader;
+    std::uint64_t cursor = 0;             // 已交付的最大序号
+    int failures = 0;                     // 连续重连失败次数
+    grpc::Alarm alarm;
+    std::atomic<bool> backoff_pending{false};
+    Step step_ = kStart;
+};
 
-    explicit AsyncListenTag(Callback cb)
-        : callback(std::move(cb)), step_(kStart) {}
+// 批量提交：一条双向流，写方向按批发送，读方向同时收 ack。
+// 读、写各挂一个操作，所以读方向用一个内嵌 tag；两边都结束后才 Finish。
+// 所有事件都在同一个 CQ 线程上处理，状态不需要加锁。
+struct AsyncBatchTag : AsyncTagBase<AsyncBatchTag> {
+    // 读方向的事件目标，不是独立的调用：不带自己的 ClientContext
+    struct ReadTag : CqTag {
+        explicit ReadTag(AsyncBatchTag* o) : owner(o) {}
+        void Proceed(bool ok) override { owner->OnRead(ok); }
+        AsyncBatchTag* owner;
+    };
+
+    AsyncBatchTag(std::vector<Task> t, std::size_t per_batch)
+        : tasks(std::move(t)), batch_size(per_batch ? per_batch : 1), read_tag(this) {
+        acks.reserve(tasks.size());
+    }
 
     void ProceedImpl(bool ok) override {
         switch (step_) {
-        /* ----------------------------------
-         * 0. 启动：StartCall() 完成后第一次 Proceed
-         * ---------------------------------- */
         case kStart:
-            if (!ok) {                    // 连建立就失败
-                TransitionToFinish(grpc::StatusCode::CANCELLED);
+            if (!ok) {                        // 流都没建起来，读写两侧都不会再有事件
+                write_done = read_done = true;
+                MaybeFinish();
                 return;
             }
-            step_ = kRead;                // 正常建立，开始读
-            reader->Read(&response, this);
+            stream->Read(&ack, &read_tag);
+            WriteNext();
             return;
-
-        /* ----------------------------------
-         * 1. 读消息：ok==true  读到一条
-         *            ok==false 对端半关 / 网络出错
-         * ---------------------------------- */
-        case kRead:
-            if (!ok) {                    // 早退
-                TransitionToFinish(grpc::StatusCode::CANCELLED);
+        case kWrite:
+            if (!ok) {                        // 对端已关闭，剩下的不再写
+                write_done = true;
+                MaybeFinish();
                 return;
             }
-            if (response.has_task()) {    // 正常业务数据
-                Task task = TaskFromProto(response.task());
-                if (callback) callback(task, grpc::Status::OK);
-                response.Clear();
-                reader->Read(&response, this);   // 继续读下一条
-                return;
+            WriteNext();
+            return;
+        case kWritesDone:
+            write_done = true;
+            MaybeFinish();
+            return;
+        case kFinish:
+            if (status.ok() && acks.size() != tasks.size()) {
+                status = grpc::Status(grpc::StatusCode::DATA_LOSS, "missing batch acks");
             }
-            // response 没有 task → 服务端发 EOF
-            TransitionToFinish(grpc::StatusCode::OK);
+            if (status.ok()) promise.set_value(std::move(acks));
+            else promise.set_exception(std::make_exception_ptr(GrpcError(status)));
+            delete this;
             return;
+        }
+    }
 
-        /* ----------------------------------
-         * 2. Finish 回调：拿到最终状态
-         * ---------------------------------- */
-        case kFinish:
-            step_ = kDone;
-            if (callback && !status.ok())   // 把最终错误带给用户
-                callback(Task{}, status);
-            delete this;                    // 唯一 suicide 点
+    // 把下一批搬进复用的 TaskBatch；最后一批用 WriteLast 顺带半关写方向
+    void WriteNext() {
+        if (next >= tasks.size()) {
+            step_ = kWritesDone;
+            stream->WritesDone(this);
             return;
+        }
+        const std::size_t end = std::min(tasks.size(), next + batch_size);
+        out.Clear();
+        out.set_batch_id(batch_id++);
+        out.mutable_tasks()->Reserve(static_cast<int>(end - next));
+        for (; next < end; ++next) TaskToProto(std::move(tasks[next]), out.add_tasks());
+        if (next == tasks.size()) {
+            step_ = kWritesDone;              // WriteLast 完成即写方向结束
+            stream->WriteLast(out, grpc::WriteOptions(), this);
+        } else {
+            step_ = kWrite;
+            stream->Write(out, this);
+        }
+    }
 
-        /* ----------------------------------
-         * 3. 终态：永远不会走到
-         * ---------------------------------- */
-        case kDone:
-            GPR_ASSERT(false);
+    void OnRead(bool ok) {
+        if (!ok) {
+            read_done = true;
+            MaybeFinish();
+            return;
         }
+        for (auto& a : *ack.mutable_acks()) {
+            acks.push_back(SubmitAck{std::move(*a.mutable_task_id()),
+                                     static_cast<TaskState>(a.state()),
+                                     std::move(*a.mutable_error_msg())});
+        }
+        ack.Clear();
+        stream->Read(&ack, &read_tag);
     }
 
-    /* 统一入口：任何路径想结束流，都调到这儿 */
-    void TransitionToFinish(grpc::StatusCode code) {
+    void MaybeFinish() {
+        if (!write_done || !read_done || step_ == kFinish) return;
         step_ = kFinish;
-        if (code != grpc::StatusCode::OK)
-            status = grpc::Status(code, "stream aborted");
-        reader->Finish(&status, this);   // 恰好一次 Finish
+        stream->Finish(&status, this);
     }
 
-    Callback callback;
-    SubscribeRequest request;
-    TaskResult response;
-    std::unique_ptr<grpc::ClientAsyncReader<TaskResult>> reader;
-    grpc::ClientContext context;
-    Step step_;
+    enum Step { kStart, kWrite, kWritesDone, kFinish } step_{kStart};
+    std::vector<Task> tasks;
+    std::size_t batch_size;
+    std::size_t next = 0;
+    std::uint64_t batch_id = 0;
+    bool write_done = false;
+    bool read_done = false;
+
+    TaskBatch out;                            // 写缓冲，逐批复用
+    BatchAck ack;                             // 读缓冲，逐条复用
+    std::vector<SubmitAck> acks;
+    std::promise<std::vector<SubmitAck>> promise;
+    ReadTag read_tag;
+    std::unique_ptr<grpc::ClientAsyncReaderWriter<TaskBatch, BatchAck>> stream;
 };
 
 // ---------- 客户端 ----------
+// 连接池配置：默认每个核一条连接、一个 CQ 线程；keepalive/窗口等按通道参数下发
+struct ClientOptions {
+    enum class Select { kRoundRobin, kLeastLoaded };
+
+    std::size_t channels   = 0;           // 0 = CPU 核数
+    std::size_t cq_threads = 0;           // 0 = CPU 核数；每个线程独占一个 CQ
+    Select      select     = Select::kLeastLoaded;
+
+    int keepalive_time_ms    = 30'000;    // <= 0 关闭 keepalive
+    int keepalive_timeout_ms = 10'000;
+    bool keepalive_without_calls = false;
+    int stream_window_bytes  = 0;         // HTTP/2 单流接收窗口（BDP 探测的起点），0 = gRPC 默认
+    int max_message_bytes    = 0;         // 收发消息上限，0 = gRPC 默认
+    // 其余参数在这里补，最后应用，可以覆盖上面的设置
+    std::function<void(grpc::ChannelArguments&)> customize;
+
+    // 截止时间与重试：timeout 作用于一次调用的全部尝试，0 = 不设截止时间
+    std::chrono::milliseconds timeout{5'000};
+    RetryPolicy retry;                    // 作用于提交；重试的提交自动带上 idempotency_key
+    HedgePolicy hedge;                    // 作用于 QueryStatus
+
+    // 用户回调不在 CQ 线程上跑：默认投到内部线程池（首次用到时才建），
+    // 也可以交给调用方自己的执行器；callback_threads = 0 且未给执行器时在 CQ 线程上直接调。
+    // 同一次 listen/submit 的回调按到达顺序串行执行。
+    using Executor = std::function<void(std::function<void()>)>;
+    std::size_t callback_threads = 1;
+    Executor    callback_executor;
+};
+
+// 按 ClientOptions 组装通道参数（GrpcClient 与 CallbackClient 共用）
+grpc::ChannelArguments MakeChannelArgs(const ClientOptions& options);
+
 class GrpcClient {
 public:
-    GrpcClient(const std::string& target);
+    explicit GrpcClient(const std::string& target, const ClientOptions& options = {});
     ~GrpcClient();
 
-    void CompleteRpc();
-    Task submit_task_sync(const Task& task);
+    // 按值接收：调用方 std::move 进来时附件零拷贝进请求
+    // 截止时间/重试按 CallOptions 覆盖 ClientOptions；提交失败按 RetryPolicy 退避重试，
+    // 重试的请求带同一个 idempotency_key，服务端只执行一次
+    Task submit_task_sync(Task task, const CallOptions& call = {});
     bool cancel_task(const std::string& task_id);
     Task query_status(const std::string& task_id);
-    void listen_results(const std::string& client_id, Callback callback);
-    std::future<Task> submit_task_async(const Task& task, Callback callback = nullptr);
+    // resume_after：上次收到的最大结果序号（跨进程续传用），0 = 只要新结果
+    void listen_results(const std::string& client_id, Callback callback,
+                        std::uint64_t resume_after = 0);
+    std::future<Task> submit_task_async(Task task, Callback callback = nullptr,
+                                        const CallOptions& call = {});
     std::future<bool> cancel_task_async(const std::string& task_id);
+    // HedgePolicy::max_attempts > 1 时走对冲
     std::future<Task> query_status_async(const std::string& task_id);
+    // 批量提交：一条流内按 batch_size 分批发送，ack 按提交顺序返回
+    static constexpr std::size_t kDefaultBatchSize = 256;
+    std::future<std::vector<SubmitAck>> submit_batch_async(std::vector<Task> tasks,
+                                                           std::size_t batch_size = kDefaultBatchSize);
+
+    std::size_t channel_count() const { return channels_.size(); }
+    // 各通道当前在途的调用数（含长连接的监听流）
+    std::vector<int> channel_load() const;
+    // 当前的对冲等待时间
+    std::chrono::milliseconds hedge_delay() const;
 
 private:
-    std::shared_ptr<grpc::Channel> channel_;
-    std::unique_ptr<TaskService::Stub> stub_;
-    grpc::CompletionQueue cq_;
-    std::shared_ptr<ThreadPool> thread_pool_;
-    std::atomic<bool> shutdown_{false};
-    std::thread cq_thread_;
+    friend struct AsyncSubmitTag;
+    friend struct AsyncHedgedQueryTag;
+    friend struct AsyncListenTag;
+    // 一条独立的 HTTP/2 连接：每个通道用本地 subchannel 池，不与其它通道共用连接
+    struct PooledChannel {
+        std::shared_ptr<grpc::Channel>      channel;
+        std::unique_ptr<TaskService::Stub>  stub;
+        std::atomic<int>                    inflight{0};
+    };
+
+    // 同一个回调的多次调用排成一队，投到执行器上依次跑
+    struct Strand {
+        std::mutex mu;
+        std::deque<std::function<void()>> jobs;
+        bool running = false;
+    };
+
+    // 选一条通道并把本次调用记在它名下；tag 为空时（同步调用）由调用方归还计数
+    PooledChannel& Pick(IAsyncTag* tag = nullptr);
+    // 登记到存活表；析构已开始时返回 false
+    bool Track(IAsyncTag* tag);
+    std::optional<std::chrono::system_clock::time_point> DeadlineFor(const CallOptions& call) const;
+    // 发出（或重发）一次提交；客户端正在析构时直接以 CANCELLED 结束
+    void LaunchSubmit(AsyncSubmitTag* tag);
+    // 失败可重试时接手：新建 tag 带着同一请求进入退避，返回 true 后原 tag 由调用方删除
+    bool RetrySubmit(AsyncSubmitTag* tag);
+    void StartListen(AsyncListenTag* tag);
+    bool ResumeListen(AsyncListenTag* tag);
+    // 调用方持 registry_.mu 且已确认未在关闭：新尝试直接登记进存活表
+    void LaunchQueryAttemptLocked(AsyncHedgedQueryTag* tag);
+    grpc::CompletionQueue* NextCq();
+    void CompleteRpc(grpc::CompletionQueue* cq);
+    // 把用户回调包成“投递到执行器”的版本；内联模式下原样返回
+    Callback Offload(Callback cb);
+    void PostCallback(std::function<void()> job);
+
+    ClientOptions options_;
+    std::vector<std::unique_ptr<PooledChannel>> channels_;
+    std::atomic<std::size_t> next_channel_{0};
+    std::vector<std::unique_ptr<grpc::CompletionQueue>> cqs_;
+    std::atomic<std::size_t> next_cq_{0};
+    std::vector<std::thread> cq_threads_;
+    CallRegistry registry_;
+
+    LatencyWindow query_latency_;         // 对冲延迟的依据
+
+    std::once_flag callback_pool_once_;
+    std::unique_ptr<ThreadPool> callback_pool_;
+    std::atomic<std::size_t> callbacks_pending_{0};   // 已投递未执行完，析构时等它归零
+    std::mutex callbacks_mu_;
+    std::condition_variable callbacks_idle_;          // callbacks_pending_ 归零时通知
 };
 
 }   // namespace dts
\ No newline at end of file
@@ -1,3 +1,4 @@
+#pragma once
 #include <atomic>
 #include <thread>
 #include <vector>
@@ -44,11 +45,15 @@ public:
     std::thread::id thread_id_;
 
     ThreadData() = default;
+    ~ThreadData();                        // 线程退出时把没回收的交给全局列表，不泄漏
 };
 
-//线程局部存储
+//线程局部存储：用函数内的 thread_local，变量模板形式的 inline thread_local 在 GCC 下可能拿到未构造的对象
 template <typename T>
-inline thread_local ThreadData<T> tl_thread_data;
+ThreadData<T>& tl_thread_data() {
+    static thread_local ThreadData<T> data;
+    return data;
+}
 
 // 4. Hazard Pointer 域 (Domain)
 // 简化起见，我们实现一个全局默认域。实际工业级库可能支持多个域。
@@ -73,6 +78,7 @@ public:
 
     template<typename U>
     friend void RetirePointer(U*, std::function<void(U*)>);
+    friend class ThreadData<T>;
 
     static HazPtrDomain<T>& defaultDomain() {
         return default_domain_;
@@ -81,7 +87,7 @@ public:
     // 注册新线程
     static void RegisterThread() {
         auto& domain = defaultDomain();
-        auto& tl = tl_thread_data<T>;
+        auto& tl = tl_thread_data<T>();
         // 设置线程ID
         tl.thread_id_ = std::this_thread::get_id();
         
@@ -148,7 +154,7 @@ public:
     bool isProtected(T* ptr) const {
         HazardPointer<T>* current = head_;
         while (current != nullptr) {
-            if (current->hazard_ptr_.load(std::memory_order_acquire) == ptr) {
+            if (current->hazard_ptr_.load(std::memory_order_seq_cst) == ptr) {
                 return true;
             }
             current = current->next_;
@@ -157,11 +163,13 @@ public:
     }
 
     void Scan() {
-        
+        // 当前线程自己的待回收列表总能安全交出，不论是否 RegisterThread 过
+        auto& own = tl_thread_data<T>();
         {
             std::lock_guard<std::mutex> lock(global_retired_mutex_);
+            global_retired_.splice(global_retired_.end(), own.retired_list_);
             for (auto* tl : all_thread_data_) {
-                if (!tl->retired_list_.empty()) {
+                if (tl != &own && !tl->retired_list_.empty()) {
                     global_retired_.splice(global_retired_.end(), tl->retired_list_);
                 }
             }
@@ -175,6 +183,7 @@ public:
         std::vector<RetiredPtr<T>> to_reclaim;
         {
             std::lock_guard<std::mutex> g(global_retired_mutex_);
+            std::lock_guard<std::mutex> slots(list_mutex_);   // acquire() 可能同时在链表头插槽
             auto it = global_retired_.begin();
             while (it != global_retired_.end()) {
                 if (!isProtected(it->ptr_)) {   // 无 hazard ptr 指向它
@@ -192,6 +201,8 @@ public:
 private:
     HazPtrDomain() = default;
     ~HazPtrDomain() {
+        // 进程退出时已没有读者，剩下的待回收对象直接释放
+        for (auto& rec : global_retired_) rec.deleter_(rec.ptr_);
         std::lock_guard<std::mutex> lock(list_mutex_);
         HazardPointer<T>* current = head_;
         while (current != nullptr) {
@@ -240,7 +251,8 @@ public:
     // 设置要保护的指针
     void protect(T* ptr) {
         if (hazard_ptr_slot_) {
-            hazard_ptr_slot_->hazard_ptr_.store(ptr, std::memory_order_release);
+            // seq_cst：保证调用方随后重读源指针时，回收方一定能看到这次保护
+            hazard_ptr_slot_->hazard_ptr_.store(ptr, std::memory_order_seq_cst);
         }
     }
 
@@ -263,7 +275,7 @@ public:
 // 将一个指针标记为待回收
 template <typename T>
 void RetirePointer(T* ptr, std::function<void(T*)> deleter = [](T* p) { delete p; }) {
-    auto& tl = tl_thread_data<T>;  // 当前线程的TLS数据
+    auto& tl = tl_thread_data<T>();  // 当前线程的TLS数据
 
     // 1. 添加到本地待回收列表
     tl.retired_list_.emplace_back(ptr, std::move(deleter));
@@ -271,21 +283,27 @@ void RetirePointer(T* ptr, std::function<void(T*)> deleter = [](T* p) { delete p
     // 2. 检查是否需要提交到全局列表
     if (tl.retired_list_.size() >= tl.scan_threshold_) {
         auto& domain = HazPtrDomain<T>::defaultDomain();
-        
-        // ✅ 关键修改：使用 std::lock_guard 管理锁（安全且高效）
-        std::lock_guard<std::mutex> lock(domain.global_retired_mutex_);
-        
-        // 3. 提交到全局队列（自动清空本地列表）
-        domain.global_retired_.splice(
-            domain.global_retired_.end(),
-            tl.retired_list_
-        );
-        
-        // 4. 检查全局队列大小（锁内安全检查）
-        if (domain.global_retired_.size() > domain.kGlobalThreshold) {
-            domain.Scan();
+        bool over = false;
+        {
+            std::lock_guard<std::mutex> lock(domain.global_retired_mutex_);
+            // 3. 提交到全局队列（自动清空本地列表）
+            domain.global_retired_.splice(
+                domain.global_retired_.end(),
+                tl.retired_list_
+            );
+            over = domain.global_retired_.size() > static_cast<std::size_t>(domain.kGlobalThreshold);
         }
+        // 4. 超阈值就扫描；Scan 自己拿锁，不能在锁内调用
+        if (over) domain.Scan();
     }
 }
 
+template <typename T>
+ThreadData<T>::~ThreadData() {
+    if (retired_list_.empty()) return;
+    auto& domain = HazPtrDomain<T>::defaultDomain();
+    std::lock_guard<std::mutex> lock(domain.global_retired_mutex_);
+    domain.global_retired_.splice(domain.global_retired_.end(), retired_list_);
+}
+
 } // namespace hazptr
\ No newline at end of file
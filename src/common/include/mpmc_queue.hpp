@@ -1,3 +1,4 @@
+#pragma once
 #include <atomic>
 #include <iostream>
 #include <thread>
@@ -14,6 +15,7 @@ struct alignas(64) Node { // 缓存行对齐节点
     std::atomic<Node*> next;
 
     Node(const T& data_) : data(data_), next(nullptr) {}
+    Node(T&& data_) : data(std::move(data_)), next(nullptr) {}
     Node() : next(nullptr) {} // For dummy node
 };
 
@@ -45,11 +47,18 @@ public:
     }
 
     // 入队 (enqueue)
-    void enqueue(const T& data) {
-        Node<T>* new_node = new Node<T>(data);
+    void enqueue(const T& data) { link(new Node<T>(data)); }
+    void enqueue(T&& data) { link(new Node<T>(std::move(data))); }
+
+private:
+    void link(Node<T>* new_node) {
+        // 旧 tail 可能已被出队方退休，读它的 next 之前先保护住
+        static thread_local hazptr::HazPtrHolder<Node<T>> hp_tail;
 
         while (true) {
             Node<T>* curr_tail = tail.load(std::memory_order_acquire);
+            hp_tail.protect(curr_tail);
+            if (curr_tail != tail.load(std::memory_order_acquire)) continue;
             Node<T>* next = curr_tail->next.load(std::memory_order_acquire);
 
             // 检查 tail 是否仍然有效（帮助机制的一部分）
@@ -63,6 +72,7 @@ public:
                         tail.compare_exchange_weak(curr_tail, new_node,
                                                    std::memory_order_release,
                                                    std::memory_order_relaxed);
+                        hp_tail.protect(nullptr);
                         return; // 成功入队
                     }
                 } else {
@@ -76,10 +86,12 @@ public:
         }
     }
 
+public:
     // 出队 (dequeue)
     bool dequeue(T& result) {
-        hazptr::HazPtrHolder<TestObject> hp_head;
-        hazptr::HazPtrHolder<TestObject> hp_next;
+        // 每线程一对槽位，常驻复用：每次出队都去域里申请槽位要拿全局锁
+        static thread_local hazptr::HazPtrHolder<Node<T>> hp_head;
+        static thread_local hazptr::HazPtrHolder<Node<T>> hp_next;
 
         while (true) {
             Node<T>* curr_head = head.load(std::memory_order_acquire);
@@ -100,8 +112,8 @@ public:
 
             if (next == nullptr) {
                 // 队列为空
-                release_hazard_pointer(hp_head);
-                release_hazard_pointer(hp_next);
+                hp_head.protect(nullptr);
+                hp_next.protect(nullptr);
                 return false;
             }
 
@@ -115,14 +127,14 @@ public:
                 if (head.compare_exchange_weak(curr_head, next,
                                                std::memory_order_acquire,
                                                std::memory_order_relaxed)) {
-                    result = next->data; // 安全读取数据
+                    result = std::move(next->data); // next 成了新的 dummy，数据只会被这里取走
 
                     // 退休旧的 head 节点 (curr_head)，延迟释放
-                    hp_head.release();
-                    hp_next.release();
+                    hp_head.protect(nullptr);
+                    hp_next.protect(nullptr);
 
                     // 尝试回收节点
-                    hazptr::RetirePointer<TestObject>(curr_head);
+                    hazptr::RetirePointer<Node<T>>(curr_head);
 
                     return true; // 成功出队
                 }
@@ -0,0 +1,65 @@
+// payload.hpp
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dts {
+
+// 不可变的分块字节串（Cord 风格）：每块引用计数共享，拷贝 Payload 只加计数不拷数据。
+// 从 proto 收包时直接接管 bytes 字段的缓冲区，发包时独占的块直接搬进 proto。
+class Payload {
+public:
+    Payload() = default;
+
+    // 接管 s 的缓冲区，不拷贝
+    static Payload Adopt(std::string&& s);
+    // 复制一份外部数据
+    static Payload Copy(std::span<const std::byte> data);
+    static Payload Copy(std::string_view data);
+
+    // 末尾追加一块（接管所有权）
+    void append(std::string&& chunk);
+    // 末尾追加另一个 Payload 的所有块（共享，不拷贝）
+    void append(const Payload& other);
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::size_t chunk_count() const { return chunks_.size(); }
+    bool contiguous() const { return chunks_.size() <= 1; }
+
+    std::span<const std::byte> chunk(std::size_t i) const;
+
+    // 单块时零拷贝视图；多块时抛 std::logic_error，调用方改用 chunk(i) 逐块读或 flatten()
+    std::span<const std::byte> span() const;
+    std::string_view view() const;
+
+    // 拼成一块连续内存（会拷贝）
+    std::string flatten() const;
+
+    // 取走第 i 块：本 Payload 独占时直接搬走缓冲区，与别人共享时复制一份。
+    // 取走后该块变空，调用方负责随后 clear()
+    std::string release_chunk(std::size_t i);
+
+    void clear();
+
+private:
+    std::vector<std::shared_ptr<std::string>> chunks_;
+    std::size_t size_ = 0;
+};
+
+// 任务附件：大块二进制输入/输出，走 bytes 字段，不再塞进 Struct
+struct Attachment {
+    std::string name;
+    std::string content_type;
+    Payload data;
+};
+
+// 按名字找附件，找不到返回 nullptr
+const Attachment* FindAttachment(const std::vector<Attachment>& list, std::string_view name);
+
+} // namespace dts
@@ -0,0 +1,16 @@
+// string_hash.hpp
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+
+namespace dts {
+
+// 透明哈希：配合 std::equal_to<> 让以 std::string 为键的 unordered_map 直接用 string_view 查找，不构造临时串
+struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+} // namespace dts
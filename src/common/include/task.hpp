@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include "payload.hpp"
 
 namespace dts {
 enum class TaskState : std::uint8_t {
@@ -25,6 +26,11 @@ struct Shard {
 };
 
 struct Task {
+    Task() = default;
+    // 由对象池构造：取消标志由调用方分配，避免默认 make_shared 走全局堆
+    explicit Task(std::shared_ptr<std::atomic<bool>> cancel_flag)
+        : cancelled(std::move(cancel_flag)) {}
+
     std::string task_id;
     std::string client_id;
     std::uint32_t priority = 0;
@@ -45,9 +51,23 @@ struct Task {
     std::int64_t finish_ts = 0;
     nlohmann::json result;
     std::string error_msg;
+    std::vector<Attachment> inputs;    // 大块二进制输入，拷贝 Task 只共享缓冲区
+    std::vector<Attachment> outputs;
+    std::string idempotency_key;       // 为空时由客户端在需要重试的提交上生成
+    std::int64_t not_before_ts = 0;    // Unix 毫秒，0 为立即可调度
+    std::string recurrence;            // cron 表达式或 "@every <n>{ms,s,m,h}"，空为一次性
+    std::vector<std::string> parent_ids;   // DAG 上游：全部成功后才进入调度
+    std::uint32_t child_count = 0;         // DAG 下游个数，由调度器填；非零时执行端把结果留给同节点的下游
+};
+
+// 批量提交的逐任务回执
+struct SubmitAck {
+    std::string task_id;
+    TaskState state = TaskState::PENDING;
+    std::string error_msg;
 };
 
-// 手动 JSON 转换，跳过 cancelled
+// 手动 JSON 转换，跳过 cancelled 与二进制附件
 inline void to_json(nlohmann::json& j, const Task& t) {
     j = {
         {"task_id", t.task_id},
@@ -65,7 +85,12 @@ inline void to_json(nlohmann::json& j, const Task& t) {
         {"start_ts", t.start_ts},
         {"finish_ts", t.finish_ts},
         {"result", t.result},
-        {"error_msg", t.error_msg}
+        {"error_msg", t.error_msg},
+        {"idempotency_key", t.idempotency_key},
+        {"not_before_ts", t.not_before_ts},
+        {"recurrence", t.recurrence},
+        {"parent_ids", t.parent_ids},
+        {"child_count", t.child_count}
     };
 }
 
@@ -86,6 +111,11 @@ inline void from_json(const nlohmann::json& j, Task& t) {
     j.at("finish_ts").get_to(t.finish_ts);
     j.at("result").get_to(t.result);
     j.at("error_msg").get_to(t.error_msg);
+    t.idempotency_key = j.value("idempotency_key", std::string{});   // 旧数据没有以下字段
+    t.not_before_ts = j.value("not_before_ts", std::int64_t{0});
+    t.recurrence = j.value("recurrence", std::string{});
+    t.parent_ids = j.value("parent_ids", std::vector<std::string>{});
+    t.child_count = j.value("child_count", std::uint32_t{0});
 }
 
 }  // namespace dts
\ No newline at end of file
@@ -0,0 +1,144 @@
+// task_table.hpp
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+
+namespace dts {
+
+// ---------- 字符串驻留 ----------
+// 同一 client_id 全进程只存一份，之后用 32 位编号比较/哈希；0 保留为无效
+class StringInterner {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id kInvalid = 0;
+
+    Id intern(std::string_view s);
+    Id find(std::string_view s) const;           // 不存在返回 kInvalid
+    std::string_view lookup(Id id) const;        // 非法 id 返回空串
+    std::size_t size() const;
+
+    // 全局 client_id 表
+    static StringInterner& clients();
+
+private:
+    mutable std::shared_mutex mu_;
+    std::deque<std::string> storage_;            // deque 保证元素地址稳定，map 的 key 直接指向它
+    std::unordered_map<std::string_view, Id> index_;
+};
+
+// ---------- 数值任务 id ----------
+// 64 位：纯数字字符串原样解析，其余按 FNV-1a 哈希（百万级在途任务时碰撞概率 ~1e-8）
+using TaskId = std::uint64_t;
+TaskId MakeTaskId(std::string_view task_id);
+
+// ---------- 热/冷分离 ----------
+// 热数据：调度、超时、取消扫描只碰这 48 字节
+struct TaskHot {
+    static constexpr std::uint32_t kNoTs = UINT32_MAX;
+
+    TaskId        id = 0;                        // 0 = 空槽
+    std::int64_t  submit_ts = 0;
+    std::uint32_t start_delta = kNoTs;           // 相对 submit_ts 的毫秒偏移
+    std::uint32_t finish_delta = kNoTs;
+    StringInterner::Id client = StringInterner::kInvalid;
+    std::uint32_t priority = 0;
+    std::uint32_t timeout_ms = 0;
+    std::uint32_t cpu_millis = 0;                // Resource::cpu_core * 1000
+    std::uint32_t mem_mb = 0;
+    std::atomic<TaskState> state{TaskState::PENDING};
+    std::atomic<bool> cancelled{false};          // 内联取消标志，不再单独堆分配
+    std::uint8_t  retry_count = 0;
+    std::uint8_t  max_retry = 0;
+
+    std::int64_t start_ts() const  { return start_delta  == kNoTs ? 0 : submit_ts + start_delta; }
+    std::int64_t finish_ts() const { return finish_delta == kNoTs ? 0 : submit_ts + finish_delta; }
+    void set_start_ts(std::int64_t ts);
+    void set_finish_ts(std::int64_t ts);
+};
+static_assert(sizeof(TaskHot) == 48, "TaskHot should stay 48 bytes");
+
+// 冷数据：只有执行/回包时才读
+struct TaskCold {
+    std::string task_id;
+    std::string func_name;
+    nlohmann::json func_params;
+    Shard shard;
+    nlohmann::json result;
+    std::string error_msg;
+    std::vector<Attachment> inputs;              // 只共享缓冲区，不复制数据
+    std::vector<Attachment> outputs;
+    std::string idempotency_key;
+    std::int64_t not_before_ts = 0;
+    std::string recurrence;
+    std::vector<std::string> parent_ids;
+    std::uint32_t child_count = 0;
+};
+
+// ---------- 任务表 ----------
+// 分块连续存储 + 空闲链表，插入/删除不搬动已有元素；句柄带代数，失效句柄查不到。
+// 非线程安全（由单个调度/执行线程持有）；只有 TaskHot::cancelled/state 允许跨线程读写。
+class TaskTable {
+public:
+    struct Handle {
+        std::uint32_t index = UINT32_MAX;
+        std::uint32_t generation = 0;
+        explicit operator bool() const { return index != UINT32_MAX; }
+    };
+
+    static constexpr std::size_t kChunkShift = 14;               // 每块 16384 个
+    static constexpr std::size_t kChunkSize  = std::size_t{1} << kChunkShift;
+
+    Handle insert(const Task& task);
+    bool erase(Handle h);
+
+    TaskHot*  hot(Handle h);
+    TaskCold* cold(Handle h);
+    const TaskHot* hot(Handle h) const;
+
+    // 还原成完整的 Task（回写 proto / 对外接口用）
+    Task materialize(Handle h) const;
+
+    std::size_t size() const { return live_; }
+    std::size_t capacity() const { return hot_chunks_.size() * kChunkSize; }
+
+    // 按块顺序扫描所有在用的热数据，f(Handle, TaskHot&)
+    template <class F>
+    void for_each_hot(F&& f) {
+        for (std::size_t c = 0; c < hot_chunks_.size(); ++c) {
+            TaskHot* chunk = hot_chunks_[c].get();
+            const std::size_t n = std::min(kChunkSize, used_ - c * kChunkSize);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (chunk[i].id == 0) continue;
+                auto idx = static_cast<std::uint32_t>((c << kChunkShift) | i);
+                f(Handle{idx, generations_[idx]}, chunk[i]);
+            }
+        }
+    }
+
+private:
+    bool valid(Handle h) const {
+        return h.index < used_ && generations_[h.index] == h.generation &&
+               hot_at(h.index).id != 0;
+    }
+    TaskHot&  hot_at(std::uint32_t i) const  { return hot_chunks_[i >> kChunkShift][i & (kChunkSize - 1)]; }
+    TaskCold& cold_at(std::uint32_t i) const { return cold_chunks_[i >> kChunkShift][i & (kChunkSize - 1)]; }
+
+    std::vector<std::unique_ptr<TaskHot[]>>  hot_chunks_;
+    std::vector<std::unique_ptr<TaskCold[]>> cold_chunks_;
+    std::vector<std::uint32_t> generations_;
+    std::vector<std::uint32_t> free_;
+    std::size_t used_ = 0;                       // 已经切出去的槽位上界
+    std::size_t live_ = 0;
+};
+
+} // namespace dts
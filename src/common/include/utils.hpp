@@ -23,7 +23,14 @@ void JsonToStruct(const json& j, google::protobuf::Struct* proto);
 json StructToJson(const google::protobuf::Struct& proto);
 
 // Task 类型转换
+void TaskToProto(const Task& task, PbTask* proto);          // 原地填充
+PbTask* TaskToProto(const Task& task, google::protobuf::Arena* arena); // 分配在 arena 上
 PbTask TaskToProto(const Task& task);
 Task TaskFromProto(const PbTask& proto);
 
+// 右值版本：附件缓冲区直接在 Task 与 proto 之间搬移，不复制
+void TaskToProto(Task&& task, PbTask* proto);
+PbTask* TaskToProto(Task&& task, google::protobuf::Arena* arena);
+Task TaskFromProto(PbTask&& proto);
+
 } // namespace dts
\ No newline at end of file
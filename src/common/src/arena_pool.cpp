@@ -0,0 +1,51 @@
+#include "arena_pool.hpp"
+#include <vector>
+
+namespace dts {
+
+namespace {
+// 线程退出时 vector 析构，缓存的 arena 一并释放
+thread_local std::vector<std::unique_ptr<ReusableArena>> tl_free_arenas;
+}
+
+google::protobuf::ArenaOptions ReusableArena::MakeOptions(char* block, std::size_t size) {
+    google::protobuf::ArenaOptions opts;
+    opts.initial_block      = block;
+    opts.initial_block_size = size;
+    return opts;
+}
+
+ReusableArena::ReusableArena(std::size_t initial_block_size)
+    : block_(new char[initial_block_size]),
+      arena_(MakeOptions(block_.get(), initial_block_size)) {}
+
+void ArenaPool::Handle::reset() {
+    if (arena_) {
+        ArenaPool::Release(arena_);
+        arena_ = nullptr;
+    }
+}
+
+ArenaPool::Handle ArenaPool::Acquire() {
+    auto& pool = tl_free_arenas;
+    if (pool.empty()) {
+        return Handle(new ReusableArena(kInitialBlockSize));
+    }
+    ReusableArena* arena = pool.back().release();
+    pool.pop_back();
+    return Handle(arena);
+}
+
+void ArenaPool::Release(ReusableArena* arena) {
+    arena->Reset();
+    auto& pool = tl_free_arenas;
+    if (pool.size() >= kMaxCachedPerThread) {
+        delete arena;
+        return;
+    }
+    pool.emplace_back(arena);
+}
+
+std::size_t ArenaPool::CachedOnThisThread() { return tl_free_arenas.size(); }
+
+} // namespace dts
@@ -0,0 +1,73 @@
+#include "callback_client.hpp"
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace dts {
+
+namespace {
+// 本线程正在其 OnDone 里回调 OnComplete 的提交调用，以及它在 OnComplete 里要求再次发起时用的客户端。
+// 放在线程局部而不是调用对象里：没有再次发起时 OnComplete 返回后就不能再碰调用对象
+thread_local SubmitCall*     tl_completing = nullptr;
+thread_local CallbackClient* tl_restart = nullptr;
+} // namespace
+
+void SubmitCall::Reactor::OnDone(const grpc::Status& status) {
+    SubmitCall* owner = owner_;
+    SubmitCall* outer_call = std::exchange(tl_completing, owner);
+    CallbackClient* outer_restart = std::exchange(tl_restart, nullptr);
+    owner->OnComplete(status);
+    CallbackClient* restart = std::exchange(tl_restart, outer_restart);
+    tl_completing = outer_call;
+    if (restart) restart->Launch(owner);   // 要求再次发起，owner 必然还活着
+}
+
+void ListenCall::OnReadDone(bool ok) {
+    if (!ok) return;                      // 流结束，随后 OnDone
+    if (message_.gap()) OnGap(message_.first_seq());
+    for (auto& t : *message_.mutable_tasks()) OnResult(TaskFromProto(std::move(t)));
+    if (message_.first_seq() > 0) cursor_ = message_.first_seq() + message_.tasks_size() - 1;
+    message_.Clear();
+    StartRead(&message_);
+}
+
+CallbackClient::CallbackClient(const std::string& target, const ClientOptions& options) {
+    const auto args = MakeChannelArgs(options);
+    const std::size_t n = options.channels ? options.channels
+                                           : std::max(1u, std::thread::hardware_concurrency());
+    stubs_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        stubs_.push_back(TaskService::NewStub(
+            grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args)));
+    }
+}
+
+void CallbackClient::Start(SubmitCall* call) {
+    if (tl_completing == call) {          // 在它自己的 OnComplete 里：等 OnComplete 返回再发
+        tl_restart = this;
+        return;
+    }
+    Launch(call);
+}
+
+void CallbackClient::Launch(SubmitCall* call) {
+    auto& reactor = call->reactor_;
+    reactor.context.emplace();            // 上一次的上下文随之析构
+    if (call->timeout_.count() > 0)
+        reactor.context->set_deadline(std::chrono::system_clock::now() + call->timeout_);
+    call->response_.Clear();              // 清空但保留字段缓冲，下一次回包直接复用
+    NextStub().async()->SubmitTask(&*reactor.context, &call->request_, &call->response_, &reactor);
+    reactor.StartCall();
+}
+
+void CallbackClient::Listen(ListenCall* call, const std::string& client_id,
+                            std::uint64_t resume_after) {
+    call->request_.set_client_id(client_id);
+    call->request_.set_resume_after(resume_after);
+    call->cursor_ = resume_after;
+    NextStub().async()->ListenResults(&call->context_, &call->request_, call);
+    call->StartRead(&call->message_);
+    call->StartCall();
+}
+
+} // namespace dts
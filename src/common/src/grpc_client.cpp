@@ -1,107 +1,473 @@
 #include "grpc_client.hpp"
+#include <cmath>
+#include <random>
 
 namespace dts {
 
 
+namespace {
+std::size_t OrCores(std::size_t n) {
+    return n ? n : std::max(1u, std::thread::hardware_concurrency());
+}
+} // namespace
+
+// ---------- 通道参数 ----------
+grpc::ChannelArguments MakeChannelArgs(const ClientOptions& o) {
+    grpc::ChannelArguments args;
+    // 相同参数的通道默认共用全局 subchannel，也就共用一条 TCP 连接；本地池让每个通道自建连接
+    args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    if (o.keepalive_time_ms > 0) {
+        args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, o.keepalive_time_ms);
+        args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, o.keepalive_timeout_ms);
+        args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, o.keepalive_without_calls ? 1 : 0);
+    }
+    if (o.stream_window_bytes > 0) {
+        args.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, o.stream_window_bytes);
+    }
+    if (o.max_message_bytes > 0) {
+        args.SetMaxReceiveMessageSize(o.max_message_bytes);
+        args.SetMaxSendMessageSize(o.max_message_bytes);
+    }
+    if (o.customize) o.customize(args);
+    return args;
+}
+
 // ---------- 构造/析构 ----------
-GrpcClient::GrpcClient(const std::string& target)
-    : stub_(TaskService::NewStub(
-          grpc::CreateChannel(target, grpc::InsecureChannelCredentials()))),
-      thread_pool_(std::make_shared<ThreadPool>(4)) {
-    cq_thread_ = std::thread([this] { CompleteRpc(); });
+GrpcClient::GrpcClient(const std::string& target, const ClientOptions& options)
+    : options_(options) {
+    const auto args = MakeChannelArgs(options_);
+    const std::size_t n_channels = OrCores(options_.channels);
+    channels_.reserve(n_channels);
+    for (std::size_t i = 0; i < n_channels; ++i) {
+        auto ch = std::make_unique<PooledChannel>();
+        ch->channel = grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args);
+        ch->stub = TaskService::NewStub(ch->channel);
+        channels_.push_back(std::move(ch));
+    }
+
+    const std::size_t n_cqs = OrCores(options_.cq_threads);
+    cqs_.reserve(n_cqs);
+    for (std::size_t i = 0; i < n_cqs; ++i) cqs_.push_back(std::make_unique<grpc::CompletionQueue>());
+    cq_threads_.reserve(n_cqs);
+    for (auto& cq : cqs_) {
+        cq_threads_.emplace_back([this, cq = cq.get()] { CompleteRpc(cq); });
+    }
 }
 
 GrpcClient::~GrpcClient() {
-    shutdown_ = true;
-    cq_.Shutdown();
-    if (cq_thread_.joinable()) cq_thread_.join();
+    // 1. 取消还挂着的调用（监听流不会自己结束），等它们走完 Finish、tag 析构。
+    //    CQ 必须在这之后才关：被取消的流还要在 CQ 上登记 Finish
+    {
+        std::unique_lock<std::mutex> lk(registry_.mu);
+        registry_.closing = true;
+        for (auto* tag : registry_.live) tag->Abort();
+        registry_.drained.wait(lk, [this] { return registry_.live.empty(); });
+    }
+    // 2. 关 CQ，轮询线程取完剩余事件后 Next 返回 false
+    for (auto& cq : cqs_) cq->Shutdown();
+    for (auto& t : cq_threads_)
+        if (t.joinable()) t.join();
+    // 3. 等已投递的用户回调跑完，之后线程池才能析构
+    std::unique_lock<std::mutex> lk(callbacks_mu_);
+    callbacks_idle_.wait(lk, [this] { return callbacks_pending_.load(std::memory_order_acquire) == 0; });
+}
+
+// ---------- 通道/CQ 选择 ----------
+GrpcClient::PooledChannel& GrpcClient::Pick(IAsyncTag* tag) {
+    const std::size_t n = channels_.size();
+    std::size_t idx = next_channel_.fetch_add(1, std::memory_order_relaxed) % n;
+    if (options_.select == ClientOptions::Select::kLeastLoaded && n > 1) {
+        // 从轮询位置起扫一圈，负载相同时退化为轮询
+        int best = channels_[idx]->inflight.load(std::memory_order_relaxed);
+        for (std::size_t k = 1; k < n && best > 0; ++k) {
+            const std::size_t j = (idx + k) % n;
+            const int load = channels_[j]->inflight.load(std::memory_order_relaxed);
+            if (load < best) {
+                best = load;
+                idx = j;
+            }
+        }
+    }
+    PooledChannel& ch = *channels_[idx];
+    ch.inflight.fetch_add(1, std::memory_order_relaxed);
+    if (tag) {
+        if (tag->load) tag->load->fetch_sub(1, std::memory_order_relaxed);   // 重发换了通道
+        tag->load = &ch.inflight;
+        if (!tag->registry) Track(tag);
+    }
+    return ch;
+}
+
+bool GrpcClient::Track(IAsyncTag* tag) {
+    std::lock_guard<std::mutex> lk(registry_.mu);
+    tag->registry = &registry_;
+    registry_.live.insert(tag);
+    return !registry_.closing;
+}
+
+grpc::CompletionQueue* GrpcClient::NextCq() {
+    return cqs_[next_cq_.fetch_add(1, std::memory_order_relaxed) % cqs_.size()].get();
+}
+
+std::vector<int> GrpcClient::channel_load() const {
+    std::vector<int> out;
+    out.reserve(channels_.size());
+    for (const auto& ch : channels_) out.push_back(ch->inflight.load(std::memory_order_relaxed));
+    return out;
 }
 
 // ---------- 异步完成分发 ----------
-void GrpcClient::CompleteRpc() {
+void GrpcClient::CompleteRpc(grpc::CompletionQueue* cq) {
     void* tag = nullptr;
     bool ok = false;
+    // 阻塞等待；Shutdown 之后排空剩余事件再返回 false
+    while (cq->Next(&tag, &ok)) {
+        static_cast<CqTag*>(tag)->Proceed(ok);
+    }
+}
 
-    while (!shutdown_.load(std::memory_order_acquire)) {
-        auto status = cq_.AsyncNext(&tag, &ok,
-                                    gpr_time_add(gpr_now(GPR_CLOCK_REALTIME),
-                                                 gpr_time_from_seconds(1, GPR_TIMESPAN)));
+// ---------- 用户回调执行 ----------
+Callback GrpcClient::Offload(Callback cb) {
+    if (!cb) return cb;
+    if (options_.callback_threads == 0 && !options_.callback_executor) return cb;
+    // 回调本身也放进共享状态：submit 的 tag 在投递之后就析构了
+    auto fn = std::make_shared<Callback>(std::move(cb));
+    auto strand = std::make_shared<Strand>();
+    return [this, fn, strand](const Task& task, grpc::Status status) {
+        bool start = false;
+        {
+            std::lock_guard<std::mutex> lk(strand->mu);
+            strand->jobs.emplace_back([fn, task, status] { (*fn)(task, status); });
+            start = !std::exchange(strand->running, true);
+        }
+        if (!start) return;                 // 已有人在跑这条队列
+        PostCallback([strand] {
+            std::unique_lock<std::mutex> lk(strand->mu);
+            while (!strand->jobs.empty()) {
+                auto job = std::move(strand->jobs.front());
+                strand->jobs.pop_front();
+                lk.unlock();
+                job();
+                lk.lock();
+            }
+            strand->running = false;
+        });
+    };
+}
 
-        switch (status) {
-        case grpc::CompletionQueue::NextStatus::GOT_EVENT:
-            static_cast<IAsyncTag*>(tag)->Proceed(ok);
-            break;
-        case grpc::CompletionQueue::NextStatus::SHUTDOWN:
-            return;
-        case grpc::CompletionQueue::NextStatus::TIMEOUT:
-            break;
+void GrpcClient::PostCallback(std::function<void()> job) {
+    callbacks_pending_.fetch_add(1, std::memory_order_relaxed);
+    auto wrapped = [this, job = std::move(job)] {
+        job();
+        if (callbacks_pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lk(callbacks_mu_);   // 持锁通知，析构方不会错过
+            callbacks_idle_.notify_all();
         }
+    };
+    if (options_.callback_executor) {
+        options_.callback_executor(std::move(wrapped));
+        return;
     }
+    std::call_once(callback_pool_once_, [this] {
+        callback_pool_ = std::make_unique<ThreadPool>(options_.callback_threads);
+    });
+    callback_pool_->enqueue(std::move(wrapped));
 }
 
-// ---------- 各 RPC 实现 ----------
-std::future<Task> GrpcClient::submit_task_async(const Task& task, Callback cb) {
-    if (!stub_) {
-        auto prom = std::make_shared<std::promise<Task>>();
-        prom->set_exception(std::make_exception_ptr(
-            GrpcError(grpc::Status(grpc::StatusCode::UNAVAILABLE,
-                                   "stub_ is null (channel create failed or moved)"))));
-        if (cb) cb(Task{}, grpc::Status(grpc::StatusCode::UNAVAILABLE, "stub_ null"));
-        return prom->get_future();
+// ---------- 截止时间/重试/对冲 ----------
+namespace {
+std::mt19937_64& Rng() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    return rng;
+}
+
+// 128 位随机数的十六进制串，够做一次提交的去重键
+std::string NewIdempotencyKey() {
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string key(32, '0');
+    for (int half = 0; half < 2; ++half) {
+        std::uint64_t v = Rng()();
+        for (int i = 0; i < 16; ++i, v >>= 4) key[half * 16 + i] = kHex[v & 0xF];
     }
+    return key;
+}
+} // namespace
 
-    auto promise = std::make_shared<std::promise<Task>>();
-    auto *tag = new AsyncSubmitTag(promise, std::move(cb));
+std::chrono::milliseconds RetryPolicy::Backoff(int attempt) const {
+    double ms = static_cast<double>(initial_backoff.count()) *
+                std::pow(multiplier, std::max(0, attempt - 1));
+    ms = std::min(ms, static_cast<double>(max_backoff.count()));
+    if (jitter > 0) {
+        std::uniform_real_distribution<double> u(1.0 - jitter, 1.0 + jitter);
+        ms *= u(Rng());
+    }
+    return std::chrono::milliseconds(static_cast<std::int64_t>(ms));
+}
 
-    auto future = promise->get_future();
-    tag->reader = stub_->PrepareAsyncSubmitTask(&tag->context,
-                                                TaskToProto(task), &cq_);
+void LatencyWindow::Record(std::chrono::steady_clock::duration d) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    const std::size_t i = count_.fetch_add(1, std::memory_order_relaxed) % kSize;
+    us_[i].store(static_cast<std::uint32_t>(std::clamp<std::int64_t>(us, 0, UINT32_MAX)),
+                 std::memory_order_relaxed);
+}
+
+std::chrono::microseconds LatencyWindow::Quantile(double q, std::chrono::microseconds fallback) const {
+    const std::size_t n = std::min(count_.load(std::memory_order_relaxed), kSize);
+    if (n < 32) return fallback;
+    std::array<std::uint32_t, kSize> v;
+    for (std::size_t i = 0; i < n; ++i) v[i] = us_[i].load(std::memory_order_relaxed);
+    const std::size_t k = std::min(n - 1, static_cast<std::size_t>(q * n));
+    std::nth_element(v.begin(), v.begin() + k, v.begin() + n);
+    return std::chrono::microseconds(v[k]);
+}
+
+std::optional<std::chrono::system_clock::time_point>
+GrpcClient::DeadlineFor(const CallOptions& call) const {
+    const auto timeout = call.timeout.count() > 0 ? call.timeout : options_.timeout;
+    if (timeout.count() <= 0) return std::nullopt;
+    return std::chrono::system_clock::now() + timeout;
+}
+
+std::chrono::milliseconds GrpcClient::hedge_delay() const {
+    const auto& h = options_.hedge;
+    auto d = std::chrono::ceil<std::chrono::milliseconds>(query_latency_.Quantile(
+        h.quantile, std::chrono::duration_cast<std::chrono::microseconds>(h.initial_delay)));
+    return std::max(d, h.min_delay);
+}
+
+void GrpcClient::LaunchSubmit(AsyncSubmitTag* tag) {
+    PooledChannel& ch = Pick(tag);
+    bool closing;
+    {
+        std::lock_guard<std::mutex> lk(registry_.mu);
+        closing = registry_.closing;
+    }
+    if (closing) {
+        tag->status = grpc::Status(grpc::StatusCode::CANCELLED, "client shutting down");
+        tag->SetResult();
+        delete tag;
+        return;
+    }
+    if (tag->deadline) tag->context.set_deadline(*tag->deadline);
+    tag->step_ = AsyncSubmitTag::kFinish;
+    tag->reader = ch.stub->PrepareAsyncSubmitTask(&tag->context, *tag->request, tag->cq);
     tag->reader->StartCall();
+    // 一元调用的 StartCall 不产生 CQ 事件，直接登记 Finish
+    tag->reader->Finish(tag->response, &tag->status, tag);
+}
 
+bool GrpcClient::RetrySubmit(AsyncSubmitTag* tag) {
+    const auto& policy = tag->retry;
+    if (tag->attempt >= policy.max_attempts || !policy.Retryable(tag->status.error_code())) {
+        return false;
+    }
+    const auto wait = policy.Backoff(tag->attempt);
+    const auto resume = std::chrono::system_clock::now() + wait;
+    if (tag->deadline && resume >= *tag->deadline) return false;   // 截止时间内放不下
 
-    return future;
+    // ClientContext 不能复用：换一个新 tag，带上同一份请求（含 idempotency_key）
+    auto* next = new AsyncSubmitTag(this, std::move(tag->promise), std::move(tag->callback));
+    next->cq       = tag->cq;
+    next->attempt  = tag->attempt + 1;
+    next->retry    = policy;
+    next->deadline = tag->deadline;
+    next->request  = google::protobuf::Arena::CreateMessage<PbTask>(next->arena.get());
+    next->request->CopyFrom(*tag->request);
+    if (!Track(next)) {
+        next->status = grpc::Status(grpc::StatusCode::CANCELLED, "client shutting down");
+        next->SetResult();
+        delete next;
+        return true;
+    }
+    next->step_ = AsyncSubmitTag::kBackoff;
+    next->backoff_pending.store(true, std::memory_order_release);
+    next->alarm.Set(next->cq, resume, next);
+    return true;
 }
 
-Task GrpcClient::submit_task_sync(const Task& task) {
-    if (!stub_) {
-        throw GrpcError(grpc::Status(grpc::StatusCode::UNAVAILABLE,
-                                     "channel not created / connection refused"));
+void AsyncSubmitTag::ProceedImpl(bool ok) {
+    switch (step_) {
+    case kBackoff:
+        backoff_pending.store(false, std::memory_order_release);
+        if (!ok) {                        // 退避中被 Abort 取消
+            status = grpc::Status(grpc::StatusCode::CANCELLED, "client shutting down");
+            SetResult();
+            delete this;
+            return;
+        }
+        client->LaunchSubmit(this);
+        return;
+
+    case kFinish:
+        if (!ok) {
+            // Finish 本身失败，覆盖 status
+            status = grpc::Status(grpc::StatusCode::INTERNAL, "Finish cq !ok");
+        }
+        if (!status.ok() && client->RetrySubmit(this)) {
+            delete this;                  // 结果交给新 tag
+            return;
+        }
+        SetResult();
+        delete this;
+        return;
     }
+}
 
-    grpc::ClientContext ctx;
-    ctx.set_deadline(std::chrono::system_clock::now() +
-                     std::chrono::seconds(5));  // 5 秒超时
+void GrpcClient::LaunchQueryAttemptLocked(AsyncHedgedQueryTag* tag) {
+    auto attempt = std::make_unique<AsyncHedgedQueryTag::Attempt>(tag);
+    auto* a = attempt.get();
+    PooledChannel& ch = Pick();           // Pick(a) 会再拿 registry 锁，这里手工登记
+    a->load = &ch.inflight;
+    a->registry = &registry_;
+    registry_.live.insert(a);
+    if (tag->deadline) a->context.set_deadline(*tag->deadline);
+    a->started = std::chrono::steady_clock::now();
+    tag->attempts.push_back(std::move(attempt));
+    ++tag->outstanding;
+    a->reader = ch.stub->PrepareAsyncQueryStatus(&a->context, tag->request, tag->cq);
+    a->reader->StartCall();
+    a->reader->Finish(&a->response, &a->status, a);
+}
+
+void AsyncHedgedQueryTag::ProceedImpl(bool ok) {
+    timer_pending.store(false, std::memory_order_release);
+    if (ok && !done && static_cast<int>(attempts.size()) < policy.max_attempts) {
+        // 检查关闭、登记新尝试、重设定时器在同一把锁下完成：析构方的 Abort 要么看不到它们，
+        // 要么看到的是已登记的尝试和已挂上的定时器，不会漏掉
+        std::lock_guard<std::mutex> lk(client->registry_.mu);
+        if (!client->registry_.closing) {
+            client->LaunchQueryAttemptLocked(this);
+            if (static_cast<int>(attempts.size()) < policy.max_attempts && !done) {
+                timer_pending.store(true, std::memory_order_release);
+                timer.Set(cq, std::chrono::system_clock::now() + delay, this);
+            }
+        }
+    }
+    if (!done && outstanding == 0) {      // 客户端关闭，一次都没发出去
+        done = true;
+        promise.set_exception(std::make_exception_ptr(
+            GrpcError(grpc::Status(grpc::StatusCode::CANCELLED, "client shutting down"))));
+    }
+    MaybeDelete();
+}
+
+void AsyncHedgedQueryTag::OnAttemptDone(Attempt* a, bool ok) {
+    --outstanding;
+    if (!ok) a->status = grpc::Status(grpc::StatusCode::INTERNAL, "cq !ok");
+    // 成功或确定性的错误（如 NOT_FOUND）直接作数；可重试的错误等其它尝试，都失败了才报
+    const bool decisive = a->status.ok() || !policy.NonFatal(a->status.error_code());
+    if (!done && !decisive && outstanding == 0 && static_cast<int>(attempts.size()) < policy.max_attempts) {
+        // 非致命失败且没有别的尝试在途：不等定时器，立即补发下一次
+        std::lock_guard<std::mutex> lk(client->registry_.mu);
+        if (!client->registry_.closing) {
+            client->LaunchQueryAttemptLocked(this);
+            return;
+        }
+    }
+    if (!done && (decisive || outstanding == 0)) {
+        done = true;
+        if (a->status.ok()) {
+            client->query_latency_.Record(std::chrono::steady_clock::now() - a->started);
+            promise.set_value(TaskFromProto(std::move(a->response)));
+        } else {
+            promise.set_exception(std::make_exception_ptr(GrpcError(a->status)));
+        }
+        for (auto& other : attempts)
+            if (other.get() != a) other->context.TryCancel();
+        if (timer_pending.load(std::memory_order_acquire)) timer.Cancel();
+    }
+    MaybeDelete();
+}
+
+// ---------- 各 RPC 实现 ----------
+std::future<Task> GrpcClient::submit_task_async(Task task, Callback cb, const CallOptions& call) {
+    auto promise = std::make_shared<std::promise<Task>>();
+    auto *tag = new AsyncSubmitTag(this, promise, Offload(std::move(cb)));
+    auto future = promise->get_future();
+
+    tag->retry    = call.retry ? *call.retry : options_.retry;
+    tag->deadline = DeadlineFor(call);
+    tag->cq       = NextCq();
+    if (tag->retry.max_attempts > 1 && task.idempotency_key.empty()) {
+        task.idempotency_key = NewIdempotencyKey();
+    }
+    tag->request = TaskToProto(std::move(task), tag->arena.get());
+    LaunchSubmit(tag);
+    return future;
+}
 
-    TaskResponse resp;
-    grpc::Status st = stub_->SubmitTask(&ctx, TaskToProto(task), &resp);
+Task GrpcClient::submit_task_sync(Task task, const CallOptions& call) {
+    const RetryPolicy& retry = call.retry ? *call.retry : options_.retry;
+    const auto deadline = DeadlineFor(call);
+    if (retry.max_attempts > 1 && task.idempotency_key.empty()) {
+        task.idempotency_key = NewIdempotencyKey();
+    }
+
+    auto arena = ArenaPool::Acquire();
+    PbTask* req = TaskToProto(std::move(task), arena.get());
+    auto* resp = google::protobuf::Arena::CreateMessage<TaskResponse>(arena.get());
+    for (int attempt = 1;; ++attempt) {
+        grpc::ClientContext ctx;
+        if (deadline) ctx.set_deadline(*deadline);
+        PooledChannel& ch = Pick();
+        grpc::Status st = ch.stub->SubmitTask(&ctx, *req, resp);
+        ch.inflight.fetch_sub(1, std::memory_order_relaxed);
+        if (st.ok()) return TaskFromProto(std::move(*resp->mutable_task()));
 
-    if (!st.ok()) {
+        if (attempt < retry.max_attempts && retry.Retryable(st.error_code())) {
+            const auto wait = retry.Backoff(attempt);
+            if (!deadline || std::chrono::system_clock::now() + wait < *deadline) {
+                std::this_thread::sleep_for(wait);
+                resp->Clear();
+                continue;
+            }
+        }
         std::cerr << "[ERROR] SubmitTask failed: "
                   << st.error_code() << " - " << st.error_message() << std::endl;
         throw GrpcError(st);
     }
-
-    return TaskFromProto(resp.task());
 }
 
 std::future<bool> GrpcClient::cancel_task_async(const std::string& task_id) {
     auto tag = std::make_unique<AsyncCancelTag>();
     tag->request.set_task_id(task_id);
-    tag->reader = stub_->PrepareAsyncCancelTask(&tag->context,
-                                                tag->request, &cq_);
+    if (auto d = DeadlineFor({})) tag->context.set_deadline(*d);
+    tag->reader = Pick(tag.get()).stub->PrepareAsyncCancelTask(&tag->context,
+                                                               tag->request, NextCq());
     tag->reader->StartCall();
-    tag->reader->Finish(&tag->response, &tag->status, tag.release());
-    return tag->promise.get_future();
+    auto future = tag->promise.get_future();
+    tag->step_ = AsyncCancelTag::kFinish;   // Finish 已登记，回包即终态
+    auto* raw = tag.release();              // 先 release，避免与实参求值顺序纠缠
+    raw->reader->Finish(&raw->response, &raw->status, raw);
+    return future;
 }
 
 std::future<Task> GrpcClient::query_status_async(const std::string& task_id) {
+    if (options_.hedge.max_attempts > 1) {
+        auto* tag = new AsyncHedgedQueryTag(this, NextCq());
+        tag->request.set_task_id(task_id);
+        tag->policy   = options_.hedge;
+        tag->delay    = hedge_delay();
+        tag->deadline = DeadlineFor({});
+        auto future = tag->promise.get_future();
+        Track(tag);
+        // 第一次尝试也经定时器发起，之后 tag 的状态只在所属 CQ 线程上读写
+        tag->timer_pending.store(true, std::memory_order_release);
+        tag->timer.Set(tag->cq, std::chrono::system_clock::now(), tag);
+        return future;
+    }
+
     auto tag = std::make_unique<AsyncQueryTag>();
-    tag->request.set_task_id(task_id);
-    tag->reader = stub_->PrepareAsyncQueryStatus(&tag->context,
-                                                 tag->request, &cq_);
+    tag->request->set_task_id(task_id);
+    if (auto d = DeadlineFor({})) tag->context.set_deadline(*d);
+    tag->reader = Pick(tag.get()).stub->PrepareAsyncQueryStatus(&tag->context,
+                                                                *tag->request, NextCq());
     tag->reader->StartCall();
-    tag->reader->Finish(&tag->response, &tag->status, tag.release());
-    return tag->promise.get_future();
+    auto future = tag->promise.get_future();
+    tag->step_ = AsyncQueryTag::kFinish;    // Finish 已登记，回包即终态
+    auto* raw = tag.release();
+    raw->reader->Finish(raw->response, &raw->status, raw);
+    return future;
 }
 
 bool GrpcClient::cancel_task(const std::string& task_id) {
@@ -111,13 +477,108 @@ Task GrpcClient::query_status(const std::string& task_id) {
     return query_status_async(task_id).get();
 }
 
+std::future<std::vector<SubmitAck>> GrpcClient::submit_batch_async(std::vector<Task> tasks,
+                                                                 std::size_t batch_size) {
+    auto* tag = new AsyncBatchTag(std::move(tasks), batch_size);
+    auto future = tag->promise.get_future();
+    tag->stream = Pick(tag).stub->PrepareAsyncSubmitTasks(&tag->context, NextCq());
+    tag->stream->StartCall(tag);
+    return future;
+}
+
 // 流式监听
-void GrpcClient::listen_results(const std::string& client_id, Callback cb) {
-    auto tag = std::make_unique<AsyncListenTag>(std::move(cb));
+void GrpcClient::listen_results(const std::string& client_id, Callback cb,
+                                std::uint64_t resume_after) {
+    auto* tag = new AsyncListenTag(this, Offload(std::move(cb)));
     tag->request.set_client_id(client_id);
-    tag->reader = stub_->PrepareAsyncListenResults(&tag->context,
-                                                   tag->request, &cq_);
-    tag->reader->StartCall(tag.release()); 
+    tag->request.set_resume_after(resume_after);
+    tag->cursor = resume_after;
+    tag->cq = NextCq();
+    StartListen(tag);
+}
+
+void GrpcClient::StartListen(AsyncListenTag* tag) {
+    PooledChannel& ch = Pick(tag);
+    tag->step_ = AsyncListenTag::kStart;
+    tag->reader = ch.stub->PrepareAsyncListenResults(&tag->context, tag->request, tag->cq);
+    tag->reader->StartCall(tag);
+}
+
+bool GrpcClient::ResumeListen(AsyncListenTag* tag) {
+    const auto& policy = options_.retry;
+    const int failures = tag->failures + 1;
+    if (!policy.Retryable(tag->status.error_code()) || failures >= policy.max_attempts) return false;
+
+    auto next = std::make_unique<AsyncListenTag>(this, tag->callback);
+    next->cq       = tag->cq;
+    next->cursor   = tag->cursor;
+    next->failures = failures;
+    next->request.set_client_id(tag->request.client_id());
+    next->request.set_resume_after(tag->cursor);
+    if (!Track(next.get())) return false;     // 客户端在关闭，按最终状态交付
+    next->step_ = AsyncListenTag::kBackoff;
+    next->backoff_pending.store(true, std::memory_order_release);
+    auto* raw = next.release();
+    raw->alarm.Set(raw->cq, std::chrono::system_clock::now() + policy.Backoff(failures), raw);
+    return true;
+}
+
+void AsyncListenTag::ProceedImpl(bool ok) {
+    switch (step_) {
+    case kBackoff:
+        backoff_pending.store(false, std::memory_order_release);
+        if (!ok) {                        // 退避中被 Abort 取消
+            step_ = kDone;
+            if (callback) callback(Task{}, grpc::Status(grpc::StatusCode::CANCELLED, "client shutting down"));
+            delete this;
+            return;
+        }
+        client->StartListen(this);
+        return;
+
+    case kStart:
+        if (!ok) {                        // 连建立就失败
+            TransitionToFinish();
+            return;
+        }
+        step_ = kRead;                    // 正常建立，开始读
+        reader->Read(&response, this);
+        return;
+
+    case kRead:
+        if (!ok) {                        // 对端结束 / 网络出错，Finish 拿真实状态
+            TransitionToFinish();
+            return;
+        }
+        failures = 0;
+        if (response.gap() && callback) {
+            callback(Task{}, grpc::Status(grpc::StatusCode::DATA_LOSS,
+                                          "results before seq " + std::to_string(response.first_seq()) +
+                                              " were dropped"));
+        }
+        for (auto& t : *response.mutable_tasks()) {
+            Task task = TaskFromProto(std::move(t));
+            if (callback) callback(task, grpc::Status::OK);
+        }
+        if (response.first_seq() > 0) cursor = response.first_seq() + response.tasks_size() - 1;
+        response.Clear();
+        reader->Read(&response, this);    // 继续读下一条
+        return;
+
+    case kFinish:
+        step_ = kDone;
+        if (!status.ok() && client->ResumeListen(this)) {
+            delete this;                  // 回调交给重连的 tag
+            return;
+        }
+        if (callback && !status.ok())     // 把最终错误带给用户
+            callback(Task{}, status);
+        delete this;                      // 唯一 suicide 点
+        return;
+
+    case kDone:
+        GPR_ASSERT(false);
+    }
 }
 
 }   // namespace dts
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "payload.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace dts {
+
+namespace {
+std::span<const std::byte> AsBytes(const std::string& s) {
+    return {reinterpret_cast<const std::byte*>(s.data()), s.size()};
+}
+} // namespace
+
+Payload Payload::Adopt(std::string&& s) {
+    Payload p;
+    p.append(std::move(s));
+    return p;
+}
+
+Payload Payload::Copy(std::span<const std::byte> data) {
+    return Adopt(std::string(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+Payload Payload::Copy(std::string_view data) {
+    return Adopt(std::string(data));
+}
+
+void Payload::append(std::string&& chunk) {
+    if (chunk.empty()) return;
+    size_ += chunk.size();
+    chunks_.push_back(std::make_shared<std::string>(std::move(chunk)));
+}
+
+void Payload::append(const Payload& other) {
+    chunks_.insert(chunks_.end(), other.chunks_.begin(), other.chunks_.end());
+    size_ += other.size_;
+}
+
+std::span<const std::byte> Payload::chunk(std::size_t i) const {
+    return AsBytes(*chunks_.at(i));
+}
+
+std::span<const std::byte> Payload::span() const {
+    if (chunks_.empty()) return {};
+    if (chunks_.size() > 1) {
+        throw std::logic_error("Payload::span on non-contiguous payload");
+    }
+    return AsBytes(*chunks_.front());
+}
+
+std::string_view Payload::view() const {
+    auto s = span();
+    return {reinterpret_cast<const char*>(s.data()), s.size()};
+}
+
+std::string Payload::flatten() const {
+    std::string out;
+    out.reserve(size_);
+    for (const auto& c : chunks_) out.append(*c);
+    return out;
+}
+
+std::string Payload::release_chunk(std::size_t i) {
+    auto& c = chunks_.at(i);
+    if (c.use_count() == 1) return std::move(*c);
+    return *c;
+}
+
+void Payload::clear() {
+    chunks_.clear();
+    size_ = 0;
+}
+
+const Attachment* FindAttachment(const std::vector<Attachment>& list, std::string_view name) {
+    for (const auto& a : list) {
+        if (a.name == name) return &a;
+    }
+    return nullptr;
+}
+
+} // namespace dts
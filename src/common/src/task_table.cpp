@@ -0,0 +1,176 @@
+#include "task_table.hpp"
+#include <charconv>
+#include <cmath>
+#include <mutex>
+
+namespace dts {
+
+/* ---------- StringInterner ---------- */
+StringInterner::Id StringInterner::intern(std::string_view s) {
+    {
+        std::shared_lock lk(mu_);
+        auto it = index_.find(s);
+        if (it != index_.end()) return it->second;
+    }
+    std::unique_lock lk(mu_);
+    auto it = index_.find(s);                    // 双检：可能别的线程刚插入
+    if (it != index_.end()) return it->second;
+    const std::string& stored = storage_.emplace_back(s);
+    auto id = static_cast<Id>(storage_.size());  // 从 1 开始编号
+    index_.emplace(std::string_view(stored), id);
+    return id;
+}
+
+StringInterner::Id StringInterner::find(std::string_view s) const {
+    std::shared_lock lk(mu_);
+    auto it = index_.find(s);
+    return it == index_.end() ? kInvalid : it->second;
+}
+
+std::string_view StringInterner::lookup(Id id) const {
+    std::shared_lock lk(mu_);
+    if (id == kInvalid || id > storage_.size()) return {};
+    return storage_[id - 1];
+}
+
+std::size_t StringInterner::size() const {
+    std::shared_lock lk(mu_);
+    return storage_.size();
+}
+
+StringInterner& StringInterner::clients() {
+    static StringInterner instance;
+    return instance;
+}
+
+/* ---------- TaskId ---------- */
+TaskId MakeTaskId(std::string_view s) {
+    TaskId v = 0;
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (ec == std::errc{} && ptr == s.data() + s.size() && v != 0) return v;
+
+    // FNV-1a 64
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h ? h : 1;                            // 0 保留给空槽
+}
+
+/* ---------- TaskHot ---------- */
+namespace {
+std::uint32_t PackDelta(std::int64_t base, std::int64_t ts) {
+    if (ts == 0) return TaskHot::kNoTs;
+    std::int64_t d = ts - base;
+    if (d < 0) d = 0;
+    if (d >= TaskHot::kNoTs) d = TaskHot::kNoTs - 1;   // ~49 天封顶
+    return static_cast<std::uint32_t>(d);
+}
+
+std::uint8_t Saturate8(std::uint32_t v) {
+    return static_cast<std::uint8_t>(std::min<std::uint32_t>(v, UINT8_MAX));
+}
+} // namespace
+
+void TaskHot::set_start_ts(std::int64_t ts)  { start_delta  = PackDelta(submit_ts, ts); }
+void TaskHot::set_finish_ts(std::int64_t ts) { finish_delta = PackDelta(submit_ts, ts); }
+
+/* ---------- TaskTable ---------- */
+TaskTable::Handle TaskTable::insert(const Task& task) {
+    std::uint32_t idx;
+    if (!free_.empty()) {
+        idx = free_.back();
+        free_.pop_back();
+    } else {
+        if (used_ == capacity()) {
+            hot_chunks_.emplace_back(new TaskHot[kChunkSize]);
+            cold_chunks_.emplace_back(new TaskCold[kChunkSize]);
+            generations_.resize(capacity(), 0);
+        }
+        idx = static_cast<std::uint32_t>(used_++);
+    }
+
+    TaskHot& h = hot_at(idx);
+    h.id          = MakeTaskId(task.task_id);
+    h.submit_ts   = task.submit_ts;
+    h.set_start_ts(task.start_ts);
+    h.set_finish_ts(task.finish_ts);
+    h.client      = StringInterner::clients().intern(task.client_id);
+    h.priority    = task.priority;
+    h.timeout_ms  = task.timeout_ms;
+    h.cpu_millis  = static_cast<std::uint32_t>(std::lround(task.required.cpu_core * 1000));
+    h.mem_mb      = static_cast<std::uint32_t>(std::min<std::uint64_t>(task.required.mem_mb, UINT32_MAX));
+    h.state.store(task.state, std::memory_order_relaxed);
+    h.cancelled.store(task.cancelled && task.cancelled->load(), std::memory_order_relaxed);
+    h.retry_count = Saturate8(task.retry_count);
+    h.max_retry   = Saturate8(task.max_retry);
+
+    TaskCold& c = cold_at(idx);
+    c.task_id     = task.task_id;
+    c.func_name   = task.func_name;
+    c.func_params = task.func_params;
+    c.shard       = task.shard;
+    c.result      = task.result;
+    c.error_msg   = task.error_msg;
+    c.inputs      = task.inputs;
+    c.outputs     = task.outputs;
+    c.idempotency_key = task.idempotency_key;
+    c.not_before_ts   = task.not_before_ts;
+    c.recurrence      = task.recurrence;
+    c.parent_ids      = task.parent_ids;
+    c.child_count     = task.child_count;
+
+    ++live_;
+    return Handle{idx, generations_[idx]};
+}
+
+bool TaskTable::erase(Handle h) {
+    if (!valid(h)) return false;
+    TaskHot& hot = hot_at(h.index);
+    hot.id = 0;
+    hot.cancelled.store(false, std::memory_order_relaxed);
+    cold_at(h.index) = TaskCold{};               // 释放 json/string 占用
+    ++generations_[h.index];
+    free_.push_back(h.index);
+    --live_;
+    return true;
+}
+
+TaskHot* TaskTable::hot(Handle h) { return valid(h) ? &hot_at(h.index) : nullptr; }
+const TaskHot* TaskTable::hot(Handle h) const { return valid(h) ? &hot_at(h.index) : nullptr; }
+TaskCold* TaskTable::cold(Handle h) { return valid(h) ? &cold_at(h.index) : nullptr; }
+
+Task TaskTable::materialize(Handle h) const {
+    Task t;
+    if (!valid(h)) return t;
+    const TaskHot& hot = hot_at(h.index);
+    const TaskCold& c  = cold_at(h.index);
+    t.task_id     = c.task_id;
+    t.client_id   = std::string(StringInterner::clients().lookup(hot.client));
+    t.priority    = hot.priority;
+    t.state       = hot.state.load(std::memory_order_relaxed);
+    t.cancelled->store(hot.cancelled.load(std::memory_order_relaxed));
+    t.func_name   = c.func_name;
+    t.func_params = c.func_params;
+    t.required    = Resource{hot.cpu_millis / 1000.0, hot.mem_mb};
+    t.shard       = c.shard;
+    t.timeout_ms  = hot.timeout_ms;
+    t.max_retry   = hot.max_retry;
+    t.retry_count = hot.retry_count;
+    t.submit_ts   = hot.submit_ts;
+    t.start_ts    = hot.start_ts();
+    t.finish_ts   = hot.finish_ts();
+    t.result      = c.result;
+    t.error_msg   = c.error_msg;
+    t.inputs      = c.inputs;
+    t.outputs     = c.outputs;
+    t.idempotency_key = c.idempotency_key;
+    t.not_before_ts   = c.not_before_ts;
+    t.recurrence      = c.recurrence;
+    t.parent_ids      = c.parent_ids;
+    t.child_count     = c.child_count;
+    return t;
+}
+
+} // namespace dts
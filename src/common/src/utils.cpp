@@ -4,8 +4,10 @@ namespace dts {
 
 void JsonToStruct(const json& j, google::protobuf::Struct* proto) {
     proto->Clear();
+    auto& fields = *proto->mutable_fields();
     for (auto& [k, v] : j.items()) {
-        google::protobuf::Value pv;
+        // 直接在 map 里构造，消息在 arena 上时不会多一次堆分配 + 拷贝
+        google::protobuf::Value& pv = fields[k];
         if (v.is_boolean())       pv.set_bool_value(v);
         else if (v.is_number())   pv.set_number_value(v);
         else if (v.is_string())   pv.set_string_value(v);
@@ -13,7 +15,6 @@ void JsonToStruct(const json& j, google::protobuf::Struct* proto) {
         else if (v.is_array() || v.is_object()) {
             JsonToStruct(v, pv.mutable_struct_value());
         }
-        (*proto->mutable_fields())[k] = std::move(pv);
     }
 }
 
@@ -31,8 +32,65 @@ json StructToJson(const google::protobuf::Struct& proto) {
     return j;
 }
 
-PbTask TaskToProto(const Task& task) {
-    PbTask proto;
+namespace {
+
+using PbAttachment = ::dts::proto::Attachment;
+using PbAttachments = google::protobuf::RepeatedPtrField<PbAttachment>;
+
+void AttachmentsToProto(const std::vector<Attachment>& list, PbAttachments* out) {
+    out->Reserve(static_cast<int>(list.size()));
+    for (const auto& a : list) {
+        PbAttachment* pa = out->Add();
+        pa->set_name(a.name);
+        pa->set_content_type(a.content_type);
+        for (std::size_t i = 0; i < a.data.chunk_count(); ++i) {
+            auto c = a.data.chunk(i);
+            pa->add_chunks(reinterpret_cast<const char*>(c.data()), c.size());
+        }
+    }
+}
+
+// 独占的块直接 move 进 proto（arena 上的 string 也只是接管缓冲区）
+void AttachmentsToProto(std::vector<Attachment>&& list, PbAttachments* out) {
+    out->Reserve(static_cast<int>(list.size()));
+    for (auto& a : list) {
+        PbAttachment* pa = out->Add();
+        pa->set_name(std::move(a.name));
+        pa->set_content_type(std::move(a.content_type));
+        for (std::size_t i = 0; i < a.data.chunk_count(); ++i) {
+            pa->add_chunks(a.data.release_chunk(i));
+        }
+        a.data.clear();
+    }
+}
+
+std::vector<Attachment> AttachmentsFromProto(const PbAttachments& in) {
+    std::vector<Attachment> list;
+    list.reserve(in.size());
+    for (const auto& pa : in) {
+        Attachment a{pa.name(), pa.content_type(), {}};
+        for (const auto& c : pa.chunks()) a.data.append(std::string(c));
+        list.push_back(std::move(a));
+    }
+    return list;
+}
+
+// 接管 proto 里每个块的缓冲区
+std::vector<Attachment> AttachmentsFromProto(PbAttachments* in) {
+    std::vector<Attachment> list;
+    list.reserve(in->size());
+    for (auto& pa : *in) {
+        Attachment a{std::move(*pa.mutable_name()), std::move(*pa.mutable_content_type()), {}};
+        for (auto& c : *pa.mutable_chunks()) a.data.append(std::move(c));
+        list.push_back(std::move(a));
+    }
+    return list;
+}
+
+} // namespace
+
+void TaskToProto(const Task& task, PbTask* out) {
+    PbTask& proto = *out;
     proto.set_task_id(task.task_id);
     proto.set_client_id(task.client_id);
     proto.set_priority(task.priority);
@@ -54,6 +112,41 @@ PbTask TaskToProto(const Task& task) {
 
     JsonToStruct(task.result, proto.mutable_result());
     proto.set_error_msg(task.error_msg);
+    proto.set_idempotency_key(task.idempotency_key);
+    proto.set_not_before_ts(task.not_before_ts);
+    proto.set_recurrence(task.recurrence);
+    for (const auto& id : task.parent_ids) proto.add_parent_ids(id);
+    proto.set_child_count(task.child_count);
+    AttachmentsToProto(task.inputs, proto.mutable_inputs());
+    AttachmentsToProto(task.outputs, proto.mutable_outputs());
+}
+
+PbTask* TaskToProto(const Task& task, google::protobuf::Arena* arena) {
+    auto* proto = google::protobuf::Arena::CreateMessage<PbTask>(arena);
+    TaskToProto(task, proto);
+    return proto;
+}
+
+void TaskToProto(Task&& task, PbTask* out) {
+    // 附件先搬走，剩下的标量/JSON 字段走普通路径
+    std::vector<Attachment> inputs  = std::move(task.inputs);
+    std::vector<Attachment> outputs = std::move(task.outputs);
+    task.inputs.clear();
+    task.outputs.clear();
+    TaskToProto(static_cast<const Task&>(task), out);
+    AttachmentsToProto(std::move(inputs), out->mutable_inputs());
+    AttachmentsToProto(std::move(outputs), out->mutable_outputs());
+}
+
+PbTask* TaskToProto(Task&& task, google::protobuf::Arena* arena) {
+    auto* proto = google::protobuf::Arena::CreateMessage<PbTask>(arena);
+    TaskToProto(std::move(task), proto);
+    return proto;
+}
+
+PbTask TaskToProto(const Task& task) {
+    PbTask proto;
+    TaskToProto(task, &proto);
     return proto;
 }
 
@@ -80,6 +173,26 @@ Task TaskFromProto(const PbTask& proto) {
 
     task.result      = StructToJson(proto.result());
     task.error_msg   = proto.error_msg();
+    task.idempotency_key = proto.idempotency_key();
+    task.not_before_ts = proto.not_before_ts();
+    task.recurrence  = proto.recurrence();
+    task.parent_ids.assign(proto.parent_ids().begin(), proto.parent_ids().end());
+    task.child_count = proto.child_count();
+    task.inputs      = AttachmentsFromProto(proto.inputs());
+    task.outputs     = AttachmentsFromProto(proto.outputs());
+    return task;
+}
+
+Task TaskFromProto(PbTask&& proto) {
+    // 先把附件摘出来再清空，避免 const 版本再复制一遍。
+    // 不用 RepeatedPtrField::Swap：proto 在 arena 上时跨 arena 的 Swap 会深拷贝
+    auto inputs  = AttachmentsFromProto(proto.mutable_inputs());
+    auto outputs = AttachmentsFromProto(proto.mutable_outputs());
+    proto.clear_inputs();
+    proto.clear_outputs();
+    Task task = TaskFromProto(static_cast<const PbTask&>(proto));
+    task.inputs  = std::move(inputs);
+    task.outputs = std::move(outputs);
     return task;
 }
 
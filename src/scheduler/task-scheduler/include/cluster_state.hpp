@@ -0,0 +1,46 @@
+// cluster_state.hpp
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "scheduling_algorithm.hpp"
+
+namespace dts {
+
+// 多个调度分片共享的节点容量视图（乐观并发）：
+// 权威的剩余量是每节点一组原子计数，预留/归还都是 CAS，不加锁；
+// 分片每轮拿一份只读快照（NodeCapacityIndex）做放置，再逐个 try_reserve 提交，提交失败说明被别的分片抢先，任务回队。
+// 快照按版本懒重建：计数变过且没人在重建时，由第一个发现的读者重建并原子发布，其余读者直接用旧快照。
+class ClusterState {
+public:
+    explicit ClusterState(const NodeCapacityIndex& nodes);   // 取节点集合、容量与当前剩余
+
+    std::shared_ptr<const NodeCapacityIndex> snapshot();
+    bool try_reserve(std::uint32_t node, const Resource& req);
+    void release(std::uint32_t node, const Resource& used);  // 不超过容量
+    void set_schedulable(std::uint32_t node, bool schedulable);
+
+    Resource free(std::uint32_t node) const;
+    std::size_t size() const { return base_.size(); }
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    // CPU 以千分之一核计，便于整数 CAS
+    static std::int64_t Milli(double cores) { return static_cast<std::int64_t>(cores * 1000.0 + 0.5); }
+
+    struct alignas(64) Slot {
+        std::atomic<std::int64_t>  cpu_milli{0};
+        std::atomic<std::uint64_t> mem_mb{0};
+        std::atomic<bool>          schedulable{true};
+    };
+
+    const NodeCapacityIndex   base_;                 // 只用其中的 node_id 与容量
+    std::unique_ptr<Slot[]>   slots_;
+    std::atomic<std::uint64_t> version_{0};
+    std::atomic<std::shared_ptr<const NodeCapacityIndex>> snapshot_;
+    std::atomic<std::uint64_t> snapshot_version_{0};
+    std::atomic<bool>          rebuilding_{false};
+};
+
+} // namespace dts
@@ -0,0 +1,37 @@
+// cron_spec.hpp
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace dts {
+
+// Task::recurrence 的解析结果。两种写法：
+//   "@every 90s"：固定间隔，单位 ms/s/m/h；
+//   "*/15 9-18 * * 1-5"：标准 5 段 cron（分 时 日 月 周，UTC），支持 * a a-b */n a-b/n 和逗号列表，周日可写 0 或 7。
+// 日与周都受限时按 cron 惯例取“或”。
+class CronSpec {
+public:
+    static constexpr std::int64_t kNever = INT64_MAX;
+
+    static std::optional<CronSpec> Parse(std::string_view spec);
+
+    // 严格晚于 after_ms 的下一次触发时间（Unix 毫秒）；五年内都不触发（如 2 月 30 日）返回 kNever
+    std::int64_t next_after(std::int64_t after_ms) const;
+
+private:
+    bool DayMatches(unsigned dom, unsigned month, unsigned dow) const;
+
+    std::int64_t      every_ms_ = 0;   // > 0 时为固定间隔
+    std::bitset<60>   minute_;
+    std::bitset<24>   hour_;
+    std::bitset<32>   dom_;            // 1..31
+    std::bitset<13>   month_;          // 1..12
+    std::bitset<7>    dow_;            // 0 = 周日
+    bool              dom_any_ = true;
+    bool              dow_any_ = true;
+};
+
+} // namespace dts
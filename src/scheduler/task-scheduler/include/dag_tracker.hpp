@@ -0,0 +1,84 @@
+// dag_tracker.hpp
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+#include "string_hash.hpp"
+#include "scheduling_algorithm.hpp"
+
+namespace dts {
+
+// 依赖图跟踪：一次提交一整张 DAG（parent_ids 只能指向同一次提交里的任务），
+// 上游未全部成功的任务留在这里，不进调度队列。
+// 每个节点一个原子入度，上游结束时 fetch_sub，减到 0 的那一方负责放出该节点——完成路径只拿共享锁。
+// 关键路径优先：提交时按逆拓扑序算每个节点到汇点的最长路径（rank），
+// 每个节点的“关键子节点”是 rank 最大的那个；从 rank 最大的根沿关键子节点走下去的链上，
+// 任务优先级加一档，同一次放出的任务按 rank 从大到小排。
+class DagTracker {
+public:
+    // 任务的估计耗时，用于算 rank；默认每个任务记 1，即按层数算
+    using CostFunc = std::function<double(const Task&)>;
+
+    struct Ready {
+        Task          task;
+        std::uint32_t hint = NodeCapacityIndex::kNoNode;   // 关键上游跑在哪个节点，下游尽量跟过去取本地结果
+    };
+
+    explicit DagTracker(CostFunc cost = {});
+    ~DagTracker();
+
+    DagTracker(const DagTracker&) = delete;
+    DagTracker& operator=(const DagTracker&) = delete;
+
+    // 入度为 0 的任务追加到 ready（按 rank 降序），其余留下。
+    // id 重复、与在册任务冲突、上游不在本次提交里或有环时整批拒绝，返回 false
+    bool submit(std::vector<Task> tasks, std::vector<Ready>& ready);
+    // 上游结束：success 时入度减到 0 的下游追加到 ready；失败时所有下游（含传递）的 id 追加到 skipped。
+    // 不在册（非 DAG 任务或已结束）返回 false
+    bool complete(std::string_view task_id, bool success, std::uint32_t node,
+                  std::vector<Ready>& ready, std::vector<std::string>& skipped);
+    // 取消尚未放出的任务；已放出或不在册返回 false。下游在其余上游都结束时才确定跳过，
+    // 届时由那次 complete / cancel 把 id 追加到 skipped
+    bool cancel(std::string_view task_id, std::vector<std::string>& skipped);
+
+    std::size_t size() const;                               // 在册节点数（含已放出、尚未结束的）
+
+private:
+    enum : std::uint8_t { kHeld, kReleased, kFinished };
+
+    // 上游结束后下游的入度仍可能未减完，节点要等入度归零且自身结束才能删，免得上游拿着悬空指针
+    struct Node {
+        std::string                id;
+        Task                       task;             // 放出前持有
+        std::vector<Node*>         children;         // 提交后不再改动
+        Node*                      critical_child = nullptr;
+        double                     rank = 0;
+        bool                       on_critical = false;
+        std::atomic<std::uint32_t> indegree{0};
+        std::atomic<std::uint32_t> hint{NodeCapacityIndex::kNoNode};
+        std::atomic<bool>          failed{false};    // 有上游失败，入度归零时不放出而是跳过
+        std::atomic<std::uint8_t>  status{kHeld};
+    };
+
+    // 调用方持有 mu_（共享或独占）；返回的节点只在持锁期间有效
+    Node* FindLocked(std::string_view task_id) const;
+    // from 已结束（ok 为是否成功）：逐个下游减入度，归零的放出或跳过，跳过的继续向下传
+    void Propagate(Node& from, bool ok, std::uint32_t node, std::vector<Ready>& ready,
+                   std::vector<std::string>& skipped, std::vector<Node*>& done);
+    static void ReleaseAll(std::vector<Node*>& nodes, std::vector<Ready>& ready);
+    void Erase(const std::vector<Node*>& done);
+
+    CostFunc cost_;
+    mutable std::shared_mutex mu_;
+    std::unordered_map<std::string, std::unique_ptr<Node>, StringHash, std::equal_to<>> nodes_;
+};
+
+} // namespace dts
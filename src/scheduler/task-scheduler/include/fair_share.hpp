@@ -0,0 +1,101 @@
+// fair_share.hpp
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task_queue.hpp"
+#include "string_hash.hpp"
+
+namespace dts {
+
+struct TenantConfig {
+    double   weight = 1.0;     // 份额权重，每轮额度 = quantum * weight；必须为正
+    Resource quota;            // 同时占用的上限，某一维为 0 表示该维不限
+};
+
+struct FairShareOptions {
+    Resource unit{1.0, 1024};  // 计费单位：任务成本 = max(cpu / unit.cpu, mem / unit.mem)（主导资源）
+    double   quantum = 8.0;    // 权重 1 的租户每轮的额度（单位数）；非正时按默认值
+    double   min_cost = 0.05;  // 零需求任务也要计费，防止一轮取空一个租户
+};
+
+// 按 client_id 分租户的加权公平队列：每个租户一个 TaskQueue（租户内仍按优先级），
+// 租户之间做赤字轮转（DRR），成本按主导资源计，额度可以透支、下一轮还。
+// 只有排队中的、未超额度的租户挂在轮转环上，取一个任务 O(1)，与租户总数无关；
+// 提交只在租户从空变非空时碰一次环锁。超额度的租户摘环，release 降回额度内再挂回去。
+// 占用在 drain 时计入，回队（requeue）退还，任务结束由 release 扣除。
+class FairShareQueue {
+public:
+    explicit FairShareQueue(FairShareOptions options = {});
+    ~FairShareQueue();
+
+    FairShareQueue(const FairShareQueue&) = delete;
+    FairShareQueue& operator=(const FairShareQueue&) = delete;
+
+    // 权重不为正（含 NaN）时拒绝，返回 false，原配置不变——这样的租户永远攒不出额度
+    bool set_tenant(std::string_view client_id, const TenantConfig& config);
+
+    bool push(Task task);                              // 同租户内同 id 仍在排队时返回 false
+    // 按 task_id 取消；不知道租户，逐个租户查（租户数远小于任务数，且不在派发路径上）
+    bool cancel(std::string_view task_id);
+    // 按 DRR 取至多 max 个追加到 out，返回取到的个数
+    std::size_t drain(std::vector<Task>& out, std::size_t max);
+    // drain 出来但没下发的任务放回原租户，退还额度与占用
+    void requeue(Task task);
+    // 按 DRR 取走至多 max 个交给别的队列，不计本队列的额度与占用
+    std::size_t steal(std::vector<Task>& out, std::size_t max);
+    // 已下发的任务结束，归还该租户的占用
+    void release(std::string_view client_id, const Resource& used);
+
+    std::size_t size() const { return size_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+    Resource in_use(std::string_view client_id) const;
+    double cost(const Resource& r) const;
+
+private:
+    struct Tenant {
+        std::string  client_id;
+        TenantConfig config;
+        TaskQueue    queue;
+        // 以下在 ring_mu_ 内读写
+        Resource     in_use;
+        double       deficit = 0;
+        bool         credited = false;     // 本轮已加过额度
+        bool         linked = false;
+        bool         throttled = false;
+        Tenant*      prev = nullptr;
+        Tenant*      next = nullptr;
+        // 有任务排队且已有人负责把它挂环（或它在环上/因超额度摘环）
+        std::atomic<bool> active{false};
+    };
+
+    Tenant& TenantFor(std::string_view client_id);
+    Tenant* Find(std::string_view client_id) const;
+    bool OverQuota(const Tenant& t) const;
+    void Activate(Tenant& t);
+    void LinkLocked(Tenant& t);
+    void UnlinkLocked(Tenant& t);
+    void RefundLocked(Tenant& t, const Resource& r);
+    // 环上租户都透支时，给每个租户补上 k 轮额度，k 取让最先回正的租户下一轮就能取任务的轮数
+    bool SkipIdleRoundsLocked();
+
+    FairShareOptions options_;
+    mutable std::shared_mutex tenants_mu_;
+    std::unordered_map<std::string, std::unique_ptr<Tenant>, StringHash, std::equal_to<>> tenants_;
+
+    mutable std::mutex ring_mu_;
+    Tenant* head_ = nullptr;                           // 轮转环（双向链表，头部是当前轮到的租户）
+    Tenant* tail_ = nullptr;
+    std::size_t ring_size_ = 0;
+    std::atomic<std::size_t> size_{0};
+};
+
+} // namespace dts
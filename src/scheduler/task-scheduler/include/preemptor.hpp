@@ -0,0 +1,87 @@
+// preemptor.hpp
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+#include "string_hash.hpp"
+#include "scheduling_algorithm.hpp"
+
+namespace dts {
+
+struct PreemptionOptions {
+    bool          enabled       = false;
+    std::uint32_t min_priority  = 4;      // 只为这个优先级及以上的任务抢占
+    std::uint32_t min_gap       = 2;      // 受害者的优先级至少低这么多档，免得相近的任务来回抢
+    std::int64_t  grace_ms      = 0;      // 自 submit_ts 起放不下这么久才抢，给自然空出的资源一个机会
+    std::size_t   max_per_cycle = 16;     // 每轮最多为这么多任务挑受害者
+};
+
+// 抢占：跟踪已下发的任务。高优先级任务放不下时，在一个节点上挑一组低优先级的在跑任务中止——
+// 先挑优先级最低的，同级先挑跑得最短的（丢掉的进度最少），凑够空间即止；各节点比较后取代价最小的。
+// 空出的资源记为该任务的 claim：受害者全部退出前节点不接别的任务，之后该任务优先在这里预留。
+// 受害者经 cancelled 标志（及调度器的取消钩子）收到信号，结束时原样回队：retry_count 不变，
+// 执行端交回的 result["checkpoint"] 放进 func_params["checkpoint"] 供重跑时续上。
+class Preemptor {
+public:
+    struct Stats {
+        std::uint64_t preempted = 0;   // 发出抢占信号的任务数
+        std::uint64_t requeued  = 0;   // 被抢占后回队的任务数（抢占前已成功的不算）
+        std::uint64_t claims    = 0;   // 为之抢占过的任务数
+    };
+    struct Victim {
+        std::uint32_t node;
+        std::string   task_id;
+    };
+
+    explicit Preemptor(PreemptionOptions options);
+
+    const PreemptionOptions& options() const { return options_; }
+    // 下发时登记；该任务的 claim 随之了结（不论放在哪个节点）
+    void on_dispatch(std::uint32_t node, const Task& task, std::int64_t now_ms);
+    // 已下发的任务结束。是被抢占且未成功的返回要回队的任务（新取消标志、带 checkpoint），否则返回空
+    std::optional<Task> on_finish(const Task& task);
+    // task 放不下时调用：选中一组受害者则置其取消标志、追加到 out，返回 true。
+    // 该任务已有未了结的 claim 时不再抢，返回 false
+    bool preempt(const Task& task, const NodeCapacityIndex& nodes, std::int64_t now_ms, std::vector<Victim>& out);
+
+    // 有 claim 的任务应预留的节点；没有返回 kNoNode
+    std::uint32_t claim(std::string_view task_id) const;
+    void drop_claim(std::string_view task_id);
+    // 受害者还没退完的节点，追加到 out
+    void claimed_nodes(std::vector<std::uint32_t>& out) const;
+    bool has_claims() const;
+
+    std::size_t running() const;
+    Stats stats() const;
+
+private:
+    struct Entry {
+        Task          task;                          // 下发时的任务，被抢占后据此回队
+        std::uint32_t node = NodeCapacityIndex::kNoNode;
+        std::int64_t  start_ms = 0;
+        std::string   claimant;                      // 非空表示已被抢占，空出的资源归这个任务
+    };
+    struct Claim {
+        std::uint32_t node = NodeCapacityIndex::kNoNode;
+        std::uint32_t pending = 0;                   // 尚未退出的受害者数
+    };
+
+    void UnlinkLocked(Entry* e);
+
+    PreemptionOptions options_;
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, std::unique_ptr<Entry>, StringHash, std::equal_to<>> running_;
+    std::vector<std::vector<Entry*>> on_node_;       // 节点下标 -> 在跑任务
+    std::unordered_map<std::string, Claim, StringHash, std::equal_to<>> claims_;
+    std::vector<Entry*> scratch_;                    // 选受害者时复用
+    Stats stats_;
+};
+
+} // namespace dts
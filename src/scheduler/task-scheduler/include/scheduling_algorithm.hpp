@@ -0,0 +1,148 @@
+// scheduling_algorithm.hpp
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "task.hpp"
+
+namespace dts {
+
+// 节点容量索引：按剩余 (cpu, mem) 量化成 kLevels x kLevels 个桶，
+// 每行/每列一个位图，找“放得下的最紧节点”只需在位图上跳，不必逐个扫描节点。
+// 量级步长由构造时给定的最大节点规格决定，超出的并入最高一级。非线程安全。
+class NodeCapacityIndex {
+public:
+    static constexpr std::size_t  kLevels = 64;     // 每维级数，正好一个 uint64 位图
+    static constexpr std::size_t  kBoundaryProbes = 8;   // 边界桶里最多逐个比较的节点数
+    static constexpr std::uint32_t kNoNode = UINT32_MAX;
+
+    struct Node {
+        std::string   node_id;
+        Resource      capacity;
+        Resource      free;
+        bool          schedulable = true;
+        std::uint8_t  cpu_level = 0;                 // 以下为索引内部位置
+        std::uint8_t  mem_level = 0;
+        std::uint32_t slot = 0;
+    };
+
+    explicit NodeCapacityIndex(const Resource& max_node);
+
+    // 新节点剩余 = 容量，返回节点下标（稳定，不复用）
+    std::uint32_t add_node(std::string node_id, const Resource& capacity);
+    void set_free(std::uint32_t node, const Resource& free);
+    void set_schedulable(std::uint32_t node, bool schedulable);
+
+    // 放得下 req 的节点中剩余 CPU 最少者（同级再比内存）；没有返回 kNoNode。
+    // 与需求同级的桶只抽查，可能漏掉个别刚好放得下的节点，换取每次查找 O(kLevels^2) 封顶
+    std::uint32_t best_fit(const Resource& req) const;
+    bool reserve(std::uint32_t node, const Resource& req);    // 放不下时不改动
+    // 同一桶内的挑选起点。共享集群视图的多个调度分片各用不同的值，免得从同一快照挑中同一个节点
+    void set_tiebreak(std::uint32_t salt) { salt_ = salt; }
+    void release(std::uint32_t node, const Resource& req);    // 不超过容量
+
+    const Node& node(std::uint32_t i) const { return nodes_[i]; }
+    std::size_t size() const { return nodes_.size(); }
+    const Resource& largest() const { return largest_; }      // 各维的最大节点容量
+    static bool Fits(const Resource& free, const Resource& req) {
+        return req.cpu_core <= free.cpu_core && req.mem_mb <= free.mem_mb;
+    }
+
+private:
+    std::size_t CpuLevel(double cpu) const;
+    std::size_t MemLevel(std::uint64_t mem) const;
+    void Link(std::uint32_t i);
+    void Unlink(std::uint32_t i);
+
+    double cpu_step_;
+    double mem_step_;
+    std::vector<Node> nodes_;
+    Resource largest_;
+    std::vector<std::vector<std::uint32_t>> buckets_;          // [cpu_level * kLevels + mem_level]
+    std::uint32_t salt_ = 0;
+    std::uint64_t rows_ = 0;                                    // 非空的 cpu 级
+    std::array<std::uint64_t, kLevels> cols_{};                 // 每个 cpu 级里非空的 mem 级
+};
+
+// 调度算法接口：一次为一批任务选节点，选中即在索引上预留资源
+class SchedulingAlgorithm {
+public:
+    virtual ~SchedulingAlgorithm() = default;
+    virtual const char* name() const = 0;
+
+    // out 重置为 tasks.size() 个元素，out[i] 为 tasks[i] 的节点下标，放不下为 kNoNode；
+    // 返回放下的任务数
+    virtual std::size_t place(std::span<const Task> tasks, NodeCapacityIndex& nodes,
+                              std::vector<std::uint32_t>& out) = 0;
+};
+
+// 多维装箱：高优先级先放，同优先级按主导份额（cpu/mem 占最大节点的较大比例）从大到小，
+// 每个任务放进放得下的最紧节点（best-fit decreasing）。O(n log n + n * kLevels)。
+class BinPackingAlgorithm : public SchedulingAlgorithm {
+public:
+    const char* name() const override { return "bin-packing"; }
+    std::size_t place(std::span<const Task> tasks, NodeCapacityIndex& nodes,
+                      std::vector<std::uint32_t>& out) override;
+
+private:
+    std::vector<std::uint32_t> order_;                          // 复用，避免每批分配
+    std::vector<double> share_;
+};
+
+// 局部性键：同一个 func_name + shard_id 的任务反复处理同一份数据
+std::uint64_t DefaultLocalityKey(const Task& task);
+
+// 局部性优先：同一个键尽量落在同一节点，让重跑命中热缓存。
+// 键先查“最近在哪个节点跑过”，再落到一致性哈希环上顺时针找；
+// 有界负载（bounded-load consistent hashing）：节点占用份额超过 load_factor 倍集群平均就跳过，
+// 热门键会溢出到环上相邻节点而不是压垮一个节点。环上探测 max_probes 个虚拟节点仍无果时退回 best-fit。
+class LocalityAwareAlgorithm : public SchedulingAlgorithm {
+public:
+    using KeyFunc = std::function<std::uint64_t(const Task&)>;
+
+    struct Options {
+        double        load_factor = 1.25;
+        std::uint32_t vnodes      = 64;       // 每个节点在环上的虚拟节点数
+        std::uint32_t max_probes  = 64;
+        std::size_t   recent_slots = 1 << 14; // “键 → 最近节点”直接映射表的槽数（2 的幂）
+    };
+    struct Stats {
+        std::uint64_t recent_hits = 0;        // 落在上次跑过该键的节点
+        std::uint64_t ring_home   = 0;        // 落在键在环上的第一个节点
+        std::uint64_t spilled     = 0;        // 因容量/负载上限顺延到环上后续节点
+        std::uint64_t fallback    = 0;        // 环上探测无果，退回 best-fit
+    };
+
+    LocalityAwareAlgorithm();
+    explicit LocalityAwareAlgorithm(Options options, KeyFunc key = DefaultLocalityKey);
+
+    const char* name() const override { return "locality"; }
+    std::size_t place(std::span<const Task> tasks, NodeCapacityIndex& nodes,
+                      std::vector<std::uint32_t>& out) override;
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Recent {
+        std::uint64_t key  = 0;
+        std::uint32_t node = NodeCapacityIndex::kNoNode;
+    };
+
+    void RebuildRing(const NodeCapacityIndex& nodes);
+    static double Share(const NodeCapacityIndex::Node& n);
+
+    Options options_;
+    KeyFunc key_;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> ring_;   // (哈希, 节点) 按哈希排序
+    std::size_t ring_nodes_ = 0;                                  // 建环时的节点数，变了就重建
+    std::vector<Recent> recent_;
+    std::vector<double> share_;                                   // 本批内各节点的占用份额
+    std::vector<std::uint32_t> order_;
+    Stats stats_;
+};
+
+} // namespace dts
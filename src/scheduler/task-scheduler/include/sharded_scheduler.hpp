@@ -0,0 +1,61 @@
+// sharded_scheduler.hpp
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "task_scheduler.hpp"
+
+namespace dts {
+
+struct ShardedSchedulerOptions {
+    std::size_t      shards = 4;
+    bool             work_stealing = true;
+    SchedulerOptions scheduler;              // 每个分片的 TaskScheduler 参数
+};
+
+// 分片调度：每个分片是一个独立运行的 TaskScheduler，按 task_id 的哈希分区拥有任务；
+// 所有分片共享同一个 ClusterState（原子计数 + 快照），放置冲突由各分片的提交步骤兜底。
+// 本分片队列空时，从积压最多的分片偷至多半个批次。
+// 跨进程部署时各进程按 OwnerOf 只接自己的分区，但容量视图仍是进程内的，需各自分到不相交的节点。
+class ShardedScheduler {
+public:
+    // 与 TaskScheduler::DispatchFunc 相同，多带分片号（release 时要回到同一分片）
+    using DispatchFunc = std::function<void(std::size_t shard, std::uint32_t node, const std::string& node_id,
+                                            std::vector<Task>&&)>;
+    using AlgorithmFactory = std::function<std::unique_ptr<SchedulingAlgorithm>()>;
+
+    ShardedScheduler(AlgorithmFactory make_algorithm, const NodeCapacityIndex& nodes, DispatchFunc dispatch,
+                     ShardedSchedulerOptions options = {});
+    ~ShardedScheduler();
+
+    static std::size_t OwnerOf(std::string_view task_id, std::size_t shards);
+
+    bool submit(Task task);
+    // 整张 DAG 归第一个任务 id 所属的分片跟踪；下游放出后同样可能被偷走
+    bool submit_dag(std::vector<Task> tasks);
+    bool cancel(std::string_view task_id);              // 先查所属分片，任务可能已被偷走，再查其余分片
+    void release(std::size_t shard, std::uint32_t node, const Resource& used, std::string_view client_id = {});
+    // 任务结束：在下发它的分片归还资源、做推测执行记账，再到跟踪它的分片推进 DAG
+    std::vector<std::string> finish(std::size_t shard, std::uint32_t node, const Task& task);
+    bool set_tenant(std::string_view client_id, const TenantConfig& config);   // 配额按分片各自计；权重不为正时拒绝
+
+    void start();
+    void stop();
+
+    std::size_t shards() const { return shards_.size(); }
+    TaskScheduler& shard(std::size_t i) { return *shards_[i]; }
+    ClusterState& cluster() { return *cluster_; }
+    std::size_t pending() const;
+    TaskScheduler::Stats stats() const;                 // 各分片之和，last_cycle_us 取最大
+
+private:
+    std::size_t StealFor(std::size_t thief, std::vector<Task>& out, std::size_t max);
+
+    std::shared_ptr<ClusterState> cluster_;
+    std::vector<std::unique_ptr<TaskScheduler>> shards_;
+};
+
+} // namespace dts
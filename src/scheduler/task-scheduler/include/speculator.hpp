@@ -0,0 +1,128 @@
+// speculator.hpp
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+#include "task_table.hpp"
+#include "string_hash.hpp"
+
+namespace dts {
+
+struct SpeculationOptions {
+    bool          enabled       = false;
+    double        percentile    = 0.9;     // 参照同 func_name 历史耗时的这个分位
+    double        slowdown      = 1.5;     // 已跑时长超过分位耗时的这个倍数才算掉队
+    std::uint32_t min_samples   = 20;      // 样本太少的函数不推测
+    std::int64_t  min_elapsed_ms = 100;    // 跑得再慢也先等这么久，免得给短任务白发副本
+    double        max_fraction  = 0.1;     // 同时在跑的副本不超过在跑任务的这个比例
+    std::chrono::milliseconds scan_interval{100};
+    std::chrono::milliseconds slow_node_ttl{30000};  // 节点上出现掉队任务后这么久内不往上放副本
+};
+
+// 按 func_name 统计耗时分布：对数分桶直方图（每个 2 的幂分 4 桶，相对误差约 19%），
+// 记一次 O(1)，查分位 O(桶数)，与样本数无关。每满 decay_every 个样本各桶减半，让分布跟上最近的情况。
+class RuntimeStats {
+public:
+    static constexpr std::size_t kSubBuckets = 4;
+    static constexpr std::size_t kBuckets = 40 * kSubBuckets;   // 覆盖 1ms 到约 2^40ms
+
+    explicit RuntimeStats(std::uint32_t decay_every = 4096) : decay_every_(decay_every) {}
+
+    void record(std::string_view func_name, std::int64_t runtime_ms);
+    // 样本不足 min_samples 时返回空；结果取所在桶的上界
+    std::optional<std::int64_t> percentile(std::string_view func_name, double p,
+                                           std::uint32_t min_samples = 1) const;
+
+private:
+    struct Histogram {
+        std::array<std::uint32_t, kBuckets> counts{};
+        std::uint32_t total = 0;
+        std::uint32_t since_decay = 0;
+    };
+
+    static std::size_t BucketOf(std::int64_t ms);
+    static std::int64_t UpperBound(std::size_t bucket);
+
+    std::uint32_t decay_every_;
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, Histogram, StringHash, std::equal_to<>> funcs_;
+};
+
+// 推测执行：跟踪已下发的任务，跑得明显比同函数的历史分位慢时在另一个节点发一个副本，
+// 副本 id 为 "<task_id>~spec"、带独立的取消标志。两份谁先成功算谁，另一份经 cancelled 标志中止；
+// 一份失败而另一份还在跑时不作数，等另一份的结果。两份都报告结束后才忘掉该任务。
+class Speculator {
+public:
+    static constexpr std::string_view kSuffix = "~spec";
+
+    struct Stats {
+        std::uint64_t launched  = 0;   // 发出的副本数
+        std::uint64_t won       = 0;   // 副本先成功：推测起了作用
+        std::uint64_t lost      = 0;   // 原任务先成功，副本白跑
+        std::uint64_t abandoned = 0;   // 副本没找到别的节点放，下次再试
+    };
+    // 结束的一份对外是否作数；作数且另一份还在跑时，loser 给出要中止的那份
+    struct Outcome {
+        bool          counts = true;
+        std::string   task_id;                       // 原任务 id（副本去掉后缀）
+        std::uint32_t loser_node = UINT32_MAX;
+        std::string   loser_id;                      // 为空表示没有要中止的
+    };
+
+    explicit Speculator(SpeculationOptions options);
+
+    const SpeculationOptions& options() const { return options_; }
+    // 下发前调用。副本的原任务已有结果时返回 false，调用方不再下发它、归还其资源
+    bool on_dispatch(std::uint32_t node, const Task& task, std::int64_t now_ms);
+    // 掉队任务的副本追加到 out，返回个数；avoid 追加近期出过掉队任务的节点，副本不往那里放
+    std::size_t scan(std::int64_t now_ms, std::vector<Task>& out, std::vector<std::uint32_t>& avoid);
+    void abandon(std::string_view copy_id);          // 副本没放下去，恢复为可再推测
+    Outcome on_finish(std::uint32_t node, const Task& task, std::int64_t now_ms);
+
+    std::size_t running() const;
+    Stats stats() const;
+    const RuntimeStats& runtimes() const { return runtimes_; }
+
+private:
+    struct Copy {
+        std::uint32_t node = UINT32_MAX;
+        std::int64_t  start_ms = 0;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        bool          live = false;                  // 已下发、尚未报告结束
+        bool          done = false;                  // 已报告结束（或副本被放弃）
+    };
+    struct Entry {
+        Copy  copies[2];                             // [0] 原任务，[1] 推测副本
+        bool  speculated = false;
+        bool  settled = false;                       // 已有一份作数
+    };
+    using Index = std::unordered_map<std::string, TaskTable::Handle, StringHash, std::equal_to<>>;
+
+    static std::string_view OriginalId(std::string_view id, bool& is_copy);
+    void CopyDoneLocked(Entry& entry);
+    void MaybeEraseLocked(Index::iterator it);
+
+    SpeculationOptions options_;
+    RuntimeStats runtimes_;
+    mutable std::mutex mu_;
+    // 在跑任务放在紧凑任务表里（原任务的副本，生成推测副本用），entries_ 与其槽位一一对应；
+    // 每轮扫描按槽位顺序走，不遍历哈希表
+    TaskTable tasks_;
+    std::vector<Entry> entries_;
+    Index running_;                                  // 原任务 id -> 槽位
+    std::size_t in_flight_ = 0;                      // 在跑的副本数
+    std::unordered_map<std::uint32_t, std::int64_t> slow_nodes_;   // 节点 -> 标记到期时间
+    Stats stats_;
+};
+
+} // namespace dts
@@ -0,0 +1,86 @@
+// task_queue.hpp
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "mpmc_queue.hpp"
+#include "task.hpp"
+
+namespace dts {
+
+// 调度器的待调度队列：按 Task::priority 分 kLanes 条无锁通道（MPMCQueue），数值越大越先出队，
+// 同一通道内先进先出；priority >= kLanes 的并入最高一档。
+// 取消不扫描通道：条目打上墓碑、从索引摘掉，Task 字段当场释放；墓碑在出队时顺带回收。
+// 每个条目的开销固定：一个通道节点 + 一个条目；索引是条目里的侵入式链，不另外分配。
+// 所有接口线程安全。
+class TaskQueue {
+public:
+    static constexpr std::size_t kLanes  = 8;
+    static constexpr std::size_t kShards = 64;      // 索引分片，取消/出队按 task_id 只锁一片
+
+    TaskQueue() = default;
+    ~TaskQueue();
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    // task_id 已在队列中时不入队，返回 false
+    bool push(Task task);
+    // 仍在排队则取消（并置位 Task::cancelled）返回 true；已出队或不存在返回 false
+    bool cancel(std::string_view task_id);
+
+    std::optional<Task> pop();
+    // 最多取 max 个追加到 out，高优先级通道先取；返回取到的个数
+    std::size_t pop_batch(std::vector<Task>& out, std::size_t max);
+
+    bool contains(std::string_view task_id) const;
+    std::size_t size() const { return size_.load(std::memory_order_acquire); }   // 不含墓碑
+    bool empty() const { return size() == 0; }
+    std::size_t lane_depth(std::size_t lane) const {                           // 含未回收的墓碑
+        return lanes_[lane].depth.load(std::memory_order_relaxed);
+    }
+
+    static std::size_t LaneOf(std::uint32_t priority) {
+        return std::min<std::size_t>(priority, kLanes - 1);
+    }
+
+private:
+    struct Entry {
+        Task          task;
+        std::uint64_t hash = 0;                     // task_id 的哈希：高位选分片，低位选桶
+        Entry*        chain = nullptr;              // 同一个桶里的下一个，以下两项在分片锁内读写
+        bool          cancelled = false;
+    };
+    // 分片内是开链哈希表，桶数是 2 的幂，装载因子到 1 时翻倍
+    struct alignas(64) Shard {
+        mutable std::mutex  mu;
+        std::vector<Entry*> buckets;
+        std::size_t         count = 0;
+
+        Entry* find(std::uint64_t hash, std::string_view task_id) const;
+        bool   insert(Entry* e);                    // 已有同 id 时返回 false
+        void   erase(Entry* e);
+    };
+    struct Lane {
+        MPMCQueue<Entry*>        queue;
+        std::atomic<std::size_t> depth{0};
+    };
+
+    static std::uint64_t Hash(std::string_view task_id);
+    Shard& ShardOf(std::uint64_t hash) { return shards_[(hash >> 32) % kShards]; }
+    const Shard& ShardOf(std::uint64_t hash) const { return shards_[(hash >> 32) % kShards]; }
+    // 从通道取一个未取消的条目，调用方负责 delete；通道空返回 nullptr
+    Entry* TakeFrom(Lane& lane);
+
+    std::array<Lane, kLanes>   lanes_;
+    std::array<Shard, kShards> shards_;
+    std::atomic<std::size_t>   size_{0};
+};
+
+} // namespace dts
@@ -0,0 +1,182 @@
+// task_scheduler.hpp
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "scheduling_algorithm.hpp"
+#include "cluster_state.hpp"
+#include "fair_share.hpp"
+#include "timer_index.hpp"
+#include "dag_tracker.hpp"
+#include "speculator.hpp"
+#include "preemptor.hpp"
+
+namespace dts {
+
+struct SchedulerOptions {
+    std::size_t               max_batch    = 4096;                          // 每轮最多取的任务数
+    std::chrono::microseconds min_interval{100};                            // 积压 >= max_batch 时的轮间隔
+    std::chrono::microseconds max_interval{std::chrono::milliseconds(10)};  // 队列空时的轮间隔，即调度延迟上限
+    FairShareOptions          fair_share;                                   // 租户间 DRR 的计费参数
+    std::uint32_t             tiebreak = 0;                                 // 见 NodeCapacityIndex::set_tiebreak
+    std::function<std::int64_t()> clock;                                    // 当前 Unix 毫秒，为空用系统时钟（测试注入）
+    SpeculationOptions        speculation;                                  // 掉队任务的推测执行，默认关闭
+    PreemptionOptions         preemption;                                   // 高优先级任务放不下时抢占，默认关闭
+};
+
+// 批量调度：按轮运行，每轮从 FairShareQueue 按租户公平地取至多 max_batch 个任务，一次性交给 SchedulingAlgorithm 放置，
+// 再按节点分组，每个节点一条消息下发；放不下的任务回队等下一轮。
+// 轮间隔随积压线性缩短：积压越深越快，队列空时退到 max_interval；积压达到 max_batch 时提前唤醒。
+// 节点视图可以独占（NodeCapacityIndex），也可以与其他调度器共享（ClusterState）：
+// 共享时每轮从快照放置，再逐个 try_reserve 提交，冲突的任务回队。
+// 定时（not_before_ts 在未来）与周期（recurrence）任务先进 TimerIndex，每轮开头把到期的批量放进队列；
+// 周期任务本身留作模板，每次触发生成 id 为 "<task_id>#<触发毫秒>" 的一次性实例。
+// 带 parent_ids 的任务由 DagTracker 扣住，上游经 finish() 报告成功后才放进队列，
+// 并优先放到关键上游所在的节点，让执行端直接用本地的上游结果。
+// 开启推测执行时，每隔 scan_interval 找出明显慢于同函数历史分位的在跑任务，在别的节点放一个副本，
+// 先成功的一份作数，另一份经取消钩子（及进程内共享的 cancelled 标志）中止。
+// 开启抢占时，放不下的高优先级任务在一个节点上挑低优先级、进度少的在跑任务经同样的途径中止，
+// 空出的资源留给它；受害者结束后 retry_count 不变地回队（规则见 Preemptor）。
+class TaskScheduler {
+public:
+    // 下发一个节点的一批任务（一条消息）。在调度线程上、不持锁调用，可以在里面 release()
+    using DispatchFunc = std::function<void(std::uint32_t node, const std::string& node_id, std::vector<Task>&&)>;
+
+    struct Stats {
+        std::uint64_t cycles      = 0;
+        std::uint64_t dispatched  = 0;     // 下发的任务数
+        std::uint64_t messages    = 0;     // 下发的消息数（节点批次）
+        std::uint64_t requeued    = 0;     // 放不下回队的次数（含提交冲突）
+        std::uint64_t conflicts   = 0;     // 共享视图下提交预留失败的次数
+        std::uint64_t stolen      = 0;     // 从其他调度器偷来的任务数
+        std::uint64_t fired       = 0;     // 到期进入队列的定时任务与周期实例数
+        std::uint64_t co_located  = 0;     // DAG 下游放在了上游所在节点
+        std::uint64_t speculated  = 0;     // 下发的推测副本数
+        std::uint64_t spec_won    = 0;     // 副本先于原任务成功的次数
+        std::uint64_t preempted   = 0;     // 被抢占的任务数
+        std::uint64_t last_cycle_us = 0;   // 最近一轮取批 + 放置 + 下发的耗时
+    };
+
+    // 本地队列空时向外要任务，返回追加到 out 的个数
+    using StealFunc = std::function<std::size_t(std::vector<Task>& out, std::size_t max)>;
+    // 中止某节点上已下发的任务（推测执行落败的一份、被抢占的任务）；执行端在别的进程时由它发 CancelTask
+    using CancelFunc = std::function<void(std::uint32_t node, const std::string& task_id)>;
+
+    TaskScheduler(std::unique_ptr<SchedulingAlgorithm> algorithm, NodeCapacityIndex nodes,
+                  DispatchFunc dispatch, SchedulerOptions options = {});
+    TaskScheduler(std::unique_ptr<SchedulingAlgorithm> algorithm, std::shared_ptr<ClusterState> cluster,
+                  DispatchFunc dispatch, SchedulerOptions options = {});
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    bool submit(Task task);                              // 同 id 仍在排队时、recurrence 无法解析时返回 false
+    // 一次提交一整张 DAG，parent_ids 只能指向同批任务；规则见 DagTracker::submit。
+    // submit() 遇到带 parent_ids 的任务也转到这里，单个任务的上游不在批内会被拒绝
+    bool submit_dag(std::vector<Task> tasks);
+    // 仅对尚未下发的任务有效；对周期模板即停止后续触发。DAG 任务的下游随之取消，id 追加到 skipped
+    bool cancel(std::string_view task_id, std::vector<std::string>* skipped = nullptr);
+    bool set_tenant(std::string_view client_id, const TenantConfig& config) { return queue_.set_tenant(client_id, config); }
+
+    // 任务结束（成功/失败/取消）后归还节点资源与租户占用
+    void release(std::uint32_t node, const Resource& used, std::string_view client_id = {});
+    // 已下发的任务（含推测副本）结束：归还资源，结果作数时推进 DAG——按 task.state 放出下游，
+    // 失败时返回被连带取消的下游 id
+    std::vector<std::string> finish(std::uint32_t node, const Task& task);
+    // 以下两步是 finish 去掉归还资源后的拆分，供分片调度在不同分片上分别调用。
+    // settle：推测执行与抢占的记账，结果不作数（落败、等另一份、被抢占后已回队）返回空，否则返回原任务 id
+    std::optional<std::string> settle(std::uint32_t node, const Task& task);
+    // 只推进 DAG；task_id 不在本调度器的 DAG 里返回 false（分片时任务可能是偷来的）
+    bool complete(std::uint32_t node, std::string_view task_id, bool success, std::vector<std::string>& skipped);
+    void set_cancel_hook(CancelFunc f) { cancel_ = std::move(f); }   // start() 之前设置
+    // 节点容量视图的更新入口（心跳上报、摘除节点等）；共享视图时改 ClusterState
+    template <class F> void update_nodes(F&& f) {
+        std::lock_guard<std::mutex> lk(nodes_mu_);
+        f(nodes_);
+    }
+
+    // 把至多 max 个排队任务交给别的调度器（工作窃取的被偷方）
+    std::size_t steal(std::vector<Task>& out, std::size_t max) { return queue_.steal(out, max); }
+    void set_steal_source(StealFunc f) { steal_ = std::move(f); }   // start() 之前设置
+
+    // 手动跑一轮，返回下发的任务数；start() 之后由调度线程调用
+    std::size_t run_cycle();
+    void start();
+    void stop();
+
+    std::size_t pending() const { return queue_.size(); }
+    std::size_t delayed() const { return timers_.size(); }   // 未到期的定时任务与周期模板
+    std::size_t in_dag() const { return dag_.size(); }       // DAG 中尚未结束的任务（含等上游的）
+    Speculator::Stats speculation() const { return speculator_ ? speculator_->stats() : Speculator::Stats{}; }
+    Preemptor::Stats preemption() const { return preemptor_ ? preemptor_->stats() : Preemptor::Stats{}; }
+    std::chrono::microseconds interval() const { return std::chrono::microseconds(interval_us_.load()); }
+    Stats stats() const;
+
+private:
+    void Loop();
+    void AdaptInterval();
+    std::int64_t Now() const;
+    void ReleaseDue();
+    bool Admit(Task task);
+    void AdmitReady(std::vector<DagTracker::Ready>& ready);
+    std::size_t PlaceHinted();
+    void PlaceSpeculative(std::int64_t now);
+    void Preempt(std::size_t regular, std::int64_t now);
+    void ReleaseNode(std::uint32_t node, const Resource& used);
+
+    std::unique_ptr<SchedulingAlgorithm> algorithm_;
+    DispatchFunc     dispatch_;
+    StealFunc        steal_;
+    CancelFunc       cancel_;
+    std::shared_ptr<ClusterState> cluster_;   // 为空时 nodes_ 是权威视图，否则是本轮的快照副本
+    SchedulerOptions options_;
+    FairShareQueue   queue_;
+    TimerIndex       timers_;
+    DagTracker       dag_;
+    std::unique_ptr<Speculator> speculator_;            // 未开启推测执行时为空
+    std::unique_ptr<Preemptor>  preemptor_;             // 未开启抢占时为空
+
+    std::mutex       affinity_mu_;
+    std::unordered_map<std::string, std::uint32_t> affinity_;   // 放出的 DAG 下游 -> 关键上游所在节点
+
+    mutable std::mutex nodes_mu_;
+    NodeCapacityIndex  nodes_;
+
+    // 以下只在调度线程（或 run_cycle 调用方）上使用，复用以免每轮分配
+    std::mutex                 cycle_mu_;
+    std::vector<Task>          batch_;
+    std::vector<std::uint32_t> placement_;
+    std::vector<std::uint32_t> by_node_;
+    std::vector<std::string>   node_ids_;
+    std::vector<Task>          due_;
+    std::vector<std::uint32_t> hinted_;
+    std::vector<std::uint32_t> spec_avoid_;
+    std::vector<std::uint32_t> claimed_;
+    std::vector<std::uint32_t> urgent_;
+    std::vector<Preemptor::Victim> victims_;
+    std::int64_t               next_scan_ms_ = 0;
+
+    std::atomic<std::int64_t> interval_us_;
+    std::mutex              wake_mu_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool>       wake_{false};
+    std::atomic<bool>       running_{false};
+    std::thread             thread_;
+
+    std::atomic<std::uint64_t> cycles_{0}, dispatched_{0}, messages_{0}, requeued_{0}, last_cycle_us_{0};
+    std::atomic<std::uint64_t> conflicts_{0}, stolen_{0}, fired_{0}, co_located_{0};
+};
+
+} // namespace dts
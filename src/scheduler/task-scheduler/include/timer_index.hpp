@@ -0,0 +1,55 @@
+// timer_index.hpp
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+#include "string_hash.hpp"
+
+namespace dts {
+
+// 未到期任务的索引：按到期时间的小顶堆，到期前不占 CPU——调度轮只看堆顶，没到期就直接返回。
+// 插入与每个到期任务的弹出 O(log n)；取消只摘登记、在堆里留墓碑，弹到时丢弃，墓碑过半时整体重建。
+// 用堆而不是分层时间轮：到期时间跨度从毫秒到数月（cron），堆不必选槽宽，也没有级联搬移。
+class TimerIndex {
+public:
+    TimerIndex() = default;
+    TimerIndex(const TimerIndex&) = delete;
+    TimerIndex& operator=(const TimerIndex&) = delete;
+
+    // 同 id 已在索引中时返回 false
+    bool schedule(Task task, std::int64_t due_ms);
+    bool cancel(std::string_view task_id);
+    // 到期时间 <= now_ms 的任务按到期先后追加到 out，至多 max 个，返回个数
+    std::size_t release_due(std::int64_t now_ms, std::vector<Task>& out, std::size_t max);
+
+    std::int64_t next_due() const;                    // 最早的到期时间，空时 INT64_MAX
+    std::size_t size() const;
+
+private:
+    struct Item {
+        std::int64_t          due;
+        std::uint64_t         seq;                    // 同一时刻按插入先后
+        std::unique_ptr<Task> task;
+    };
+    struct Later {
+        bool operator()(const Item& a, const Item& b) const {
+            return a.due != b.due ? a.due > b.due : a.seq > b.seq;
+        }
+    };
+
+    void PopTombstonesLocked();
+
+    mutable std::mutex mu_;
+    std::vector<Item>  heap_;
+    // 在册的任务：task_id -> seq；堆里 seq 对不上的是墓碑
+    std::unordered_map<std::string, std::uint64_t, StringHash, std::equal_to<>> live_;
+    std::uint64_t      next_seq_ = 0;
+};
+
+} // namespace dts
@@ -0,0 +1,73 @@
+#include "cluster_state.hpp"
+#include <algorithm>
+
+namespace dts {
+
+ClusterState::ClusterState(const NodeCapacityIndex& nodes)
+    : base_(nodes), slots_(std::make_unique<Slot[]>(nodes.size())) {
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        slots_[i].cpu_milli.store(Milli(nodes.node(i).free.cpu_core), std::memory_order_relaxed);
+        slots_[i].mem_mb.store(nodes.node(i).free.mem_mb, std::memory_order_relaxed);
+        slots_[i].schedulable.store(nodes.node(i).schedulable, std::memory_order_relaxed);
+    }
+    snapshot_.store(std::make_shared<const NodeCapacityIndex>(nodes));
+}
+
+std::shared_ptr<const NodeCapacityIndex> ClusterState::snapshot() {
+    const std::uint64_t v = version_.load(std::memory_order_acquire);
+    if (snapshot_version_.load(std::memory_order_acquire) == v || rebuilding_.exchange(true)) {
+        return snapshot_.load();
+    }
+    auto fresh = std::make_shared<NodeCapacityIndex>(base_);
+    for (std::uint32_t i = 0; i < base_.size(); ++i) {
+        fresh->set_free(i, free(i));
+        fresh->set_schedulable(i, slots_[i].schedulable.load(std::memory_order_relaxed));
+    }
+    snapshot_.store(fresh);
+    snapshot_version_.store(v, std::memory_order_release);
+    rebuilding_.store(false);
+    return fresh;
+}
+
+bool ClusterState::try_reserve(std::uint32_t node, const Resource& req) {
+    Slot& s = slots_[node];
+    if (!s.schedulable.load(std::memory_order_relaxed)) return false;
+    const std::int64_t cpu = Milli(req.cpu_core);
+    std::int64_t have = s.cpu_milli.load(std::memory_order_relaxed);
+    do {
+        if (have < cpu) return false;
+    } while (!s.cpu_milli.compare_exchange_weak(have, have - cpu, std::memory_order_acq_rel));
+    std::uint64_t mem = s.mem_mb.load(std::memory_order_relaxed);
+    do {
+        if (mem < req.mem_mb) {
+            s.cpu_milli.fetch_add(cpu, std::memory_order_acq_rel);   // 内存不够，退回 CPU
+            return false;
+        }
+    } while (!s.mem_mb.compare_exchange_weak(mem, mem - req.mem_mb, std::memory_order_acq_rel));
+    version_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void ClusterState::release(std::uint32_t node, const Resource& used) {
+    Slot& s = slots_[node];
+    const auto& cap = base_.node(node).capacity;
+    const std::int64_t cap_cpu = Milli(cap.cpu_core), cpu = Milli(used.cpu_core);
+    std::int64_t have = s.cpu_milli.load(std::memory_order_relaxed);
+    while (!s.cpu_milli.compare_exchange_weak(have, std::min(cap_cpu, have + cpu), std::memory_order_acq_rel)) {}
+    std::uint64_t mem = s.mem_mb.load(std::memory_order_relaxed);
+    while (!s.mem_mb.compare_exchange_weak(mem, std::min(cap.mem_mb, mem + used.mem_mb), std::memory_order_acq_rel)) {}
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void ClusterState::set_schedulable(std::uint32_t node, bool schedulable) {
+    slots_[node].schedulable.store(schedulable, std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+Resource ClusterState::free(std::uint32_t node) const {
+    const Slot& s = slots_[node];
+    return Resource{static_cast<double>(s.cpu_milli.load(std::memory_order_acquire)) / 1000.0,
+                    s.mem_mb.load(std::memory_order_acquire)};
+}
+
+} // namespace dts
@@ -0,0 +1,142 @@
+#include "cron_spec.hpp"
+#include <charconv>
+#include <string>
+#include <vector>
+
+namespace dts {
+
+namespace {
+
+std::optional<unsigned> ParseUInt(std::string_view s) {
+    unsigned v = 0;
+    auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (ec != std::errc{} || p != s.data() + s.size() || s.empty()) return std::nullopt;
+    return v;
+}
+
+std::vector<std::string_view> Split(std::string_view s, char sep) {
+    std::vector<std::string_view> out;
+    std::size_t start = 0;
+    while (start <= s.size()) {
+        const std::size_t end = s.find(sep, start);
+        if (end == std::string_view::npos) {
+            out.push_back(s.substr(start));
+            break;
+        }
+        out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+// 解析一段 cron 字段到位图，取值范围 [lo, hi]；any 置为该段是否为 "*"
+template <std::size_t N>
+bool ParseField(std::string_view field, unsigned lo, unsigned hi, std::bitset<N>& bits, bool& any) {
+    any = field == "*";
+    for (std::string_view part : Split(field, ',')) {
+        unsigned step = 1;
+        if (auto slash = part.find('/'); slash != std::string_view::npos) {
+            auto s = ParseUInt(part.substr(slash + 1));
+            if (!s || *s == 0) return false;
+            step = *s;
+            part = part.substr(0, slash);
+        }
+        unsigned a = lo, b = hi;
+        if (part != "*") {
+            if (auto dash = part.find('-'); dash != std::string_view::npos) {
+                auto x = ParseUInt(part.substr(0, dash)), y = ParseUInt(part.substr(dash + 1));
+                if (!x || !y) return false;
+                a = *x;
+                b = *y;
+            } else {
+                auto x = ParseUInt(part);
+                if (!x) return false;
+                a = *x;
+                b = step > 1 ? hi : *x;            // "5/15" 等同 "5-hi/15"
+            }
+        }
+        if (a < lo || b > hi || a > b) return false;
+        for (unsigned v = a; v <= b; v += step) bits.set(v);
+    }
+    return true;
+}
+
+// 公历日期与 1970-01-01 起的天数互转（H. Hinnant 的 civil 算法）
+void CivilFromDays(std::int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe) + static_cast<int>(era) * 400 + (m <= 2);
+}
+
+std::int64_t FloorDiv(std::int64_t a, std::int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+
+} // namespace
+
+std::optional<CronSpec> CronSpec::Parse(std::string_view spec) {
+    CronSpec c;
+    if (spec.rfind("@every ", 0) == 0) {
+        std::string_view v = spec.substr(7);
+        std::int64_t unit = 0;
+        if (v.size() > 2 && v.substr(v.size() - 2) == "ms") { unit = 1; v.remove_suffix(2); }
+        else if (!v.empty() && v.back() == 's') { unit = 1000; v.remove_suffix(1); }
+        else if (!v.empty() && v.back() == 'm') { unit = 60'000; v.remove_suffix(1); }
+        else if (!v.empty() && v.back() == 'h') { unit = 3'600'000; v.remove_suffix(1); }
+        auto n = ParseUInt(v);
+        if (!unit || !n || *n == 0) return std::nullopt;
+        c.every_ms_ = static_cast<std::int64_t>(*n) * unit;
+        return c;
+    }
+
+    std::vector<std::string_view> fields;
+    for (auto f : Split(spec, ' ')) {
+        if (!f.empty()) fields.push_back(f);
+    }
+    if (fields.size() != 5) return std::nullopt;
+    bool any = false;
+    std::bitset<8> dow;
+    if (!ParseField(fields[0], 0, 59, c.minute_, any) || !ParseField(fields[1], 0, 23, c.hour_, any) ||
+        !ParseField(fields[2], 1, 31, c.dom_, c.dom_any_) || !ParseField(fields[3], 1, 12, c.month_, any) ||
+        !ParseField(fields[4], 0, 7, dow, c.dow_any_)) {
+        return std::nullopt;
+    }
+    for (unsigned d = 0; d < 7; ++d) c.dow_[d] = dow[d];
+    if (dow[7]) c.dow_.set(0);
+    return c;
+}
+
+bool CronSpec::DayMatches(unsigned dom, unsigned month, unsigned dow) const {
+    if (!month_[month]) return false;
+    if (dom_any_ || dow_any_) return dom_[dom] && dow_[dow];
+    return dom_[dom] || dow_[dow];
+}
+
+std::int64_t CronSpec::next_after(std::int64_t after_ms) const {
+    if (every_ms_ > 0) return after_ms + every_ms_;
+
+    constexpr std::int64_t kMinute = 60'000, kDay = 86'400'000;
+    const std::int64_t first = FloorDiv(after_ms, kMinute) + 1;       // 下一个整分钟
+    std::int64_t day = FloorDiv(first * kMinute, kDay);
+    unsigned minute_of_day = static_cast<unsigned>(first - day * 1440);
+    for (int n = 0; n < 366 * 5; ++n, ++day, minute_of_day = 0) {
+        int y;
+        unsigned m, d;
+        CivilFromDays(day, y, m, d);
+        const unsigned dow = static_cast<unsigned>(((day % 7) + 11) % 7);   // 1970-01-01 是周四
+        if (!DayMatches(d, m, dow)) continue;
+        for (unsigned h = minute_of_day / 60; h < 24; ++h) {
+            if (!hour_[h]) continue;
+            for (unsigned mi = (h == minute_of_day / 60 ? minute_of_day % 60 : 0); mi < 60; ++mi) {
+                if (minute_[mi]) return (day * 1440 + h * 60 + mi) * kMinute;
+            }
+        }
+    }
+    return kNever;
+}
+
+} // namespace dts
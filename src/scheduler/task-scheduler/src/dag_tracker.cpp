@@ -0,0 +1,185 @@
+#include "dag_tracker.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace dts {
+
+DagTracker::DagTracker(CostFunc cost) : cost_(std::move(cost)) {}
+
+DagTracker::~DagTracker() = default;
+
+DagTracker::Node* DagTracker::FindLocked(std::string_view task_id) const {
+    auto it = nodes_.find(task_id);
+    return it == nodes_.end() ? nullptr : it->second.get();
+}
+
+std::size_t DagTracker::size() const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    return nodes_.size();
+}
+
+bool DagTracker::submit(std::vector<Task> tasks, std::vector<Ready>& ready) {
+    const std::size_t n = tasks.size();
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    index.reserve(n);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (!index.emplace(tasks[i].task_id, i).second) return false;
+    }
+
+    // 批内邻接表与入度；上游必须在本批里
+    std::vector<std::vector<std::uint32_t>> children(n);
+    std::vector<std::uint32_t> indegree(n, 0);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        for (const auto& pid : tasks[i].parent_ids) {
+            auto it = index.find(pid);
+            if (it == index.end()) return false;
+            children[it->second].push_back(i);
+            ++indegree[i];
+        }
+    }
+
+    // Kahn 拓扑排序，排不完即有环
+    std::vector<std::uint32_t> order;
+    order.reserve(n);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (indegree[i] == 0) order.push_back(i);
+    }
+    {
+        std::vector<std::uint32_t> left = indegree;
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            for (std::uint32_t c : children[order[k]]) {
+                if (--left[c] == 0) order.push_back(c);
+            }
+        }
+    }
+    if (order.size() != n) return false;
+
+    std::vector<std::unique_ptr<Node>> fresh(n);
+    for (std::uint32_t i = 0; i < n; ++i) fresh[i] = std::make_unique<Node>();
+
+    // 逆拓扑序算 rank 与关键子节点，再从最长的根沿关键子节点标出关键路径
+    Node* top = nullptr;
+    for (auto k = order.rbegin(); k != order.rend(); ++k) {
+        Node& node = *fresh[*k];
+        double longest = 0;
+        for (std::uint32_t c : children[*k]) {
+            Node* child = fresh[c].get();
+            node.children.push_back(child);
+            if (!node.critical_child || child->rank > longest) {
+                node.critical_child = child;
+                longest = child->rank;
+            }
+        }
+        node.rank = (cost_ ? cost_(tasks[*k]) : 1.0) + longest;
+        if (indegree[*k] == 0 && (!top || node.rank >= top->rank)) top = &node;
+    }
+    for (Node* p = top; p; p = p->critical_child) p->on_critical = true;
+
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    for (const auto& t : tasks) {
+        if (nodes_.count(t.task_id)) return false;
+    }
+    std::vector<Node*> roots;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        Node& node = *fresh[i];
+        node.id = tasks[i].task_id;
+        node.indegree.store(indegree[i], std::memory_order_relaxed);
+        node.task = std::move(tasks[i]);
+        node.task.child_count = static_cast<std::uint32_t>(node.children.size());
+        if (indegree[i] == 0) {
+            node.status.store(kReleased, std::memory_order_relaxed);   // 还在锁内，别人看不到中间状态
+            roots.push_back(&node);
+        }
+        nodes_.emplace(node.id, std::move(fresh[i]));
+    }
+    ReleaseAll(roots, ready);
+    return true;
+}
+
+void DagTracker::ReleaseAll(std::vector<Node*>& nodes, std::vector<Ready>& ready) {
+    std::stable_sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) { return a->rank > b->rank; });
+    for (Node* node : nodes) {
+        Ready r{std::move(node->task), node->hint.load(std::memory_order_relaxed)};
+        if (node->on_critical) ++r.task.priority;
+        ready.push_back(std::move(r));
+    }
+}
+
+void DagTracker::Propagate(Node& from, bool ok, std::uint32_t node, std::vector<Ready>& ready,
+                           std::vector<std::string>& skipped, std::vector<Node*>& done) {
+    std::vector<Node*> released;
+    std::vector<std::pair<Node*, bool>> stack{{&from, ok}};
+    while (!stack.empty()) {
+        auto [parent, parent_ok] = stack.back();
+        stack.pop_back();
+        for (Node* child : parent->children) {
+            if (!parent_ok) {
+                child->failed.store(true, std::memory_order_relaxed);
+            } else if (parent->critical_child == child ||
+                       child->hint.load(std::memory_order_relaxed) == NodeCapacityIndex::kNoNode) {
+                child->hint.store(node, std::memory_order_relaxed);
+            }
+            // 入度的 acq_rel 把各上游写的 failed / hint 带给最后一个减到 0 的人
+            if (child->indegree.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+            // 与 cancel 抢状态：抢不到说明已被取消，入度归零后由这里删
+            const bool failed = child->failed.load(std::memory_order_relaxed);
+            std::uint8_t held = kHeld;
+            if (!child->status.compare_exchange_strong(held, failed ? kFinished : kReleased,
+                                                       std::memory_order_acq_rel)) {
+                done.push_back(child);
+            } else if (!failed) {
+                released.push_back(child);
+            } else {
+                skipped.push_back(child->id);
+                done.push_back(child);
+                stack.emplace_back(child, false);
+            }
+        }
+    }
+    ReleaseAll(released, ready);
+}
+
+bool DagTracker::complete(std::string_view task_id, bool success, std::uint32_t node,
+                          std::vector<Ready>& ready, std::vector<std::string>& skipped) {
+    std::vector<Node*> done;
+    {
+        // 查找、抢状态、向下传播都在共享锁内：Erase 要独占锁，期间拿到的节点不会被释放
+        std::shared_lock<std::shared_mutex> lk(mu_);
+        Node* n = FindLocked(task_id);
+        if (!n) return false;
+        std::uint8_t released = kReleased;
+        if (!n->status.compare_exchange_strong(released, kFinished, std::memory_order_acq_rel)) return false;
+        done.push_back(n);
+        Propagate(*n, success, node, ready, skipped, done);
+    }
+    Erase(done);
+    return true;
+}
+
+bool DagTracker::cancel(std::string_view task_id, std::vector<std::string>& skipped) {
+    std::vector<Node*> done;
+    {
+        std::shared_lock<std::shared_mutex> lk(mu_);
+        Node* n = FindLocked(task_id);
+        if (!n) return false;
+        std::uint8_t held = kHeld;
+        if (!n->status.compare_exchange_strong(held, kFinished, std::memory_order_acq_rel)) return false;
+        // 被取消的节点入度必然未归零（否则已放出），留给最后一个上游删
+        std::vector<Ready> none;                               // 失败只会跳过，不会放出
+        Propagate(*n, false, NodeCapacityIndex::kNoNode, none, skipped, done);
+    }
+    Erase(done);
+    return true;
+}
+
+void DagTracker::Erase(const std::vector<Node*>& done) {
+    if (done.empty()) return;
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    for (Node* n : done) {
+        auto it = nodes_.find(n->id);
+        if (it != nodes_.end() && it->second.get() == n) nodes_.erase(it);
+    }
+}
+
+} // namespace dts
@@ -0,0 +1,224 @@
+#include "fair_share.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dts {
+
+FairShareQueue::FairShareQueue(FairShareOptions options) : options_(options) {
+    if (!(options_.quantum > 0)) options_.quantum = FairShareOptions{}.quantum;
+}
+
+FairShareQueue::~FairShareQueue() = default;
+
+/* ---------- 租户表 ---------- */
+FairShareQueue::Tenant* FairShareQueue::Find(std::string_view client_id) const {
+    std::shared_lock<std::shared_mutex> lk(tenants_mu_);
+    auto it = tenants_.find(client_id);
+    return it == tenants_.end() ? nullptr : it->second.get();
+}
+
+FairShareQueue::Tenant& FairShareQueue::TenantFor(std::string_view client_id) {
+    if (Tenant* t = Find(client_id)) return *t;
+    std::unique_lock<std::shared_mutex> lk(tenants_mu_);
+    auto& slot = tenants_[std::string(client_id)];
+    if (!slot) {
+        slot = std::make_unique<Tenant>();
+        slot->client_id = std::string(client_id);
+    }
+    return *slot;
+}
+
+bool FairShareQueue::set_tenant(std::string_view client_id, const TenantConfig& config) {
+    if (!(config.weight > 0)) return false;
+    Tenant& t = TenantFor(client_id);
+    std::lock_guard<std::mutex> lk(ring_mu_);
+    t.config = config;
+    if (t.throttled && !OverQuota(t)) {
+        t.throttled = false;
+        LinkLocked(t);
+    }
+    return true;
+}
+
+double FairShareQueue::cost(const Resource& r) const {
+    const double cpu = options_.unit.cpu_core > 0 ? r.cpu_core / options_.unit.cpu_core : 0.0;
+    const double mem = options_.unit.mem_mb > 0
+        ? static_cast<double>(r.mem_mb) / static_cast<double>(options_.unit.mem_mb) : 0.0;
+    return std::max({cpu, mem, options_.min_cost});
+}
+
+bool FairShareQueue::OverQuota(const Tenant& t) const {
+    const Resource& q = t.config.quota;
+    return (q.cpu_core > 0 && t.in_use.cpu_core >= q.cpu_core) ||
+           (q.mem_mb > 0 && t.in_use.mem_mb >= q.mem_mb);
+}
+
+/* ---------- 轮转环 ---------- */
+void FairShareQueue::LinkLocked(Tenant& t) {
+    if (t.linked) return;
+    t.prev = tail_;
+    t.next = nullptr;
+    if (tail_) tail_->next = &t; else head_ = &t;
+    tail_ = &t;
+    t.linked = true;
+    ++ring_size_;
+}
+
+void FairShareQueue::UnlinkLocked(Tenant& t) {
+    if (!t.linked) return;
+    if (t.prev) t.prev->next = t.next; else head_ = t.next;
+    if (t.next) t.next->prev = t.prev; else tail_ = t.prev;
+    t.prev = t.next = nullptr;
+    t.linked = false;
+    --ring_size_;
+}
+
+void FairShareQueue::Activate(Tenant& t) {
+    // 只有从空闲变为活跃的那次提交需要挂环
+    if (t.active.exchange(true)) return;
+    std::lock_guard<std::mutex> lk(ring_mu_);
+    if (!t.throttled) LinkLocked(t);
+}
+
+/* ---------- 队列操作 ---------- */
+bool FairShareQueue::push(Task task) {
+    Tenant& t = TenantFor(task.client_id);
+    if (!t.queue.push(std::move(task))) return false;
+    size_.fetch_add(1, std::memory_order_release);
+    Activate(t);
+    return true;
+}
+
+bool FairShareQueue::cancel(std::string_view task_id) {
+    std::shared_lock<std::shared_mutex> lk(tenants_mu_);
+    for (auto& [_, t] : tenants_) {
+        if (t->queue.cancel(task_id)) {
+            size_.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t FairShareQueue::drain(std::vector<Task>& out, std::size_t max) {
+    std::lock_guard<std::mutex> lk(ring_mu_);
+    std::size_t n = 0;
+    std::size_t idle = 0;                              // 连续没取到任务的租户数
+    while (n < max && head_) {
+        // 环上每个租户都轮过一遍仍一个没取到（都在透支）：一次补上最少要空转的轮数，不在环锁内一圈圈转；
+        // 补不上（额度不增长）就留到下次 drain
+        if (idle > 0 && idle >= ring_size_) {
+            if (!SkipIdleRoundsLocked()) break;
+            idle = 0;
+        }
+        Tenant& t = *head_;
+        const std::size_t before = n;
+        if (OverQuota(t)) {
+            UnlinkLocked(t);
+            t.throttled = true;
+            t.credited = false;
+            continue;
+        }
+        if (!t.credited) {
+            t.deficit += options_.quantum * t.config.weight;
+            t.credited = true;
+        }
+
+        bool exhausted = false;
+        while (n < max && t.deficit > 0 && !OverQuota(t)) {
+            auto task = t.queue.pop();
+            if (!task) {
+                exhausted = true;
+                break;
+            }
+            size_.fetch_sub(1, std::memory_order_release);
+            t.deficit -= cost(task->required);
+            t.in_use.cpu_core += task->required.cpu_core;
+            t.in_use.mem_mb += task->required.mem_mb;
+            out.push_back(std::move(*task));
+            ++n;
+        }
+        // 批满而本租户额度未用完：保留在环头，下一批接着取
+        if (!exhausted && n == max && t.deficit > 0 && !OverQuota(t)) break;
+        idle = n == before ? idle + 1 : 0;
+
+        t.credited = false;
+        UnlinkLocked(t);
+        if (exhausted) {
+            // 排空即退出本轮，结余作废、透支保留
+            t.deficit = std::min(t.deficit, 0.0);
+            t.active.store(false);
+            // 与 push 的 Activate 竞争：刚有任务进来而对方看到的还是 active，由这里挂回去
+            if (!t.queue.empty() && !t.active.exchange(true)) LinkLocked(t);
+        } else if (OverQuota(t)) {
+            t.throttled = true;
+        } else {
+            LinkLocked(t);                            // 轮到队尾
+        }
+    }
+    return n;
+}
+
+bool FairShareQueue::SkipIdleRoundsLocked() {
+    double rounds = std::numeric_limits<double>::infinity();
+    for (Tenant* t = head_; t; t = t->next) {
+        const double per_round = options_.quantum * t->config.weight;
+        if (!(per_round > 0)) continue;
+        rounds = std::min(rounds, std::floor(std::max(0.0, -t->deficit) / per_round));
+    }
+    if (!std::isfinite(rounds)) return false;
+    for (Tenant* t = head_; t; t = t->next) t->deficit += rounds * options_.quantum * t->config.weight;
+    return true;
+}
+
+void FairShareQueue::RefundLocked(Tenant& t, const Resource& r) {
+    t.deficit += cost(r);
+    t.in_use.cpu_core = std::max(0.0, t.in_use.cpu_core - r.cpu_core);
+    t.in_use.mem_mb -= std::min(t.in_use.mem_mb, r.mem_mb);
+    if (t.throttled && !OverQuota(t)) {
+        t.throttled = false;
+        LinkLocked(t);
+    }
+}
+
+void FairShareQueue::requeue(Task task) {
+    Tenant& t = TenantFor(task.client_id);
+    {
+        std::lock_guard<std::mutex> lk(ring_mu_);
+        RefundLocked(t, task.required);
+    }
+    push(std::move(task));
+}
+
+std::size_t FairShareQueue::steal(std::vector<Task>& out, std::size_t max) {
+    const std::size_t first = out.size();
+    const std::size_t n = drain(out, max);
+    for (std::size_t i = first; i < out.size(); ++i) {
+        Tenant& t = TenantFor(out[i].client_id);
+        std::lock_guard<std::mutex> lk(ring_mu_);
+        RefundLocked(t, out[i].required);
+    }
+    return n;
+}
+
+void FairShareQueue::release(std::string_view client_id, const Resource& used) {
+    Tenant* t = Find(client_id);
+    if (!t) return;
+    std::lock_guard<std::mutex> lk(ring_mu_);
+    t->in_use.cpu_core = std::max(0.0, t->in_use.cpu_core - used.cpu_core);
+    t->in_use.mem_mb -= std::min(t->in_use.mem_mb, used.mem_mb);
+    if (t->throttled && !OverQuota(*t)) {
+        t->throttled = false;
+        LinkLocked(*t);
+    }
+}
+
+Resource FairShareQueue::in_use(std::string_view client_id) const {
+    Tenant* t = Find(client_id);
+    if (!t) return {};
+    std::lock_guard<std::mutex> lk(ring_mu_);
+    return t->in_use;
+}
+
+} // namespace dts
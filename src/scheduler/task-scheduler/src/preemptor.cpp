@@ -0,0 +1,143 @@
+#include "preemptor.hpp"
+#include <algorithm>
+#include <tuple>
+
+namespace dts {
+
+Preemptor::Preemptor(PreemptionOptions options) : options_(options) {}
+
+void Preemptor::on_dispatch(std::uint32_t node, const Task& task, std::int64_t now_ms) {
+    std::lock_guard<std::mutex> lk(mu_);
+    claims_.erase(task.task_id);
+    auto& slot = running_[task.task_id];
+    if (slot) UnlinkLocked(slot.get());              // 同 id 重新下发（回队后再放）：以这次为准
+    slot = std::make_unique<Entry>(Entry{task, node, now_ms, {}});
+    if (node >= on_node_.size()) on_node_.resize(node + 1);
+    on_node_[node].push_back(slot.get());
+}
+
+void Preemptor::UnlinkLocked(Entry* e) {
+    auto& list = on_node_[e->node];
+    auto it = std::find(list.begin(), list.end(), e);
+    *it = list.back();
+    list.pop_back();
+}
+
+std::optional<Task> Preemptor::on_finish(const Task& task) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = running_.find(task.task_id);
+    if (it == running_.end()) return std::nullopt;
+    std::unique_ptr<Entry> e = std::move(it->second);
+    running_.erase(it);
+    UnlinkLocked(e.get());
+    if (e->claimant.empty()) return std::nullopt;
+
+    if (auto c = claims_.find(e->claimant); c != claims_.end() && c->second.pending > 0) --c->second.pending;
+    if (task.state == TaskState::SUCCESS) return std::nullopt;   // 信号到达前已跑完
+    Task again = std::move(e->task);
+    again.state = TaskState::PENDING;
+    again.cancelled = std::make_shared<std::atomic<bool>>(false);
+    if (task.result.is_object() && task.result.contains("checkpoint")) {
+        if (!again.func_params.is_object()) again.func_params = nlohmann::json::object();
+        again.func_params["checkpoint"] = task.result["checkpoint"];
+    }
+    ++stats_.requeued;
+    return again;
+}
+
+bool Preemptor::preempt(const Task& task, const NodeCapacityIndex& nodes, std::int64_t now_ms,
+                        std::vector<Victim>& out) {
+    if (task.priority < options_.min_priority || task.priority < options_.min_gap) return false;
+    if (task.submit_ts > 0 && now_ms - task.submit_ts < options_.grace_ms) return false;
+    const std::uint32_t max_victim = task.priority - options_.min_gap;
+    std::lock_guard<std::mutex> lk(mu_);
+    if (auto c = claims_.find(task.task_id); c != claims_.end()) {
+        if (c->second.pending > 0) return false;
+        claims_.erase(c);                              // 受害者都退了却仍没放下（空间被别处占了），重新挑
+    }
+
+    // 代价：(受害者中的最高优先级, 受害者个数, 丢掉的总进度)，逐项比较
+    using Cost = std::tuple<std::uint32_t, std::size_t, std::int64_t>;
+    std::optional<Cost> best;
+    std::uint32_t best_node = NodeCapacityIndex::kNoNode;
+    std::size_t best_count = 0;
+    std::vector<Entry*> chosen;
+    const std::size_t limit = std::min(nodes.size(), on_node_.size());
+    for (std::uint32_t n = 0; n < limit; ++n) {
+        const auto& node = nodes.node(n);
+        if (!node.schedulable || on_node_[n].empty() || !NodeCapacityIndex::Fits(node.capacity, task.required)) {
+            continue;
+        }
+        scratch_.clear();
+        for (Entry* e : on_node_[n]) {
+            if (e->claimant.empty() && e->task.priority <= max_victim) scratch_.push_back(e);
+        }
+        if (scratch_.empty()) continue;
+        std::sort(scratch_.begin(), scratch_.end(), [](const Entry* a, const Entry* b) {
+            return a->task.priority != b->task.priority ? a->task.priority < b->task.priority
+                                                        : a->start_ms > b->start_ms;
+        });
+        Resource freed = node.free;
+        std::size_t k = 0;
+        std::int64_t lost = 0;
+        while (k < scratch_.size() && !NodeCapacityIndex::Fits(freed, task.required)) {
+            const Entry* e = scratch_[k++];
+            freed.cpu_core += e->task.required.cpu_core;
+            freed.mem_mb += e->task.required.mem_mb;
+            lost += now_ms - e->start_ms;
+        }
+        if (k == 0 || !NodeCapacityIndex::Fits(freed, task.required)) continue;
+        const Cost cost{scratch_[k - 1]->task.priority, k, lost};
+        if (best && !(cost < *best)) continue;
+        best = cost;
+        best_node = n;
+        best_count = k;
+        chosen.assign(scratch_.begin(), scratch_.begin() + static_cast<std::ptrdiff_t>(k));
+    }
+    if (!best) return false;
+
+    for (Entry* e : chosen) {
+        e->claimant = task.task_id;
+        e->task.cancelled->store(true, std::memory_order_release);
+        out.push_back(Victim{best_node, e->task.task_id});
+    }
+    claims_[task.task_id] = Claim{best_node, static_cast<std::uint32_t>(best_count)};
+    stats_.preempted += best_count;
+    ++stats_.claims;
+    return true;
+}
+
+std::uint32_t Preemptor::claim(std::string_view task_id) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = claims_.find(task_id);
+    return it == claims_.end() ? NodeCapacityIndex::kNoNode : it->second.node;
+}
+
+void Preemptor::drop_claim(std::string_view task_id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (auto it = claims_.find(task_id); it != claims_.end()) claims_.erase(it);
+}
+
+void Preemptor::claimed_nodes(std::vector<std::uint32_t>& out) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& [_, c] : claims_) {
+        if (c.pending > 0) out.push_back(c.node);
+    }
+}
+
+bool Preemptor::has_claims() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return !claims_.empty();
+}
+
+std::size_t Preemptor::running() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return running_.size();
+}
+
+Preemptor::Stats Preemptor::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+} // namespace dts
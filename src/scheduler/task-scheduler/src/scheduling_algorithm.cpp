@@ -0,0 +1,250 @@
+#include "scheduling_algorithm.hpp"
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace dts {
+
+/* ---------- NodeCapacityIndex ---------- */
+NodeCapacityIndex::NodeCapacityIndex(const Resource& max_node)
+    : cpu_step_(max_node.cpu_core > 0 ? max_node.cpu_core / (kLevels - 1) : 1.0),
+      mem_step_(max_node.mem_mb > 0 ? static_cast<double>(max_node.mem_mb) / (kLevels - 1) : 1.0),
+      buckets_(kLevels * kLevels) {}
+
+std::size_t NodeCapacityIndex::CpuLevel(double cpu) const {
+    if (cpu <= 0) return 0;
+    return std::min<std::size_t>(kLevels - 1, static_cast<std::size_t>(cpu / cpu_step_));
+}
+
+std::size_t NodeCapacityIndex::MemLevel(std::uint64_t mem) const {
+    return std::min<std::size_t>(kLevels - 1, static_cast<std::size_t>(static_cast<double>(mem) / mem_step_));
+}
+
+void NodeCapacityIndex::Link(std::uint32_t i) {
+    Node& n = nodes_[i];
+    n.cpu_level = static_cast<std::uint8_t>(CpuLevel(n.free.cpu_core));
+    n.mem_level = static_cast<std::uint8_t>(MemLevel(n.free.mem_mb));
+    auto& b = buckets_[n.cpu_level * kLevels + n.mem_level];
+    n.slot = static_cast<std::uint32_t>(b.size());
+    b.push_back(i);
+    rows_ |= 1ull << n.cpu_level;
+    cols_[n.cpu_level] |= 1ull << n.mem_level;
+}
+
+void NodeCapacityIndex::Unlink(std::uint32_t i) {
+    Node& n = nodes_[i];
+    auto& b = buckets_[n.cpu_level * kLevels + n.mem_level];
+    // 与桶尾交换后弹出，O(1)
+    b[n.slot] = b.back();
+    nodes_[b[n.slot]].slot = n.slot;
+    b.pop_back();
+    if (b.empty()) {
+        cols_[n.cpu_level] &= ~(1ull << n.mem_level);
+        if (cols_[n.cpu_level] == 0) rows_ &= ~(1ull << n.cpu_level);
+    }
+}
+
+std::uint32_t NodeCapacityIndex::add_node(std::string node_id, const Resource& capacity) {
+    const auto i = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back(Node{std::move(node_id), capacity, capacity});
+    largest_.cpu_core = std::max(largest_.cpu_core, capacity.cpu_core);
+    largest_.mem_mb = std::max(largest_.mem_mb, capacity.mem_mb);
+    Link(i);
+    return i;
+}
+
+void NodeCapacityIndex::set_free(std::uint32_t node, const Resource& free) {
+    if (nodes_[node].schedulable) Unlink(node);
+    nodes_[node].free = free;
+    if (nodes_[node].schedulable) Link(node);
+}
+
+void NodeCapacityIndex::set_schedulable(std::uint32_t node, bool schedulable) {
+    Node& n = nodes_[node];
+    if (n.schedulable == schedulable) return;
+    n.schedulable = schedulable;
+    if (schedulable) Link(node); else Unlink(node);
+}
+
+std::uint32_t NodeCapacityIndex::best_fit(const Resource& req) const {
+    const std::size_t lc = CpuLevel(req.cpu_core);
+    const std::size_t lm = MemLevel(req.mem_mb);
+    // 级别低于需求所在级的节点一定放不下，直接屏蔽；
+    // 两维都高于需求级的桶里任意节点都放得下；边界桶只试 kBoundaryProbes 个，
+    // 集群接近满时边界桶里全是“差一点”的节点，逐个比较会退化成全量扫描
+    for (std::uint64_t rows = rows_ & (~0ull << lc); rows; rows &= rows - 1) {
+        const auto i = static_cast<std::size_t>(std::countr_zero(rows));
+        for (std::uint64_t cols = cols_[i] & (~0ull << lm); cols; cols &= cols - 1) {
+            const auto j = static_cast<std::size_t>(std::countr_zero(cols));
+            const auto& b = buckets_[i * kLevels + j];
+            const std::size_t start = salt_ % b.size();
+            if (i > lc && j > lm) return b[start];
+            const std::size_t probes = std::min(b.size(), kBoundaryProbes);
+            for (std::size_t k = 0; k < probes; ++k) {
+                const std::uint32_t n = b[(start + k) % b.size()];
+                if (Fits(nodes_[n].free, req)) return n;
+            }
+        }
+    }
+    return kNoNode;
+}
+
+bool NodeCapacityIndex::reserve(std::uint32_t node, const Resource& req) {
+    Node& n = nodes_[node];
+    if (!Fits(n.free, req)) return false;
+    set_free(node, Resource{n.free.cpu_core - req.cpu_core, n.free.mem_mb - req.mem_mb});
+    return true;
+}
+
+void NodeCapacityIndex::release(std::uint32_t node, const Resource& req) {
+    const Node& n = nodes_[node];
+    set_free(node, Resource{std::min(n.capacity.cpu_core, n.free.cpu_core + req.cpu_core),
+                            std::min(n.capacity.mem_mb, n.free.mem_mb + req.mem_mb)});
+}
+
+/* ---------- BinPackingAlgorithm ---------- */
+std::size_t BinPackingAlgorithm::place(std::span<const Task> tasks, NodeCapacityIndex& nodes,
+                                       std::vector<std::uint32_t>& out) {
+    out.assign(tasks.size(), NodeCapacityIndex::kNoNode);
+    if (tasks.empty() || nodes.size() == 0) return 0;
+
+    // 主导份额以最大节点规格为分母，近似 DRF 的 dominant share
+    const double max_cpu = nodes.largest().cpu_core;
+    const double max_mem = static_cast<double>(nodes.largest().mem_mb);
+    share_.resize(tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        const Resource& r = tasks[i].required;
+        share_[i] = std::max(max_cpu > 0 ? r.cpu_core / max_cpu : 0.0,
+                             max_mem > 0 ? static_cast<double>(r.mem_mb) / max_mem : 0.0);
+    }
+    order_.resize(tasks.size());
+    std::iota(order_.begin(), order_.end(), 0u);
+    std::stable_sort(order_.begin(), order_.end(), [&](std::uint32_t a, std::uint32_t b) {
+        if (tasks[a].priority != tasks[b].priority) return tasks[a].priority > tasks[b].priority;
+        return share_[a] > share_[b];
+    });
+
+    std::size_t placed = 0;
+    for (std::uint32_t i : order_) {
+        const Resource& req = tasks[i].required;
+        const std::uint32_t n = nodes.best_fit(req);
+        if (n == NodeCapacityIndex::kNoNode || !nodes.reserve(n, req)) continue;
+        out[i] = n;
+        ++placed;
+    }
+    return placed;
+}
+
+/* ---------- LocalityAwareAlgorithm ---------- */
+namespace {
+
+std::uint64_t Mix(std::uint64_t x) {              // splitmix64 终结函数
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+std::uint64_t DefaultLocalityKey(const Task& task) {
+    return Mix(std::hash<std::string_view>{}(task.func_name) ^ (std::uint64_t{task.shard.shard_id} << 32 | task.shard.total_shards));
+}
+
+LocalityAwareAlgorithm::LocalityAwareAlgorithm() : LocalityAwareAlgorithm(Options{}) {}
+
+LocalityAwareAlgorithm::LocalityAwareAlgorithm(Options options, KeyFunc key)
+    : options_(options), key_(std::move(key)), recent_(std::bit_ceil(std::max<std::size_t>(1, options.recent_slots))) {}
+
+double LocalityAwareAlgorithm::Share(const NodeCapacityIndex::Node& n) {
+    const double cpu = n.capacity.cpu_core > 0 ? 1.0 - n.free.cpu_core / n.capacity.cpu_core : 1.0;
+    const double mem = n.capacity.mem_mb > 0
+        ? 1.0 - static_cast<double>(n.free.mem_mb) / static_cast<double>(n.capacity.mem_mb) : 1.0;
+    return std::max(cpu, mem);
+}
+
+void LocalityAwareAlgorithm::RebuildRing(const NodeCapacityIndex& nodes) {
+    // 虚拟节点的位置只取决于 node_id，节点增减时其余键的归属不变
+    ring_.clear();
+    ring_.reserve(nodes.size() * options_.vnodes);
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        const std::uint64_t base = std::hash<std::string>{}(nodes.node(i).node_id);
+        for (std::uint32_t v = 0; v < options_.vnodes; ++v) ring_.emplace_back(Mix(base + v), i);
+    }
+    std::sort(ring_.begin(), ring_.end());
+    ring_nodes_ = nodes.size();
+}
+
+std::size_t LocalityAwareAlgorithm::place(std::span<const Task> tasks, NodeCapacityIndex& nodes,
+                                          std::vector<std::uint32_t>& out) {
+    out.assign(tasks.size(), NodeCapacityIndex::kNoNode);
+    if (tasks.empty() || nodes.size() == 0) return 0;
+    if (ring_nodes_ != nodes.size()) RebuildRing(nodes);
+
+    // 本批的负载基线：各节点当前占用份额与总和，放置时增量维护
+    share_.resize(nodes.size());
+    double total = 0;
+    std::size_t live = 0;
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        share_[i] = Share(nodes.node(i));
+        if (nodes.node(i).schedulable) {
+            total += share_[i];
+            ++live;
+        }
+    }
+    if (live == 0) return 0;
+
+    order_.resize(tasks.size());
+    std::iota(order_.begin(), order_.end(), 0u);
+    std::stable_sort(order_.begin(), order_.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return tasks[a].priority > tasks[b].priority; });
+
+    const Resource& largest = nodes.largest();
+    auto unit_share = [&](const Resource& r) {
+        return std::max(largest.cpu_core > 0 ? r.cpu_core / largest.cpu_core : 0.0,
+                        largest.mem_mb > 0 ? static_cast<double>(r.mem_mb) / static_cast<double>(largest.mem_mb) : 0.0);
+    };
+
+    std::size_t placed = 0;
+    for (std::uint32_t i : order_) {
+        const Resource& req = tasks[i].required;
+        const std::uint64_t key = key_(tasks[i]);
+        // 有界负载：放之前的份额不超过 load_factor 倍集群平均，再留一个任务的余量（空集群也能放）
+        const double bound = options_.load_factor * total / static_cast<double>(live) + unit_share(req);
+        auto usable = [&](std::uint32_t n) {
+            const auto& node = nodes.node(n);
+            return node.schedulable && NodeCapacityIndex::Fits(node.free, req) && share_[n] <= bound;
+        };
+
+        std::uint32_t chosen = NodeCapacityIndex::kNoNode;
+        Recent& recent = recent_[key & (recent_.size() - 1)];
+        if (recent.key == key && recent.node < nodes.size() && usable(recent.node)) {
+            chosen = recent.node;
+            ++stats_.recent_hits;
+        } else {
+            auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(key, std::uint32_t{0}));
+            for (std::uint32_t probe = 0; probe < options_.max_probes && probe < ring_.size(); ++probe, ++it) {
+                if (it == ring_.end()) it = ring_.begin();
+                if (usable(it->second)) {
+                    chosen = it->second;
+                    ++(probe == 0 ? stats_.ring_home : stats_.spilled);
+                    break;
+                }
+            }
+            if (chosen == NodeCapacityIndex::kNoNode) {
+                chosen = nodes.best_fit(req);
+                if (chosen != NodeCapacityIndex::kNoNode) ++stats_.fallback;
+            }
+        }
+        if (chosen == NodeCapacityIndex::kNoNode || !nodes.reserve(chosen, req)) continue;
+
+        const double after = Share(nodes.node(chosen));
+        total += after - share_[chosen];
+        share_[chosen] = after;
+        recent = Recent{key, chosen};
+        out[i] = chosen;
+        ++placed;
+    }
+    return placed;
+}
+
+} // namespace dts
@@ -0,0 +1,126 @@
+#include "sharded_scheduler.hpp"
+#include <algorithm>
+
+namespace dts {
+
+ShardedScheduler::ShardedScheduler(AlgorithmFactory make_algorithm, const NodeCapacityIndex& nodes,
+                                   DispatchFunc dispatch, ShardedSchedulerOptions options)
+    : cluster_(std::make_shared<ClusterState>(nodes)) {
+    const std::size_t n = std::max<std::size_t>(1, options.shards);
+    shards_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        options.scheduler.tiebreak = static_cast<std::uint32_t>(i * 0x9E3779B9u);   // 各分片在同一桶里从不同位置挑
+        shards_.push_back(std::make_unique<TaskScheduler>(
+            make_algorithm(), cluster_,
+            [dispatch, i](std::uint32_t node, const std::string& node_id, std::vector<Task>&& batch) {
+                dispatch(i, node, node_id, std::move(batch));
+            },
+            options.scheduler));
+        if (options.work_stealing && n > 1) {
+            shards_.back()->set_steal_source([this, i](std::vector<Task>& out, std::size_t max) {
+                return StealFor(i, out, max);
+            });
+        }
+    }
+}
+
+ShardedScheduler::~ShardedScheduler() { stop(); }
+
+std::size_t ShardedScheduler::OwnerOf(std::string_view task_id, std::size_t shards) {
+    // 混入高位再取模，分片数为 2 的幂时不只看最低几位
+    const std::uint64_t h = std::hash<std::string_view>{}(task_id);
+    return static_cast<std::size_t>((h ^ (h >> 29)) % shards);
+}
+
+bool ShardedScheduler::submit(Task task) {
+    const std::size_t owner = OwnerOf(task.task_id, shards_.size());
+    return shards_[owner]->submit(std::move(task));
+}
+
+bool ShardedScheduler::submit_dag(std::vector<Task> tasks) {
+    if (tasks.empty()) return true;
+    const std::size_t owner = OwnerOf(tasks.front().task_id, shards_.size());
+    return shards_[owner]->submit_dag(std::move(tasks));
+}
+
+bool ShardedScheduler::cancel(std::string_view task_id) {
+    const std::size_t owner = OwnerOf(task_id, shards_.size());
+    if (shards_[owner]->cancel(task_id)) return true;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        if (i != owner && shards_[i]->cancel(task_id)) return true;
+    }
+    return false;
+}
+
+void ShardedScheduler::release(std::size_t shard, std::uint32_t node, const Resource& used,
+                               std::string_view client_id) {
+    shards_[shard]->release(node, used, client_id);
+}
+
+std::vector<std::string> ShardedScheduler::finish(std::size_t shard, std::uint32_t node, const Task& task) {
+    std::vector<std::string> skipped;
+    auto id = shards_[shard]->settle(node, task);
+    if (!id) return skipped;
+    const bool ok = task.state == TaskState::SUCCESS;
+    if (shards_[shard]->complete(node, *id, ok, skipped)) return skipped;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        if (i != shard && shards_[i]->complete(node, *id, ok, skipped)) break;
+    }
+    return skipped;
+}
+
+bool ShardedScheduler::set_tenant(std::string_view client_id, const TenantConfig& config) {
+    if (!(config.weight > 0)) return false;
+    for (auto& s : shards_) s->set_tenant(client_id, config);
+    return true;
+}
+
+std::size_t ShardedScheduler::StealFor(std::size_t thief, std::vector<Task>& out, std::size_t max) {
+    std::size_t victim = thief, deepest = 0;
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        const std::size_t depth = shards_[i]->pending();
+        if (i != thief && depth > deepest) {
+            victim = i;
+            deepest = depth;
+        }
+    }
+    // 只偷一半：被偷方下一轮还有活干，避免任务在分片间来回搬
+    if (victim == thief || deepest < 2) return 0;
+    return shards_[victim]->steal(out, std::min(max, deepest / 2));
+}
+
+void ShardedScheduler::start() {
+    for (auto& s : shards_) s->start();
+}
+
+void ShardedScheduler::stop() {
+    for (auto& s : shards_) s->stop();
+}
+
+std::size_t ShardedScheduler::pending() const {
+    std::size_t n = 0;
+    for (auto& s : shards_) n += s->pending();
+    return n;
+}
+
+TaskScheduler::Stats ShardedScheduler::stats() const {
+    TaskScheduler::Stats total;
+    for (auto& s : shards_) {
+        const auto st = s->stats();
+        total.cycles += st.cycles;
+        total.dispatched += st.dispatched;
+        total.messages += st.messages;
+        total.requeued += st.requeued;
+        total.conflicts += st.conflicts;
+        total.stolen += st.stolen;
+        total.fired += st.fired;
+        total.co_located += st.co_located;
+        total.speculated += st.speculated;
+        total.spec_won += st.spec_won;
+        total.preempted += st.preempted;
+        total.last_cycle_us = std::max(total.last_cycle_us, st.last_cycle_us);
+    }
+    return total;
+}
+
+} // namespace dts
@@ -0,0 +1,204 @@
+#include "speculator.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace dts {
+
+/* ---------- RuntimeStats ---------- */
+std::size_t RuntimeStats::BucketOf(std::int64_t ms) {
+    if (ms < 4) return static_cast<std::size_t>(std::max<std::int64_t>(ms, 0));
+    const auto v = static_cast<std::uint64_t>(ms);
+    const std::size_t e = static_cast<std::size_t>(std::bit_width(v)) - 1;      // >= 2
+    const std::size_t sub = static_cast<std::size_t>((v >> (e - 2)) & 3);
+    return std::min(e * kSubBuckets + sub, kBuckets - 1);
+}
+
+std::int64_t RuntimeStats::UpperBound(std::size_t bucket) {
+    if (bucket < 4) return static_cast<std::int64_t>(bucket);
+    const std::size_t e = bucket / kSubBuckets, sub = bucket % kSubBuckets;
+    return static_cast<std::int64_t>(((5 + sub) << (e - 2)) - 1);
+}
+
+void RuntimeStats::record(std::string_view func_name, std::int64_t runtime_ms) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = funcs_.find(func_name);
+    if (it == funcs_.end()) it = funcs_.emplace(std::string(func_name), Histogram{}).first;
+    Histogram& h = it->second;
+    ++h.counts[BucketOf(runtime_ms)];
+    ++h.total;
+    if (++h.since_decay >= decay_every_) {
+        h.since_decay = 0;
+        h.total = 0;
+        for (auto& c : h.counts) h.total += (c >>= 1);
+    }
+}
+
+std::optional<std::int64_t> RuntimeStats::percentile(std::string_view func_name, double p,
+                                                     std::uint32_t min_samples) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = funcs_.find(func_name);
+    if (it == funcs_.end() || it->second.total == 0 || it->second.total < min_samples) return std::nullopt;
+    const Histogram& h = it->second;
+    const auto rank = static_cast<std::uint32_t>(std::ceil(p * h.total));
+    std::uint32_t seen = 0;
+    for (std::size_t b = 0; b < kBuckets; ++b) {
+        seen += h.counts[b];
+        if (seen >= std::max<std::uint32_t>(rank, 1)) return UpperBound(b);
+    }
+    return UpperBound(kBuckets - 1);
+}
+
+/* ---------- Speculator ---------- */
+Speculator::Speculator(SpeculationOptions options) : options_(options) {}
+
+std::string_view Speculator::OriginalId(std::string_view id, bool& is_copy) {
+    is_copy = id.size() > kSuffix.size() && id.substr(id.size() - kSuffix.size()) == kSuffix;
+    return is_copy ? id.substr(0, id.size() - kSuffix.size()) : id;
+}
+
+bool Speculator::on_dispatch(std::uint32_t node, const Task& task, std::int64_t now_ms) {
+    bool is_copy = false;
+    const std::string_view id = OriginalId(task.task_id, is_copy);
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!is_copy) {
+        auto [it, fresh] = running_.try_emplace(std::string(id));
+        Entry kept;
+        if (!fresh) {                                  // 同 id 重新下发：换成这次的任务，推测状态保留
+            kept = entries_[it->second.index];
+            tasks_.erase(it->second);
+        }
+        it->second = tasks_.insert(task);
+        if (entries_.size() < tasks_.capacity()) entries_.resize(tasks_.capacity());
+        Entry& e = entries_[it->second.index];
+        e = kept;
+        e.copies[0] = Copy{node, now_ms, task.cancelled, true, false};
+        return true;
+    }
+    auto it = running_.find(id);
+    if (it == running_.end()) return false;
+    Entry& e = entries_[it->second.index];
+    if (e.settled) {
+        // 在放置与下发之间原任务已经出了结果
+        CopyDoneLocked(e);
+        MaybeEraseLocked(it);
+        return false;
+    }
+    e.copies[1] = Copy{node, now_ms, task.cancelled, true, false};
+    ++stats_.launched;
+    return true;
+}
+
+std::size_t Speculator::scan(std::int64_t now_ms, std::vector<Task>& out, std::vector<std::uint32_t>& avoid) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const auto budget = static_cast<std::size_t>(
+        std::max(1.0, options_.max_fraction * static_cast<double>(tasks_.size())));
+    std::unordered_map<std::string_view, std::optional<std::int64_t>> thresholds;   // 本次扫描内按函数缓存
+    std::size_t n = 0;
+    tasks_.for_each_hot([&](TaskTable::Handle h, TaskHot&) {
+        Entry& e = entries_[h.index];
+        if (e.settled || !e.copies[0].live) return;
+        const std::int64_t elapsed = now_ms - e.copies[0].start_ms;
+        if (elapsed < options_.min_elapsed_ms) return;
+        // 跑得够久的才去碰冷数据
+        const std::string& func = tasks_.cold(h)->func_name;
+        auto [th, fresh] = thresholds.try_emplace(func);
+        if (fresh) th->second = runtimes_.percentile(func, options_.percentile, options_.min_samples);
+        if (!th->second || static_cast<double>(elapsed) <= static_cast<double>(*th->second) * options_.slowdown) {
+            return;
+        }
+        // 慢节点上往往不止一个掉队任务，而刚换上去的任务还没显出慢：一段时间内整个节点都不放副本
+        slow_nodes_[e.copies[0].node] = now_ms + options_.slow_node_ttl.count();
+        if (e.speculated || in_flight_ >= budget) return;
+        Task copy = tasks_.materialize(h);             // 带新的取消标志
+        copy.task_id += kSuffix;
+        e.copies[1] = Copy{};
+        e.speculated = true;
+        ++in_flight_;
+        out.push_back(std::move(copy));
+        ++n;
+    });
+    std::erase_if(slow_nodes_, [&](const auto& kv) { return kv.second <= now_ms; });
+    for (const auto& [node, _] : slow_nodes_) avoid.push_back(node);
+    return n;
+}
+
+void Speculator::abandon(std::string_view copy_id) {
+    bool is_copy = false;
+    const std::string_view id = OriginalId(copy_id, is_copy);
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = running_.find(id);
+    if (!is_copy || it == running_.end() || !entries_[it->second.index].speculated) return;
+    entries_[it->second.index].speculated = false;
+    --in_flight_;
+    ++stats_.abandoned;
+    MaybeEraseLocked(it);
+}
+
+void Speculator::CopyDoneLocked(Entry& e) {
+    if (e.copies[1].done) return;
+    e.copies[1].live = false;
+    e.copies[1].done = true;
+    --in_flight_;
+}
+
+void Speculator::MaybeEraseLocked(Index::iterator it) {
+    const Entry& e = entries_[it->second.index];
+    if (!e.copies[0].done || (e.speculated && !e.copies[1].done)) return;
+    entries_[it->second.index] = Entry{};
+    tasks_.erase(it->second);
+    running_.erase(it);
+}
+
+Speculator::Outcome Speculator::on_finish(std::uint32_t, const Task& task, std::int64_t now_ms) {
+    bool is_copy = false;
+    const std::string_view id = OriginalId(task.task_id, is_copy);
+    Outcome out;
+    out.task_id = std::string(id);
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = running_.find(id);
+    if (it == running_.end()) {
+        out.counts = !is_copy;                         // 副本只在登记期间作数
+        return out;
+    }
+    Entry& e = entries_[it->second.index];
+    Copy& me = e.copies[is_copy];
+    Copy& other = e.copies[!is_copy];
+    const std::int64_t started = me.start_ms;
+    if (is_copy) {
+        CopyDoneLocked(e);
+    } else {
+        me.live = false;
+        me.done = true;
+    }
+
+    const bool ok = task.state == TaskState::SUCCESS;
+    // 另一份还没下发（刚放置）时不等它：这份的结果作数，那份下发前会被 on_dispatch 拦下
+    const bool other_running = e.speculated && other.live;
+    if (e.settled || (!ok && other_running)) {
+        out.counts = false;                            // 落败的一份，或失败了而另一份还有机会
+    } else {
+        e.settled = true;
+        if (ok) runtimes_.record(tasks_.cold(it->second)->func_name, now_ms - started);
+        if (ok && e.speculated) ++(is_copy ? stats_.won : stats_.lost);
+        if (other_running) {
+            other.cancelled->store(true, std::memory_order_release);
+            out.loser_node = other.node;
+            out.loser_id = is_copy ? out.task_id : out.task_id + std::string(kSuffix);
+        }
+    }
+    MaybeEraseLocked(it);
+    return out;
+}
+
+std::size_t Speculator::running() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return tasks_.size();
+}
+
+Speculator::Stats Speculator::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+} // namespace dts
@@ -0,0 +1,145 @@
+#include "task_queue.hpp"
+#include <functional>
+#include <memory>
+
+namespace dts {
+
+/* ---------- 分片索引 ---------- */
+TaskQueue::Entry* TaskQueue::Shard::find(std::uint64_t hash, std::string_view task_id) const {
+    if (buckets.empty()) return nullptr;
+    for (Entry* e = buckets[hash & (buckets.size() - 1)]; e; e = e->chain) {
+        if (e->hash == hash && e->task.task_id == task_id) return e;
+    }
+    return nullptr;
+}
+
+bool TaskQueue::Shard::insert(Entry* e) {
+    if (find(e->hash, e->task.task_id)) return false;
+    if (count + 1 > buckets.size()) {
+        std::vector<Entry*> grown(std::max<std::size_t>(64, buckets.size() * 2), nullptr);
+        for (Entry* head : buckets) {
+            while (head) {
+                Entry* next = head->chain;
+                Entry*& slot = grown[head->hash & (grown.size() - 1)];
+                head->chain = slot;
+                slot = head;
+                head = next;
+            }
+        }
+        buckets.swap(grown);
+    }
+    Entry*& slot = buckets[e->hash & (buckets.size() - 1)];
+    e->chain = slot;
+    slot = e;
+    ++count;
+    return true;
+}
+
+void TaskQueue::Shard::erase(Entry* e) {
+    for (Entry** p = &buckets[e->hash & (buckets.size() - 1)]; *p; p = &(*p)->chain) {
+        if (*p == e) {
+            *p = e->chain;
+            e->chain = nullptr;
+            --count;
+            return;
+        }
+    }
+}
+
+/* ---------- TaskQueue ---------- */
+TaskQueue::~TaskQueue() {
+    Entry* e = nullptr;
+    for (auto& lane : lanes_) {
+        while (lane.queue.dequeue(e)) delete e;
+    }
+}
+
+std::uint64_t TaskQueue::Hash(std::string_view task_id) {
+    return std::hash<std::string_view>{}(task_id);
+}
+
+bool TaskQueue::push(Task task) {
+    auto entry = std::make_unique<Entry>();
+    entry->task = std::move(task);
+    entry->hash = Hash(entry->task.task_id);
+    Lane& lane = lanes_[LaneOf(entry->task.priority)];
+    {
+        Shard& shard = ShardOf(entry->hash);
+        std::lock_guard<std::mutex> lk(shard.mu);
+        if (!shard.insert(entry.get())) return false;
+        // 计数在入通道之前加：出队方看到条目时 size_ 一定已经算上了它
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    lane.depth.fetch_add(1, std::memory_order_release);
+    lane.queue.enqueue(entry.release());
+    return true;
+}
+
+bool TaskQueue::cancel(std::string_view task_id) {
+    const std::uint64_t hash = Hash(task_id);
+    Task dead;
+    {
+        Shard& shard = ShardOf(hash);
+        std::lock_guard<std::mutex> lk(shard.mu);
+        Entry* e = shard.find(hash, task_id);
+        if (!e) return false;
+        shard.erase(e);
+        e->cancelled = true;
+        dead = std::move(e->task);                 // 墓碑只剩空壳
+        size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (dead.cancelled) dead.cancelled->store(true, std::memory_order_release);
+    return true;                                   // dead 在锁外析构
+}
+
+TaskQueue::Entry* TaskQueue::TakeFrom(Lane& lane) {
+    Entry* e = nullptr;
+    while (lane.depth.load(std::memory_order_acquire) > 0 && lane.queue.dequeue(e)) {
+        lane.depth.fetch_sub(1, std::memory_order_relaxed);
+        {
+            Shard& shard = ShardOf(e->hash);
+            std::lock_guard<std::mutex> lk(shard.mu);
+            if (!e->cancelled) {
+                shard.erase(e);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return e;
+            }
+        }
+        delete e;                                  // 墓碑：取消方已经摘过索引
+    }
+    return nullptr;
+}
+
+std::optional<Task> TaskQueue::pop() {
+    for (std::size_t l = kLanes; l-- > 0;) {
+        if (Entry* e = TakeFrom(lanes_[l])) {
+            std::optional<Task> out(std::move(e->task));
+            delete e;
+            return out;
+        }
+    }
+    return std::nullopt;
+}
+
+std::size_t TaskQueue::pop_batch(std::vector<Task>& out, std::size_t max) {
+    std::size_t n = 0;
+    for (std::size_t l = kLanes; l-- > 0 && n < max;) {
+        while (n < max) {
+            Entry* e = TakeFrom(lanes_[l]);
+            if (!e) break;
+            out.push_back(std::move(e->task));
+            delete e;
+            ++n;
+        }
+    }
+    return n;
+}
+
+bool TaskQueue::contains(std::string_view task_id) const {
+    const std::uint64_t hash = Hash(task_id);
+    const Shard& shard = ShardOf(hash);
+    std::lock_guard<std::mutex> lk(shard.mu);
+    return shard.find(hash, task_id) != nullptr;
+}
+
+} // namespace dts
@@ -0,0 +1,394 @@
+#include "task_scheduler.hpp"
+#include <algorithm>
+#include "cron_spec.hpp"
+
+namespace dts {
+
+TaskScheduler::TaskScheduler(std::unique_ptr<SchedulingAlgorithm> algorithm, NodeCapacityIndex nodes,
+                             DispatchFunc dispatch, SchedulerOptions options)
+    : algorithm_(std::move(algorithm)),
+      dispatch_(std::move(dispatch)),
+      options_(options),
+      queue_(options.fair_share),
+      nodes_(std::move(nodes)),
+      interval_us_(options.max_interval.count()) {
+    batch_.reserve(options_.max_batch);
+    if (options_.speculation.enabled) speculator_ = std::make_unique<Speculator>(options_.speculation);
+    if (options_.preemption.enabled) preemptor_ = std::make_unique<Preemptor>(options_.preemption);
+}
+
+TaskScheduler::TaskScheduler(std::unique_ptr<SchedulingAlgorithm> algorithm, std::shared_ptr<ClusterState> cluster,
+                             DispatchFunc dispatch, SchedulerOptions options)
+    : TaskScheduler(std::move(algorithm), NodeCapacityIndex(*cluster->snapshot()), std::move(dispatch), options) {
+    cluster_ = std::move(cluster);
+}
+
+TaskScheduler::~TaskScheduler() { stop(); }
+
+std::int64_t TaskScheduler::Now() const {
+    if (options_.clock) return options_.clock();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool TaskScheduler::submit(Task task) {
+    if (!task.parent_ids.empty()) {
+        std::vector<Task> one;
+        one.push_back(std::move(task));
+        return submit_dag(std::move(one));
+    }
+    return Admit(std::move(task));
+}
+
+bool TaskScheduler::submit_dag(std::vector<Task> tasks) {
+    std::vector<DagTracker::Ready> ready;
+    if (!dag_.submit(std::move(tasks), ready)) return false;
+    AdmitReady(ready);
+    return true;
+}
+
+void TaskScheduler::AdmitReady(std::vector<DagTracker::Ready>& ready) {
+    for (auto& r : ready) {
+        if (r.hint != NodeCapacityIndex::kNoNode) {
+            std::lock_guard<std::mutex> lk(affinity_mu_);
+            affinity_[r.task.task_id] = r.hint;
+        }
+        Admit(std::move(r.task));
+    }
+}
+
+bool TaskScheduler::Admit(Task task) {
+    if (!task.recurrence.empty()) {
+        auto spec = CronSpec::Parse(task.recurrence);
+        if (!spec) return false;
+        // 模板的 not_before_ts 记下一次触发时间；未指定时取下一个匹配点
+        if (task.not_before_ts <= 0) task.not_before_ts = spec->next_after(Now());
+        if (task.not_before_ts == CronSpec::kNever) return false;
+        const std::int64_t due = task.not_before_ts;
+        return timers_.schedule(std::move(task), due);
+    }
+    if (task.not_before_ts > Now()) {
+        const std::int64_t due = task.not_before_ts;
+        return timers_.schedule(std::move(task), due);
+    }
+    if (!queue_.push(std::move(task))) return false;
+    // 积压够一整批就不必等到下一个间隔
+    if (queue_.size() >= options_.max_batch && !wake_.exchange(true)) {
+        std::lock_guard<std::mutex> lk(wake_mu_);
+        wake_cv_.notify_one();
+    }
+    return true;
+}
+
+bool TaskScheduler::cancel(std::string_view task_id, std::vector<std::string>* skipped) {
+    std::vector<std::string> local;
+    std::vector<std::string>& out = skipped ? *skipped : local;
+    if (queue_.cancel(task_id) || timers_.cancel(task_id)) {
+        // 已放出但还没下发的 DAG 任务：按失败结束，下游跟着取消
+        std::vector<DagTracker::Ready> none;
+        dag_.complete(task_id, false, NodeCapacityIndex::kNoNode, none, out);
+        if (preemptor_) preemptor_->drop_claim(task_id);
+        std::lock_guard<std::mutex> lk(affinity_mu_);
+        if (auto it = affinity_.find(std::string(task_id)); it != affinity_.end()) affinity_.erase(it);
+        return true;
+    }
+    return dag_.cancel(task_id, out);
+}
+
+void TaskScheduler::ReleaseDue() {
+    const std::int64_t now = Now();
+    if (timers_.next_due() > now) return;             // 常见路径：只看一眼堆顶
+    due_.clear();
+    timers_.release_due(now, due_, options_.max_batch);
+    for (auto& t : due_) {
+        if (t.recurrence.empty()) {
+            queue_.push(std::move(t));
+            continue;
+        }
+        auto spec = CronSpec::Parse(t.recurrence);
+        const std::int64_t fire = t.not_before_ts;
+        Task instance = t;
+        instance.task_id += "#" + std::to_string(fire);
+        instance.recurrence.clear();
+        queue_.push(std::move(instance));
+        // 落后（调度器停过）时错过的触发合并成刚才这一次，不补发
+        std::int64_t next = spec ? spec->next_after(fire) : CronSpec::kNever;
+        if (next <= now) next = spec->next_after(now);
+        if (next == CronSpec::kNever) continue;
+        t.not_before_ts = next;
+        timers_.schedule(std::move(t), next);
+    }
+    fired_ += due_.size();
+}
+
+void TaskScheduler::ReleaseNode(std::uint32_t node, const Resource& used) {
+    if (cluster_) {
+        cluster_->release(node, used);
+    } else {
+        std::lock_guard<std::mutex> lk(nodes_mu_);
+        nodes_.release(node, used);
+    }
+}
+
+void TaskScheduler::release(std::uint32_t node, const Resource& used, std::string_view client_id) {
+    ReleaseNode(node, used);
+    queue_.release(client_id, used);
+}
+
+std::vector<std::string> TaskScheduler::finish(std::uint32_t node, const Task& task) {
+    std::vector<std::string> skipped;
+    auto id = settle(node, task);
+    if (id) complete(node, *id, task.state == TaskState::SUCCESS, skipped);
+    return skipped;
+}
+
+std::optional<std::string> TaskScheduler::settle(std::uint32_t node, const Task& task) {
+    const bool copy = task.task_id.ends_with(Speculator::kSuffix);
+    std::optional<Task> again;
+    if (preemptor_ && !copy) again = preemptor_->on_finish(task);
+    // 副本不经租户队列、只占节点资源；被抢占的任务由 requeue 退还租户占用
+    if (copy || again) ReleaseNode(node, task.required); else release(node, task.required, task.client_id);
+    std::optional<std::string> id = task.task_id;
+    if (speculator_) {
+        auto outcome = speculator_->on_finish(node, task, Now());
+        if (!outcome.loser_id.empty() && cancel_) cancel_(outcome.loser_node, outcome.loser_id);
+        if (outcome.counts) id = std::move(outcome.task_id); else id.reset();
+    }
+    if (!again) return id;
+    // 被抢占：推测副本还在跑时由副本出结果，否则原样回队
+    if (id) queue_.requeue(std::move(*again)); else queue_.release(again->client_id, again->required);
+    return std::nullopt;
+}
+
+bool TaskScheduler::complete(std::uint32_t node, std::string_view task_id, bool success,
+                             std::vector<std::string>& skipped) {
+    std::vector<DagTracker::Ready> ready;
+    if (!dag_.complete(task_id, success, node, ready, skipped)) return false;
+    AdmitReady(ready);
+    return true;
+}
+
+std::size_t TaskScheduler::PlaceHinted() {
+    // 有亲和节点（DAG 关键上游所在、抢占空出）的任务挪到批首、直接在该节点预留；放不下的交给算法
+    hinted_.clear();
+    std::lock_guard<std::mutex> lk(affinity_mu_);
+    const bool claims = preemptor_ && preemptor_->has_claims();
+    if (affinity_.empty() && !claims) return 0;
+    for (std::size_t i = 0; i < batch_.size(); ++i) {
+        std::uint32_t node = NodeCapacityIndex::kNoNode;
+        bool affine = false;
+        if (auto it = affinity_.find(batch_[i].task_id); it != affinity_.end()) {
+            node = it->second;
+            affine = true;
+            affinity_.erase(it);
+        } else if (claims) {
+            node = preemptor_->claim(batch_[i].task_id);
+        }
+        if (node >= nodes_.size() || !nodes_.node(node).schedulable || !nodes_.reserve(node, batch_[i].required)) {
+            continue;
+        }
+        if (affine) ++co_located_;
+        std::swap(batch_[i], batch_[hinted_.size()]);
+        hinted_.push_back(node);
+    }
+    return hinted_.size();
+}
+
+void TaskScheduler::PlaceSpeculative(std::int64_t now) {
+    // 副本排在批尾，屏蔽掉队任务所在的节点做 best-fit
+    const std::size_t first = batch_.size();
+    spec_avoid_.clear();
+    if (speculator_->scan(now, batch_, spec_avoid_) == 0) return;
+    std::erase_if(spec_avoid_, [&](std::uint32_t n) { return n >= nodes_.size() || !nodes_.node(n).schedulable; });
+    for (std::uint32_t n : spec_avoid_) nodes_.set_schedulable(n, false);
+    for (std::size_t i = first; i < batch_.size(); ++i) {
+        std::uint32_t node = nodes_.best_fit(batch_[i].required);
+        if (node != NodeCapacityIndex::kNoNode && !nodes_.reserve(node, batch_[i].required)) {
+            node = NodeCapacityIndex::kNoNode;
+        }
+        placement_.push_back(node);
+    }
+    for (std::uint32_t n : spec_avoid_) nodes_.set_schedulable(n, true);
+}
+
+void TaskScheduler::Preempt(std::size_t regular, std::int64_t now) {
+    // 批内放不下的任务按优先级从高到低挑受害者
+    urgent_.clear();
+    for (std::uint32_t i = 0; i < regular; ++i) {
+        if (placement_[i] == NodeCapacityIndex::kNoNode &&
+            batch_[i].priority >= options_.preemption.min_priority) {
+            urgent_.push_back(i);
+        }
+    }
+    std::stable_sort(urgent_.begin(), urgent_.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return batch_[a].priority > batch_[b].priority; });
+    std::size_t n = 0;
+    for (std::uint32_t i : urgent_) {
+        if (n == options_.preemption.max_per_cycle) break;
+        if (preemptor_->preempt(batch_[i], nodes_, now, victims_)) ++n;
+    }
+}
+
+std::size_t TaskScheduler::run_cycle() {
+    std::lock_guard<std::mutex> cycle(cycle_mu_);
+    const auto t0 = std::chrono::steady_clock::now();
+    ++cycles_;
+
+    ReleaseDue();
+    batch_.clear();
+    if (queue_.empty() && steal_) {
+        // 偷来的任务先进本地队列，按本地租户记账
+        std::vector<Task> stolen;
+        steal_(stolen, options_.max_batch);
+        stolen_ += stolen.size();
+        for (auto& t : stolen) queue_.push(std::move(t));
+    }
+    const std::size_t regular = queue_.drain(batch_, options_.max_batch);
+    const std::int64_t now = speculator_ || preemptor_ ? Now() : 0;
+    const bool scan = speculator_ && now >= next_scan_ms_;
+    if (regular == 0 && !scan) {
+        AdaptInterval();
+        return 0;
+    }
+
+    // 放置与分组在一把锁内完成：节点视图只在这里和 release/update_nodes 里改
+    by_node_.clear();
+    node_ids_.clear();
+    std::size_t conflicts = 0;
+    {
+        std::lock_guard<std::mutex> lk(nodes_mu_);
+        if (cluster_) {
+            nodes_ = *cluster_->snapshot();
+            nodes_.set_tiebreak(options_.tiebreak);
+        }
+        const std::size_t hinted = PlaceHinted();
+        // 受害者还没退完的节点只留给抢占它们的任务
+        claimed_.clear();
+        if (preemptor_) preemptor_->claimed_nodes(claimed_);
+        std::erase_if(claimed_, [&](std::uint32_t n) { return n >= nodes_.size() || !nodes_.node(n).schedulable; });
+        for (std::uint32_t n : claimed_) nodes_.set_schedulable(n, false);
+        algorithm_->place(std::span<const Task>(batch_).subspan(hinted), nodes_, placement_);
+        placement_.insert(placement_.begin(), hinted_.begin(), hinted_.end());
+        if (scan) {
+            next_scan_ms_ = now + options_.speculation.scan_interval.count();
+            PlaceSpeculative(now);
+        }
+        for (std::uint32_t n : claimed_) nodes_.set_schedulable(n, true);
+        victims_.clear();
+        if (preemptor_) Preempt(regular, now);
+        for (std::uint32_t i = 0; i < batch_.size(); ++i) {
+            if (placement_[i] == NodeCapacityIndex::kNoNode) continue;
+            // 快照可能已过期：以原子计数为准，抢不到就回队
+            if (cluster_ && !cluster_->try_reserve(placement_[i], batch_[i].required)) {
+                placement_[i] = NodeCapacityIndex::kNoNode;
+                ++conflicts;
+                continue;
+            }
+            by_node_.push_back(i);
+        }
+        std::stable_sort(by_node_.begin(), by_node_.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return placement_[a] < placement_[b]; });
+        for (std::size_t k = 0; k < by_node_.size(); ++k) {
+            if (k == 0 || placement_[by_node_[k]] != placement_[by_node_[k - 1]]) {
+                node_ids_.push_back(nodes_.node(placement_[by_node_[k]]).node_id);
+            }
+        }
+    }
+
+    // 放不下的回队尾（退还租户额度），下一轮再试；放不下的推测副本直接放弃
+    std::size_t requeued = 0;
+    for (std::uint32_t i = 0; i < batch_.size(); ++i) {
+        if (placement_[i] != NodeCapacityIndex::kNoNode) continue;
+        if (i >= regular) {
+            speculator_->abandon(batch_[i].task_id);
+            continue;
+        }
+        queue_.requeue(std::move(batch_[i]));
+        ++requeued;
+    }
+
+    std::size_t messages = 0, sent = 0;
+    for (std::size_t k = 0, g = 0; k < by_node_.size(); ++g) {
+        const std::uint32_t node = placement_[by_node_[k]];
+        std::vector<Task> msg;
+        for (; k < by_node_.size() && placement_[by_node_[k]] == node; ++k) {
+            Task& t = batch_[by_node_[k]];
+            if (speculator_ && !speculator_->on_dispatch(node, t, now)) {
+                ReleaseNode(node, t.required);            // 副本放好时原任务已出结果
+                continue;
+            }
+            if (preemptor_ && !t.task_id.ends_with(Speculator::kSuffix)) preemptor_->on_dispatch(node, t, now);
+            msg.push_back(std::move(t));
+        }
+        if (msg.empty()) continue;
+        sent += msg.size();
+        ++messages;
+        dispatch_(node, node_ids_[g], std::move(msg));
+    }
+    if (cancel_) {
+        for (const auto& v : victims_) cancel_(v.node, v.task_id);
+    }
+
+    dispatched_ += sent;
+    messages_ += messages;
+    requeued_ += requeued;
+    conflicts_ += conflicts;
+    last_cycle_us_ = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count());
+    AdaptInterval();
+    return sent;
+}
+
+void TaskScheduler::AdaptInterval() {
+    const double depth = static_cast<double>(queue_.size());
+    const double fill = std::min(1.0, depth / static_cast<double>(std::max<std::size_t>(1, options_.max_batch)));
+    const auto lo = options_.min_interval.count(), hi = options_.max_interval.count();
+    interval_us_ = hi - static_cast<std::int64_t>(static_cast<double>(hi - lo) * fill);
+}
+
+void TaskScheduler::Loop() {
+    while (running_.load(std::memory_order_acquire)) {
+        run_cycle();
+        std::unique_lock<std::mutex> lk(wake_mu_);
+        wake_cv_.wait_for(lk, interval(), [&] {
+            return wake_.load() || !running_.load(std::memory_order_acquire);
+        });
+        wake_ = false;
+    }
+}
+
+void TaskScheduler::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread([this] { Loop(); });
+}
+
+void TaskScheduler::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lk(wake_mu_);
+        wake_cv_.notify_one();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+TaskScheduler::Stats TaskScheduler::stats() const {
+    Stats st;
+    st.cycles = cycles_.load();
+    st.dispatched = dispatched_.load();
+    st.messages = messages_.load();
+    st.requeued = requeued_.load();
+    st.conflicts = conflicts_.load();
+    st.stolen = stolen_.load();
+    st.fired = fired_.load();
+    st.co_located = co_located_.load();
+    if (speculator_) {
+        const auto spec = speculator_->stats();
+        st.speculated = spec.launched;
+        st.spec_won = spec.won;
+    }
+    if (preemptor_) st.preempted = preemptor_->stats().preempted;
+    st.last_cycle_us = last_cycle_us_.load();
+    return st;
+}
+
+} // namespace dts
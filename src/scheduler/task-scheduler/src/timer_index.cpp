@@ -0,0 +1,69 @@
+#include "timer_index.hpp"
+#include <algorithm>
+
+namespace dts {
+
+bool TimerIndex::schedule(Task task, std::int64_t due_ms) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const std::uint64_t seq = next_seq_++;
+    if (!live_.try_emplace(task.task_id, seq).second) return false;
+    heap_.push_back(Item{due_ms, seq, std::make_unique<Task>(std::move(task))});
+    std::push_heap(heap_.begin(), heap_.end(), Later{});
+    return true;
+}
+
+bool TimerIndex::cancel(std::string_view task_id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = live_.find(task_id);
+    if (it == live_.end()) return false;
+    live_.erase(it);
+    if (heap_.size() > 64 && live_.size() < heap_.size() / 2) {
+        // 墓碑过半：重建，免得大批取消后的堆长期占着内存
+        std::erase_if(heap_, [&](const Item& item) {
+            auto l = live_.find(item.task->task_id);
+            return l == live_.end() || l->second != item.seq;
+        });
+        std::make_heap(heap_.begin(), heap_.end(), Later{});
+    } else {
+        PopTombstonesLocked();
+    }
+    return true;
+}
+
+void TimerIndex::PopTombstonesLocked() {
+    while (!heap_.empty()) {
+        auto l = live_.find(heap_.front().task->task_id);
+        if (l != live_.end() && l->second == heap_.front().seq) return;
+        std::pop_heap(heap_.begin(), heap_.end(), Later{});
+        heap_.pop_back();
+    }
+}
+
+std::size_t TimerIndex::release_due(std::int64_t now_ms, std::vector<Task>& out, std::size_t max) {
+    std::lock_guard<std::mutex> lk(mu_);
+    std::size_t n = 0;
+    while (n < max && !heap_.empty() && heap_.front().due <= now_ms) {
+        std::pop_heap(heap_.begin(), heap_.end(), Later{});
+        Item item = std::move(heap_.back());
+        heap_.pop_back();
+        auto l = live_.find(item.task->task_id);
+        if (l == live_.end() || l->second != item.seq) continue;
+        live_.erase(l);
+        out.push_back(std::move(*item.task));
+        ++n;
+    }
+    PopTombstonesLocked();
+    return n;
+}
+
+std::int64_t TimerIndex::next_due() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return heap_.empty() ? INT64_MAX : heap_.front().due;
+}
+
+std::size_t TimerIndex::size() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return live_.size();
+}
+
+} // namespace dts
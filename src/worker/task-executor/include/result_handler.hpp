@@ -0,0 +1,47 @@
+// result_handler.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "task.hpp"
+
+namespace dts {
+
+// 本节点最近成功的任务结果。调度器把 DAG 下游尽量放在上游所在节点，
+// 下游开跑前从这里取上游的 result 与输出附件，不经 API Server 往返。
+// 只存有下游的任务（child_count 非零），每个下游取一次，都取过后即释放；
+// 下游可能被放到别的节点、永远不来取，所以仍按完成先后淘汰，最多留 capacity 个。附件只共享缓冲区，不拷贝数据。
+class ResultHandler {
+public:
+    explicit ResultHandler(std::size_t capacity = 4096);
+
+    // 任务成功后、对外报告 SUCCESS 之前调用，下游看到上游成功时结果已在；consumers 为下游个数，0 不存
+    void store(const std::string& task_id, const nlohmann::json& result, const std::vector<Attachment>& outputs,
+               std::uint32_t consumers);
+    // 本节点有的上游：result 并入 func_params["parents"][上游 id]，
+    // 输出附件改名为 "<上游 id>/<名字>" 追加到 inputs；返回新并入的上游数。没找到的留给调用方从别处取。
+    // 每并入一个上游记它被取过一次，下游都取过的上游随即释放
+    std::size_t attach(Task& task);
+
+    std::size_t size() const;
+
+private:
+    struct Entry {
+        nlohmann::json          result;
+        std::vector<Attachment> outputs;
+        std::uint32_t           remaining = 0;   // 还没来取的下游数
+        std::list<std::string>::iterator pos;    // 在 order_ 中的位置
+    };
+
+    std::size_t capacity_;
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, Entry> results_;
+    std::list<std::string> order_;                   // 完成先后，队头最旧
+};
+
+} // namespace dts
@@ -2,11 +2,14 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <boost/asio.hpp>
 #include "task.hpp"
 #include "thread_pool.hpp"
+#include "task_pool.hpp"
+#include "result_handler.hpp"
 
 namespace dts {
 
@@ -20,12 +23,24 @@ public:
     // 注册任务处理函数
     void register_function(const std::string& func_name, TaskFunction func);
 
-    // 执行任务（异步）
+    // 执行任务（异步）；task 建议由 TaskPool::make() 分配
     void execute_task(std::shared_ptr<Task> task);
 
+    // 抢占本节点上在跑的任务（调度器的取消钩子经 CancelTask 转到这里）：置取消标志，
+    // 函数返回后报告 CANCELLED 而不是 SUCCESS，返回值原样留在 result 里——
+    // 支持续跑的函数在看到取消标志时返回 {"checkpoint": ...}，调度器回队时把它放进 func_params。
+    // 任务不在本执行器上跑时返回 false
+    bool preempt(const std::string& task_id);
+
+    // 本节点的结果缓存：DAG 下游开跑前从这里取上游结果
+    ResultHandler& results() { return results_; }
+
 private:
-    // 实际执行任务的逻辑
-    void run_task(std::shared_ptr<Task> task);
+    // 实际执行任务的逻辑（借用调用方的引用，不额外增减引用计数）
+    void run_task(const std::shared_ptr<Task>& task);
+
+    // 被抢占的任务取走标记，没被抢占返回 false
+    bool take_preempted(const std::string& task_id);
 
     // 检查资源需求是否满足
     bool check_resources(const Resource& required);
@@ -34,7 +49,7 @@ private:
     static bool is_retryable_error(const boost::system::error_code& ec);
 
     // 更新任务状态
-    void update_task_state(std::shared_ptr<Task> task, TaskState state,
+    void update_task_state(const std::shared_ptr<Task>& task, TaskState state,
                           const nlohmann::json& result = {}, const std::string& error_msg = "");
 
     boost::asio::io_context& io_context_;  // 用于异步执行
@@ -44,6 +59,9 @@ private:
 
     inline static std::atomic<int> retrying_cnt{0};
     static constexpr int MAX_CONCURRENT_RETRY = 10;
+    ResultHandler results_;
+    std::mutex running_mu_;
+    std::unordered_map<std::string, std::pair<std::shared_ptr<Task>, bool>> running_;   // 在跑任务 -> 是否被抢占
     ThreadPool thread_pool_;
 };
 
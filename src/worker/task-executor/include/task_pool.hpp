@@ -0,0 +1,185 @@
+// task_pool.hpp
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "task.hpp"
+
+namespace dts {
+
+namespace slab {
+
+struct FreeNode { FreeNode* next; };
+
+// 占用统计（按使用方的 Tag 区分）
+struct Counters {
+    std::atomic<std::size_t> live{0};
+    std::atomic<std::size_t> high_water{0};
+
+    void on_alloc() {
+        std::size_t now = live.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::size_t hw  = high_water.load(std::memory_order_relaxed);
+        while (now > hw &&
+               !high_water.compare_exchange_weak(hw, now, std::memory_order_relaxed)) {}
+    }
+    void on_free() { live.fetch_sub(1, std::memory_order_relaxed); }
+};
+
+template <class Tag>
+Counters& counters() {
+    static Counters c;
+    return c;
+}
+
+// 全局仓库：线程缓存溢出或线程退出时整批归还，线程缓存缺货时整批取走。
+// 只有仓库也空时才向全局堆切一块新 slab（kBatch 个块），之后一直复用、不还给系统。
+template <std::size_t Size, std::size_t Align>
+class Depot {
+public:
+    static constexpr std::size_t kBatch = 64;
+
+    // 故意不析构：主线程的 thread_local 缓存可能晚于静态对象析构才归还
+    static Depot& instance() {
+        static Depot* d = new Depot;
+        return *d;
+    }
+
+    // 取一批；仓库为空时切新 slab
+    FreeNode* take(std::size_t& n) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!batches_.empty()) {
+            auto [head, cnt] = batches_.back();
+            batches_.pop_back();
+            n = cnt;
+            return head;
+        }
+        auto* mem = static_cast<char*>(::operator new(Size * kBatch, std::align_val_t(Align)));
+        slabs_.push_back(mem);
+        FreeNode* head = nullptr;
+        for (std::size_t i = kBatch; i-- > 0;) {
+            auto* node = reinterpret_cast<FreeNode*>(mem + i * Size);
+            node->next = head;
+            head = node;
+        }
+        n = kBatch;
+        return head;
+    }
+
+    void give(FreeNode* head, std::size_t n) {
+        if (!head) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        batches_.emplace_back(head, n);
+    }
+
+private:
+    Depot() = default;
+    std::mutex mu_;
+    std::vector<std::pair<FreeNode*, std::size_t>> batches_;
+    std::vector<char*> slabs_;
+};
+
+// 每线程缓存：分配/释放只动本地链表，不加锁、不碰 malloc
+template <std::size_t Size, std::size_t Align>
+class ThreadCache {
+public:
+    using DepotT = Depot<Size, Align>;
+
+    void* allocate() {
+        if (!head_) head_ = DepotT::instance().take(count_);
+        FreeNode* n = head_;
+        head_ = n->next;
+        --count_;
+        return n;
+    }
+
+    void deallocate(void* p) {
+        auto* n = static_cast<FreeNode*>(p);
+        n->next = head_;
+        head_ = n;
+        // 本地囤太多（常见于“A 线程分配、B 线程释放”）时整批还给仓库
+        if (++count_ >= 2 * DepotT::kBatch) {
+            FreeNode* batch = head_;
+            FreeNode* tail  = head_;
+            for (std::size_t i = 1; i < DepotT::kBatch; ++i) tail = tail->next;
+            head_ = tail->next;
+            tail->next = nullptr;
+            count_ -= DepotT::kBatch;
+            DepotT::instance().give(batch, DepotT::kBatch);
+        }
+    }
+
+    ~ThreadCache() { DepotT::instance().give(head_, count_); }
+
+private:
+    FreeNode* head_ = nullptr;
+    std::size_t count_ = 0;
+};
+
+template <std::size_t Size, std::size_t Align>
+ThreadCache<Size, Align>& thread_cache() {
+    thread_local ThreadCache<Size, Align> cache;
+    return cache;
+}
+
+struct DefaultTag {};
+
+} // namespace slab
+
+// 定长块分配器：配合 std::allocate_shared，对象与控制块同处一个池化块
+template <class T, class Tag = slab::DefaultTag>
+class SlabAllocator {
+public:
+    using value_type = T;
+    template <class U> struct rebind { using other = SlabAllocator<U, Tag>; };
+
+    SlabAllocator() noexcept = default;
+    template <class U>
+    SlabAllocator(const SlabAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(kAlign)));
+        }
+        slab::counters<Tag>().on_alloc();
+        return static_cast<T*>(slab::thread_cache<kSize, kAlign>().allocate());
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n != 1) {
+            ::operator delete(p, std::align_val_t(kAlign));
+            return;
+        }
+        slab::counters<Tag>().on_free();
+        slab::thread_cache<kSize, kAlign>().deallocate(p);
+    }
+
+    template <class U>
+    bool operator==(const SlabAllocator<U, Tag>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const SlabAllocator<U, Tag>&) const noexcept { return false; }
+
+private:
+    static constexpr std::size_t kAlign = std::max(alignof(T), alignof(slab::FreeNode));
+    static constexpr std::size_t kSize =
+        (std::max(sizeof(T), sizeof(slab::FreeNode)) + kAlign - 1) / kAlign * kAlign;
+};
+
+// Worker 侧 Task 对象池：Task + 控制块 + 取消标志都从每线程 slab 中取
+class TaskPool {
+public:
+    struct Stats {
+        std::size_t live;          // 当前在用的 Task
+        std::size_t high_water;    // 历史峰值
+    };
+
+    static std::shared_ptr<Task> make();
+    static Stats stats();
+};
+
+} // namespace dts
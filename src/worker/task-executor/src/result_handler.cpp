@@ -0,0 +1,49 @@
+#include "result_handler.hpp"
+
+namespace dts {
+
+ResultHandler::ResultHandler(std::size_t capacity) : capacity_(capacity) {}
+
+void ResultHandler::store(const std::string& task_id, const nlohmann::json& result,
+                          const std::vector<Attachment>& outputs, std::uint32_t consumers) {
+    if (capacity_ == 0 || consumers == 0) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    auto [it, inserted] = results_.insert_or_assign(task_id, Entry{result, outputs, consumers, {}});
+    if (!inserted) {
+        order_.erase(it->second.pos);                  // 同 id 重跑：以这次为准，排到队尾
+    }
+    it->second.pos = order_.insert(order_.end(), task_id);
+    while (order_.size() > capacity_) {
+        results_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+std::size_t ResultHandler::attach(Task& task) {
+    std::size_t found = 0;
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& pid : task.parent_ids) {
+        auto it = results_.find(pid);
+        if (it == results_.end()) continue;
+        if (!task.func_params.is_object()) task.func_params = nlohmann::json::object();
+        // 重试时再走一遍，已经并过的不重复追加附件
+        if (task.func_params.contains("parents") && task.func_params["parents"].contains(pid)) continue;
+        task.func_params["parents"][pid] = it->second.result;
+        for (const auto& out : it->second.outputs) {
+            task.inputs.push_back(Attachment{pid + "/" + out.name, out.content_type, out.data});
+        }
+        ++found;
+        if (--it->second.remaining == 0) {
+            order_.erase(it->second.pos);
+            results_.erase(it);
+        }
+    }
+    return found;
+}
+
+std::size_t ResultHandler::size() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return results_.size();
+}
+
+} // namespace dts
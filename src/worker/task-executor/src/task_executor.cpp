@@ -34,12 +34,37 @@ void TaskExecutor::register_function(const std::string& func_name, TaskFunction
 
 void TaskExecutor::execute_task(std::shared_ptr<Task> task) {
     // 使用线程池异步提交任务（结合io_context，如果需要Asio操作可在run_task内post）
-    thread_pool_.enqueue([this, task]() {
+    thread_pool_.enqueue([this, task = std::move(task)]() {
+        {
+            std::lock_guard<std::mutex> lk(running_mu_);
+            running_[task->task_id] = {task, false};
+        }
         run_task(task);
+        std::lock_guard<std::mutex> lk(running_mu_);
+        if (auto it = running_.find(task->task_id); it != running_.end() && it->second.first == task) {
+            running_.erase(it);
+        }
     });
 }
 
-void TaskExecutor::run_task(std::shared_ptr<Task> task) {
+bool TaskExecutor::preempt(const std::string& task_id) {
+    std::lock_guard<std::mutex> lk(running_mu_);
+    auto it = running_.find(task_id);
+    if (it == running_.end()) return false;
+    it->second.second = true;
+    it->second.first->cancelled->store(true, std::memory_order_release);
+    return true;
+}
+
+bool TaskExecutor::take_preempted(const std::string& task_id) {
+    std::lock_guard<std::mutex> lk(running_mu_);
+    auto it = running_.find(task_id);
+    if (it == running_.end() || !it->second.second) return false;
+    it->second.second = false;
+    return true;
+}
+
+void TaskExecutor::run_task(const std::shared_ptr<Task>& task) {
     // 1. 检查资源
     if (!check_resources(task->required)) {
         update_task_state(task, TaskState::FAILED, {}, "Insufficient resources");
@@ -77,13 +102,29 @@ void TaskExecutor::run_task(std::shared_ptr<Task> task) {
             throw std::runtime_error("Unknown function: " + task->func_name);
         }
 
+        // DAG 下游：同节点跑过的上游结果直接并入参数
+        if (!task->parent_ids.empty()) results_.attach(*task);
+
         // 执行函数
         nlohmann::json result = it->second(task->func_params, task);
 
-        // 成功：更新状态并取消定时器
+        // 被抢占：结果（可能带 checkpoint）交回调度器，不当作成功
+        if (take_preempted(task->task_id)) {
+            update_task_state(task, TaskState::CANCELLED, result, "Preempted");
+            exec_timer->cancel();
+            return;
+        }
+
+        // 成功：有下游的结果先留在本节点，再更新状态并取消定时器
+        if (task->child_count > 0) results_.store(task->task_id, result, task->outputs, task->child_count);
         update_task_state(task, TaskState::SUCCESS, result);
         exec_timer->cancel();
     } catch (const std::exception& e) {  // 捕获更广泛的异常（包括std::runtime_error等）
+        if (take_preempted(task->task_id)) {
+            update_task_state(task, TaskState::CANCELLED, {}, "Preempted");
+            exec_timer->cancel();
+            return;
+        }
 
         // 检查是否可重试
         boost::system::error_code ec;  // 默认无error_code，需根据异常类型判断
@@ -124,7 +165,7 @@ bool TaskExecutor::check_resources(const Resource& required) {
            required.mem_mb <= available_resources_.mem_mb;
 }
 
-void TaskExecutor::update_task_state(std::shared_ptr<Task> task, TaskState state,
+void TaskExecutor::update_task_state(const std::shared_ptr<Task>& task, TaskState state,
                                      const nlohmann::json& result, const std::string& error_msg) {
     task->state = state;
     task->result = result;
@@ -0,0 +1,22 @@
+#include "task_pool.hpp"
+
+namespace dts {
+
+namespace {
+struct TaskTag {};
+struct CancelFlagTag {};
+}
+
+std::shared_ptr<Task> TaskPool::make() {
+    auto flag = std::allocate_shared<std::atomic<bool>>(
+        SlabAllocator<std::atomic<bool>, CancelFlagTag>{}, false);
+    return std::allocate_shared<Task>(SlabAllocator<Task, TaskTag>{}, std::move(flag));
+}
+
+TaskPool::Stats TaskPool::stats() {
+    auto& c = slab::counters<TaskTag>();
+    return Stats{c.live.load(std::memory_order_relaxed),
+                 c.high_water.load(std::memory_order_relaxed)};
+}
+
+} // namespace dts
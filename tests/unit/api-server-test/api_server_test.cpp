@@ -12,11 +12,26 @@ protected:
     static void SetUpTestSuite() {
         LOG(INFO) << "[TestSuite] Starting AsyncServer ...";
         server_ = std::make_unique<AsyncServer>();
+        // 固定上下文数：控制器不伸缩，稳态用例据此断言不再构造新上下文
+        AdaptiveLimits limits;
+        limits.min_contexts = limits.max_contexts = 16;
+        server_->SetAdaptiveLimits(limits);
         server_->SetSubmitTaskHandler([](Task* req, TaskResponse* resp) {
             resp->mutable_task()->CopyFrom(*req);
             resp->mutable_task()->set_state(dts::proto::SUCCESS);
             VLOG(1) << "[Handler] task_id=" << req->task_id(); // 只有 -v=1 才可见
         });
+        server_->SetQueryStatusHandler([](const QueryRequest& req, Task* out) {
+            if (req.task_id().rfind("known-", 0) != 0)
+                return grpc::Status(grpc::StatusCode::NOT_FOUND, "unknown task");
+            out->set_task_id(req.task_id());
+            out->set_state(dts::proto::RUNNING);
+            return grpc::Status::OK;
+        });
+        server_->SetCancelTaskHandler([](const CancelRequest& req, CancelResponse* resp) {
+            resp->set_success(req.task_id().rfind("known-", 0) == 0);
+            return grpc::Status::OK;
+        });
         server_->Run(0);
         channel_ = grpc::CreateChannel(
             "127.0.0.1:" + std::to_string(server_->ListenPort()),
@@ -105,6 +120,730 @@ TEST_F(AsyncServerTest, ConcurrentSubmit) {
     EXPECT_EQ(ok_count.load(), kThreads * kReqPerThread);
 }
 
+/* ---------- 上下文原地复用 ---------- */
+// 稳态下不再构造新的上下文对象：跑完一批并发 RPC，allocated 不变，rearmed 随之增长
+TEST_F(AsyncServerTest, ContextsRearmInPlace) {
+    constexpr int kThreads = 4;
+    constexpr int kReqPerThread = 2'500;
+    const auto before = SubmitTaskCall::Stats();
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ths;
+    for (int t = 0; t < kThreads; ++t) {
+        ths.emplace_back([] {
+            Task req;
+            TaskResponse resp;
+            for (int i = 0; i < kReqPerThread; ++i) {
+                req.set_task_id(std::to_string(i));
+                grpc::ClientContext ctx;
+                ASSERT_TRUE(stub_->SubmitTask(&ctx, req, &resp).ok());
+            }
+        });
+    }
+    for (auto& th : ths) th.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // 服务端的 Finish 完成事件可能晚于客户端拿到回包，稍等复位追上
+    const std::size_t want = before.rearmed + kThreads * kReqPerThread;
+    for (int i = 0; i < 200 && SubmitTaskCall::Stats().rearmed < want; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    const auto after = SubmitTaskCall::Stats();
+    std::cout << "[Rearm] " << kThreads * kReqPerThread << " rpc, "
+              << static_cast<long>(kThreads * kReqPerThread / secs) << " rpc/s, new contexts="
+              << after.allocated - before.allocated << std::endl;
+    EXPECT_EQ(after.allocated, before.allocated);
+    EXPECT_GE(after.rearmed - before.rearmed, static_cast<std::size_t>(kThreads * kReqPerThread));
+}
+
+/* ---------- 查询 / 取消 ---------- */
+TEST_F(AsyncServerTest, QueryStatusAndCancel) {
+    {
+        QueryRequest req;
+        req.set_task_id("known-1");
+        Task resp;
+        grpc::ClientContext ctx;
+        ASSERT_TRUE(stub_->QueryStatus(&ctx, req, &resp).ok());
+        EXPECT_EQ(resp.task_id(), "known-1");
+        EXPECT_EQ(resp.state(), dts::proto::RUNNING);
+    }
+    {
+        QueryRequest req;
+        req.set_task_id("missing");
+        Task resp;
+        grpc::ClientContext ctx;
+        EXPECT_EQ(stub_->QueryStatus(&ctx, req, &resp).error_code(), grpc::StatusCode::NOT_FOUND);
+    }
+    for (const char* id : {"known-2", "missing"}) {
+        CancelRequest req;
+        req.set_task_id(id);
+        CancelResponse resp;
+        grpc::ClientContext ctx;
+        ASSERT_TRUE(stub_->CancelTask(&ctx, req, &resp).ok());
+        EXPECT_EQ(resp.success(), std::string(id) == "known-2");
+    }
+}
+
+/* ---------- 结果订阅流 ---------- */
+TEST_F(AsyncServerTest, ListenResultsReceivesPublished) {
+    const std::size_t base = server_->SubscriberCount();
+    grpc::ClientContext ctx;
+    SubscribeRequest sub;
+    sub.set_client_id("listener-a");
+    auto reader = stub_->ListenResults(&ctx, sub);
+
+    // 等服务端登记完成（流建立是异步的）
+    for (int i = 0; i < 200 && server_->SubscriberCount() == base; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_EQ(server_->SubscriberCount(), base + 1);
+
+    constexpr int kResults = 300;
+    Task t;
+    t.set_client_id("other");
+    EXPECT_EQ(server_->PublishResult(t), 0u);      // 别的 client 收不到
+    t.set_client_id("listener-a");
+    for (int i = 0; i < kResults; ++i) {
+        t.set_task_id(std::to_string(i));
+        EXPECT_EQ(server_->PublishResult(t), 1u);
+    }
+
+    // 首条消息告知游标；之后的结果按序号连续到达，积压时多条合成一条消息
+    TaskResult r;
+    ASSERT_TRUE(reader->Read(&r));
+    std::uint64_t next = r.first_seq() + r.tasks_size();
+    int got = r.tasks_size(), messages = 1;
+    for (int i = 0; i < r.tasks_size(); ++i) EXPECT_EQ(r.tasks(i).task_id(), std::to_string(i));
+    while (got < kResults) {
+        ASSERT_TRUE(reader->Read(&r));
+        ++messages;
+        EXPECT_EQ(r.first_seq(), next);
+        EXPECT_FALSE(r.gap());
+        for (int i = 0; i < r.tasks_size(); ++i)
+            EXPECT_EQ(r.tasks(i).task_id(), std::to_string(got + i));
+        got += r.tasks_size();
+        next += r.tasks_size();
+    }
+    EXPECT_EQ(got, kResults);
+    EXPECT_LT(messages, kResults);
+
+    ctx.TryCancel();
+    while (reader->Read(&r)) {}
+    reader->Finish();
+    for (int i = 0; i < 200 && server_->SubscriberCount() != base; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(server_->SubscriberCount(), base);
+}
+
+// 断线重连：带上游标只补发其后的结果；游标滚出回放环时标 gap
+TEST(AsyncServerReplayTest, ResumeFromCursor) {
+    AsyncServer server;
+    server.SetResultReplay(8, 16);
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto publish = [&](int from, int to) {
+        Task t;
+        t.set_client_id("resumer");
+        for (int i = from; i < to; ++i) {
+            t.set_task_id(std::to_string(i));
+            server.PublishResult(t);
+        }
+    };
+    // 订阅并读到 want 条结果为止，返回 (首条消息, 收到的 task_id)
+    auto listen = [&](std::uint64_t resume_after, int want) {
+        grpc::ClientContext ctx;
+        SubscribeRequest sub;
+        sub.set_client_id("resumer");
+        sub.set_resume_after(resume_after);
+        auto reader = stub->ListenResults(&ctx, sub);
+        TaskResult first, r;
+        std::vector<std::string> ids;
+        EXPECT_TRUE(reader->Read(&first));
+        for (auto& t : first.tasks()) ids.push_back(t.task_id());
+        while (static_cast<int>(ids.size()) < want && reader->Read(&r))
+            for (auto& t : r.tasks()) ids.push_back(t.task_id());
+        ctx.TryCancel();
+        while (reader->Read(&r)) {}
+        reader->Finish();
+        return std::make_pair(first, ids);
+    };
+
+    publish(0, 5);                                  // 序号 1..5，还没人订阅
+    auto [head, ids] = listen(0, 0);                // 不续传：只拿游标
+    EXPECT_EQ(head.first_seq(), 6u);
+    EXPECT_TRUE(ids.empty());
+
+    std::tie(head, ids) = listen(2, 3);             // 续传 3..5
+    EXPECT_EQ(head.first_seq(), 3u);
+    EXPECT_FALSE(head.gap());
+    EXPECT_EQ(ids, (std::vector<std::string>{"2", "3", "4"}));
+
+    publish(5, 20);                                 // 环里只剩 13..20
+    std::tie(head, ids) = listen(5, 8);
+    EXPECT_TRUE(head.gap());
+    EXPECT_EQ(head.first_seq(), 13u);
+    ASSERT_EQ(ids.size(), 8u);
+    EXPECT_EQ(ids.front(), "12");
+    EXPECT_EQ(ids.back(), "19");
+    server.Shutdown();
+}
+
+// client_id 数到上限时淘汰最久没有活动的无人订阅日志；有订阅的不参与淘汰
+TEST(AsyncServerReplayTest, EvictsLeastRecentlyUsedIdleLog) {
+    AsyncServer server;
+    server.SetResultReplay(8, 2);
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto publish = [&](const std::string& client, int n) {
+        Task t;
+        t.set_client_id(client);
+        std::size_t pushed = 0;
+        for (int i = 0; i < n; ++i) pushed = server.PublishResult(t);
+        return pushed;
+    };
+    // 只取首条消息里的游标：日志被淘汰过的从 1 重新编号
+    auto next_seq = [&](const std::string& client) {
+        grpc::ClientContext ctx;
+        SubscribeRequest sub;
+        sub.set_client_id(client);
+        auto reader = stub->ListenResults(&ctx, sub);
+        TaskResult first, r;
+        EXPECT_TRUE(reader->Read(&first));
+        ctx.TryCancel();
+        while (reader->Read(&r)) {}
+        reader->Finish();
+        return first.first_seq();
+    };
+
+    publish("a", 3);
+    publish("b", 3);
+    publish("a", 1);                                // a 比 b 新
+    publish("c", 1);                                // 淘汰 b
+    EXPECT_EQ(next_seq("a"), 5u);
+    EXPECT_EQ(next_seq("b"), 1u);                   // b 重建，淘汰此时最旧的 c
+    EXPECT_EQ(next_seq("a"), 5u);
+
+    // a 有订阅时一直留着，淘汰只在其余无人订阅的日志里挑
+    grpc::ClientContext ctx;
+    SubscribeRequest sub;
+    sub.set_client_id("a");
+    auto reader = stub->ListenResults(&ctx, sub);
+    TaskResult first;
+    ASSERT_TRUE(reader->Read(&first));
+    for (const char* other : {"d", "e", "f"}) publish(other, 1);
+    EXPECT_EQ(publish("a", 1), 1u);
+    TaskResult r;
+    ASSERT_TRUE(reader->Read(&r));
+    EXPECT_EQ(r.first_seq(), 5u);
+    ctx.TryCancel();
+    while (reader->Read(&r)) {}
+    reader->Finish();
+    server.Shutdown();
+}
+
+/* ---------- 批量提交流 ---------- */
+TEST_F(AsyncServerTest, SubmitTasksAcksInOrder) {
+    grpc::ClientContext ctx;
+    auto stream = stub_->SubmitTasks(&ctx);
+    constexpr int kBatches = 5, kPerBatch = 100;
+    for (int b = 0; b < kBatches; ++b) {
+        TaskBatch batch;
+        batch.set_batch_id(b);
+        for (int i = 0; i < kPerBatch; ++i) {
+            batch.add_tasks()->set_task_id(std::to_string(b * kPerBatch + i));
+        }
+        ASSERT_TRUE(stream->Write(batch));
+    }
+    stream->WritesDone();
+
+    BatchAck ack;
+    int next = 0;
+    for (int b = 0; b < kBatches; ++b) {
+        ASSERT_TRUE(stream->Read(&ack));
+        EXPECT_EQ(ack.batch_id(), static_cast<uint64_t>(b));
+        ASSERT_EQ(ack.acks_size(), kPerBatch);
+        for (const auto& a : ack.acks()) {
+            EXPECT_EQ(a.task_id(), std::to_string(next++));
+            EXPECT_EQ(a.state(), dts::proto::SUCCESS);
+        }
+    }
+    EXPECT_FALSE(stream->Read(&ack));
+    EXPECT_TRUE(stream->Finish().ok());
+}
+
+// 单连接吞吐对比：逐个 SubmitTask vs SubmitTasks 流（每批 256）
+TEST_F(AsyncServerTest, SubmitTasksThroughput) {
+    constexpr int kTasks = 20'000;
+    constexpr int kUnary = 2'000;             // 一元调用太慢，少跑一些再折算
+    constexpr int kPerBatch = 256;
+    using Clock = std::chrono::steady_clock;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < kUnary; ++i) {
+        Task req;
+        req.set_task_id(std::to_string(i));
+        req.set_func_name("noop");
+        TaskResponse resp;
+        grpc::ClientContext ctx;
+        ASSERT_TRUE(stub_->SubmitTask(&ctx, req, &resp).ok());
+    }
+    double unary_qps = kUnary / std::chrono::duration<double>(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    grpc::ClientContext ctx;
+    auto stream = stub_->SubmitTasks(&ctx);
+    std::thread writer([&] {
+        TaskBatch batch;
+        for (int i = 0; i < kTasks; i += kPerBatch) {
+            batch.Clear();
+            batch.set_batch_id(i / kPerBatch);
+            for (int j = i; j < std::min(kTasks, i + kPerBatch); ++j) {
+                auto* t = batch.add_tasks();
+                t->set_task_id(std::to_string(j));
+                t->set_func_name("noop");
+            }
+            if (!stream->Write(batch)) break;
+        }
+        stream->WritesDone();
+    });
+    BatchAck ack;
+    int acked = 0;
+    while (stream->Read(&ack)) acked += ack.acks_size();
+    writer.join();
+    ASSERT_TRUE(stream->Finish().ok());
+    double batch_qps = acked / std::chrono::duration<double>(Clock::now() - t0).count();
+
+    EXPECT_EQ(acked, kTasks);
+    std::cout << "[Throughput] unary=" << static_cast<long>(unary_qps)
+              << " task/s, batch=" << static_cast<long>(batch_qps)
+              << " task/s, x" << batch_qps / unary_qps << std::endl;
+    EXPECT_GT(batch_qps, unary_qps);
+}
+
+/* ---------- 业务回调卸载 ---------- */
+// 慢查询在池线程上跑：同时处理数被上下文数封顶，且不拖慢同一服务器上的提交
+TEST(AsyncServerOffloadTest, SlowHandlersBoundedAndIsolated) {
+    constexpr std::size_t kMaxInflight = 2;
+    std::atomic<int> running{0}, peak{0};
+
+    AsyncServer server;
+    server.EnableHandlerOffload(4, kMaxInflight);
+    server.SetQueryStatusHandler([&](const QueryRequest& req, Task* out) {
+        int now = ++running;
+        for (int p = peak.load(); now > p && !peak.compare_exchange_weak(p, now);) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        --running;
+        out->set_task_id(req.task_id());
+        return grpc::Status::OK;
+    });
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+
+    std::vector<std::thread> slow;
+    std::atomic<int> slow_ok{0};
+    for (int i = 0; i < 6; ++i) {
+        slow.emplace_back([&, i] {
+            QueryRequest req;
+            req.set_task_id("slow-" + std::to_string(i));
+            Task resp;
+            grpc::ClientContext ctx;
+            if (stub->QueryStatus(&ctx, req, &resp).ok()) ++slow_ok;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_GT(server.HandlersInflight(), 0u);
+
+    // 慢查询占满时，提交照常快速返回
+    auto worst = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < 20; ++i) {
+        Task req;
+        req.set_task_id(std::to_string(i));
+        TaskResponse resp;
+        grpc::ClientContext ctx;
+        auto t0 = std::chrono::steady_clock::now();
+        ASSERT_TRUE(stub->SubmitTask(&ctx, req, &resp).ok());
+        worst = std::max(worst, std::chrono::steady_clock::now() - t0);
+    }
+    EXPECT_LT(worst, std::chrono::milliseconds(50));   // 远小于一次慢查询的 100 ms
+
+    for (auto& th : slow) th.join();
+    EXPECT_EQ(slow_ok.load(), 6);
+    EXPECT_LE(peak.load(), static_cast<int>(kMaxInflight));
+    server.Shutdown();
+    EXPECT_EQ(server.HandlersInflight(), 0u);
+}
+
+/* ---------- 自适应预挂 ---------- */
+// 每种 RPC 每个 CQ 只预挂 1 个上下文：并发突发会把池挂空，控制器据此扩容，请求全部成功
+TEST(AsyncServerAdaptiveTest, BurstGrowsArmedContexts) {
+    AsyncServer server;
+    AdaptiveLimits limits;
+    limits.min_contexts = 1;
+    limits.max_contexts = 32;
+    limits.tick = std::chrono::milliseconds(20);
+    server.SetAdaptiveLimits(limits);
+    server.SetSubmitTaskHandler([](Task* req, TaskResponse* resp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        resp->mutable_task()->set_task_id(req->task_id());
+        resp->mutable_task()->set_state(dts::proto::SUCCESS);
+    });
+    ::setenv("DTS_INITIAL_CONTEXT", "1", 1);
+    server.Run(0);
+    ::unsetenv("DTS_INITIAL_CONTEXT");
+    const int initial = server.Metrics().target;
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+
+    constexpr int kThreads = 16, kPerThread = 50;
+    std::atomic<int> ok{0};
+    std::vector<std::thread> ths;
+    for (int t = 0; t < kThreads; ++t) {
+        ths.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                Task req;
+                req.set_task_id(std::to_string(t) + "-" + std::to_string(i));
+                TaskResponse resp;
+                grpc::ClientContext ctx;
+                if (stub->SubmitTask(&ctx, req, &resp).ok() &&
+                    resp.task().task_id() == req.task_id()) ++ok;
+            }
+        });
+    }
+    for (auto& th : ths) th.join();
+    EXPECT_EQ(ok.load(), kThreads * kPerThread);
+
+    auto m = server.Metrics();
+    std::uint64_t starved = 0;
+    int threads = 0;
+    for (auto& cq : m.cqs) {
+        starved += cq.starved;
+        threads += cq.threads;
+        EXPECT_GE(cq.threads, limits.min_threads_per_cq);
+        EXPECT_LE(cq.threads, limits.max_threads_per_cq);
+    }
+    EXPECT_GT(starved, 0u);
+    EXPECT_GT(m.target, initial);
+    EXPECT_EQ(m.threads, threads);
+    server.Shutdown();
+}
+
+// 上下文只随目标增减：突发时上调并补足差额，不多建；回落后多出来的随调用结束退役，
+// 目标不变的阶段不再构造新上下文，现存数始终收敛到目标
+TEST(AsyncServerAdaptiveTest, ContextsFollowTargetOnly) {
+    AsyncServer server;
+    AdaptiveLimits limits;
+    limits.min_contexts = 1;
+    limits.max_contexts = 32;
+    limits.tick = std::chrono::milliseconds(20);
+    limits.shrink_after_ticks = 3;
+    server.SetAdaptiveLimits(limits);
+    server.SetSubmitTaskHandler([](Task* req, TaskResponse* resp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        resp->mutable_task()->set_task_id(req->task_id());
+        resp->mutable_task()->set_state(dts::proto::SUCCESS);
+    });
+    ::setenv("DTS_INITIAL_CONTEXT", "1", 1);
+    server.Run(0);
+    ::unsetenv("DTS_INITIAL_CONTEXT");
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto call = [&](const std::string& id) {
+        Task req;
+        req.set_task_id(id);
+        TaskResponse resp;
+        grpc::ClientContext ctx;
+        return stub->SubmitTask(&ctx, req, &resp).ok();
+    };
+    // 等在途调用收尾：现存数与目标一致（每个 CQ 分别比较）。上下文只在调用结束时退役，
+    // 给了 since 时跳过此后没接过调用的 CQ，它们只要求不低于目标
+    auto converged = [&](const ServerMetrics* since) {
+        for (int i = 0; i < 100; ++i) {
+            auto m = server.Metrics();
+            bool all = true;
+            for (std::size_t k = 0; k < m.cqs.size(); ++k) {
+                const auto& c = m.cqs[k];
+                const bool idle = since && c.accepted == since->cqs[k].accepted;
+                all = all && (idle ? c.live >= c.target : c.live == c.target);
+            }
+            if (all) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    };
+
+    // 1. 突发：饥饿触发上调，补出来的正好是差额
+    const auto before = SubmitTaskCall::Stats();
+    const int initial = server.Metrics().target;
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 16; ++t) {
+        ths.emplace_back([&, t] {
+            for (int i = 0; i < 50; ++i) EXPECT_TRUE(call(std::to_string(t) + "-" + std::to_string(i)));
+        });
+    }
+    for (auto& th : ths) th.join();
+    ASSERT_TRUE(converged(nullptr));
+    const auto burst = server.Metrics();
+    EXPECT_GT(burst.target, initial);
+    EXPECT_EQ(burst.live, burst.target);
+    EXPECT_GE(SubmitTaskCall::Stats().allocated - before.allocated,
+              static_cast<std::size_t>(burst.target - initial));
+
+    // 2. 慢速串行：连续安静后下调，多出来的只退役不新建
+    const auto grown = SubmitTaskCall::Stats();
+    for (int i = 0; i < 80; ++i) {
+        EXPECT_TRUE(call("trickle-" + std::to_string(i)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(converged(&burst));
+    const auto quiet = server.Metrics();
+    EXPECT_LT(quiet.target, burst.target);
+    EXPECT_LT(quiet.live, burst.live);
+    EXPECT_EQ(SubmitTaskCall::Stats().allocated, grown.allocated);
+    server.Shutdown();
+}
+
+/* ---------- QueryStatus 合并与缓存 ---------- */
+// 同一 task_id 的并发未命中只打一次后端；之后命中缓存，失效或过期后重新加载
+TEST(StatusCacheTest, CoalescesConcurrentMisses) {
+    StatusCacheOptions opts;
+    opts.ttl = std::chrono::milliseconds(100);
+    StatusCache cache(opts);
+    std::atomic<int> calls{0};
+    auto loader = [&](Task* out) {
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        out->set_task_id("hot");
+        out->set_state(dts::proto::RUNNING);
+        return grpc::Status::OK;
+    };
+
+    constexpr int kThreads = 16;
+    std::atomic<int> ok{0};
+    std::vector<std::thread> ths;
+    for (int i = 0; i < kThreads; ++i) {
+        ths.emplace_back([&] {
+            Task t;
+            if (cache.Get("hot", &t, loader).ok() && t.state() == dts::proto::RUNNING) ++ok;
+        });
+    }
+    for (auto& th : ths) th.join();
+    EXPECT_EQ(ok.load(), kThreads);
+    EXPECT_EQ(calls.load(), 1);
+    auto st = cache.stats();
+    EXPECT_EQ(st.loads, 1u);
+    EXPECT_EQ(st.hits + st.coalesced, static_cast<std::uint64_t>(kThreads - 1));
+
+    Task t;
+    ASSERT_TRUE(cache.Get("hot", &t, loader).ok());
+    EXPECT_EQ(calls.load(), 1);                     // TTL 内命中
+    cache.Invalidate("hot");
+    ASSERT_TRUE(cache.Get("hot", &t, loader).ok());
+    EXPECT_EQ(calls.load(), 2);                     // 失效后重新加载
+    std::this_thread::sleep_for(opts.ttl + std::chrono::milliseconds(20));
+    ASSERT_TRUE(cache.Get("hot", &t, loader).ok());
+    EXPECT_EQ(calls.load(), 3);                     // 过期后重新加载
+
+    // 错误不缓存
+    auto missing = [&](Task*) { ++calls; return grpc::Status(grpc::StatusCode::NOT_FOUND, "x"); };
+    EXPECT_EQ(cache.Get("gone", &t, missing).error_code(), grpc::StatusCode::NOT_FOUND);
+    EXPECT_EQ(cache.Get("gone", &t, missing).error_code(), grpc::StatusCode::NOT_FOUND);
+    EXPECT_EQ(calls.load(), 5);
+}
+
+// 合并的请求不阻塞调用线程：回调由加载方线程在取回后调用；loader 抛任何异常都按 INTERNAL
+// 交给所有等待方，条目随之清掉，下一次重新加载
+TEST(StatusCacheTest, CoalescedWaitersDoNotBlock) {
+    StatusCache cache;
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::promise<void> loading;
+    std::atomic<int> calls{0};
+    auto slow = [&](Task* out) {
+        ++calls;
+        loading.set_value();
+        gate.wait();
+        out->set_state(dts::proto::RUNNING);
+        return grpc::Status::OK;
+    };
+    std::thread loader([&] {
+        Task t;
+        EXPECT_TRUE(cache.Get("k", &t, slow).ok());
+    });
+    loading.get_future().wait();
+
+    std::atomic<int> done{0};
+    std::thread::id done_on;
+    cache.Get("k", slow, [&](const grpc::Status& st, const Task& t) {
+        EXPECT_TRUE(st.ok());
+        EXPECT_EQ(t.state(), dts::proto::RUNNING);
+        done_on = std::this_thread::get_id();
+        ++done;
+    });
+    EXPECT_EQ(done.load(), 0);                      // 已返回，结果还没到
+    release.set_value();
+    loader.join();
+    EXPECT_EQ(done.load(), 1);
+    EXPECT_NE(done_on, std::this_thread::get_id());
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_EQ(cache.stats().coalesced, 1u);
+
+    auto throws = [&](Task*) -> grpc::Status { ++calls; throw 42; };
+    Task t;
+    EXPECT_EQ(cache.Get("bad", &t, throws).error_code(), grpc::StatusCode::INTERNAL);
+    EXPECT_EQ(cache.Get("bad", &t, throws).error_code(), grpc::StatusCode::INTERNAL);
+    EXPECT_EQ(calls.load(), 3);
+}
+
+// 端到端：轮询风暴只打一次后端，PublishResult 推送状态迁移后下一次查询拿到新状态
+TEST(AsyncServerStatusCacheTest, PollingStormHitsBackendOnce) {
+    std::atomic<int> backend{0};
+    std::atomic<int> state{dts::proto::RUNNING};
+    AsyncServer server;
+    server.EnableHandlerOffload(16, 32);            // 保证查询真正并发
+    server.EnableStatusCache({std::chrono::seconds(10), 8, 1024});
+    server.SetQueryStatusHandler([&](const QueryRequest& req, Task* out) {
+        ++backend;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        out->set_task_id(req.task_id());
+        out->set_state(static_cast<dts::proto::TaskState>(state.load()));
+        return grpc::Status::OK;
+    });
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto query = [&] {
+        QueryRequest req;
+        req.set_task_id("polled");
+        Task resp;
+        grpc::ClientContext ctx;
+        EXPECT_TRUE(stub->QueryStatus(&ctx, req, &resp).ok());
+        return resp.state();
+    };
+
+    std::vector<std::thread> ths;
+    for (int i = 0; i < 16; ++i) {
+        ths.emplace_back([&] {
+            for (int k = 0; k < 10; ++k) EXPECT_EQ(query(), dts::proto::RUNNING);
+        });
+    }
+    for (auto& th : ths) th.join();
+    EXPECT_EQ(backend.load(), 1);
+
+    state = dts::proto::SUCCESS;
+    Task done;
+    done.set_task_id("polled");
+    done.set_state(dts::proto::SUCCESS);
+    server.PublishResult(done);
+    EXPECT_EQ(query(), dts::proto::SUCCESS);
+    EXPECT_EQ(backend.load(), 2);
+    EXPECT_GE(server.StatusCacheStats().hits, 1u);
+    server.Shutdown();
+}
+
+// 同一个 idempotency_key 重发：业务回调只跑一次，重复请求拿到第一次的回包
+TEST(AsyncServerIdempotencyTest, DuplicateSubmitRunsOnce) {
+    std::atomic<int> handled{0};
+    AsyncServer server;
+    server.SetSubmitTaskHandler([&](Task* req, TaskResponse* resp) {
+        resp->mutable_task()->CopyFrom(*req);
+        resp->mutable_task()->set_state(dts::proto::SUCCESS);
+        resp->mutable_task()->set_error_msg("run-" + std::to_string(++handled));
+    });
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto submit = [&](const std::string& key) {
+        Task req;
+        req.set_task_id("idem");
+        req.set_idempotency_key(key);
+        TaskResponse resp;
+        grpc::ClientContext ctx;
+        EXPECT_TRUE(stub->SubmitTask(&ctx, req, &resp).ok());
+        return resp.task().error_msg();   // 借 error_msg 标记是第几次执行
+    };
+
+    EXPECT_EQ(submit("k1"), "run-1");
+    EXPECT_EQ(submit("k1"), "run-1");
+    EXPECT_EQ(submit("k2"), "run-2");
+    EXPECT_EQ(submit(""), "run-3");           // 不带 key 不去重
+    EXPECT_EQ(submit(""), "run-4");
+    EXPECT_EQ(handled.load(), 4);
+    server.Shutdown();
+}
+
+// 第一次还在执行时到达的重复请求不占执行器线程：2 个线程被慢请求和 4 个重复请求压着，
+// 别的提交照样完成。第一次失败时 key 不留存：等着的重复请求回 ABORTED，重发会重新执行
+TEST(AsyncServerIdempotencyTest, DuplicatesWaitWithoutBlocking) {
+    std::atomic<int> handled{0};
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    AsyncServer server;
+    server.EnableHandlerOffload(2, 16);
+    server.SetSubmitTaskHandler([&](Task* req, TaskResponse* resp) {
+        const int run = ++handled;
+        if (req->task_id() == "slow" || req->task_id() == "slow-boom") gate.wait();
+        if (req->task_id().ends_with("boom") && run <= 2) throw std::runtime_error("backend down");
+        resp->mutable_task()->set_task_id(req->task_id());
+        resp->mutable_task()->set_error_msg("run-" + std::to_string(run));
+    });
+    server.Run(0);
+    auto stub = TaskService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(server.ListenPort()), grpc::InsecureChannelCredentials()));
+    auto submit = [&](const std::string& id, const std::string& key, TaskResponse* resp) {
+        Task req;
+        req.set_task_id(id);
+        req.set_idempotency_key(key);
+        grpc::ClientContext ctx;
+        ctx.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+        return stub->SubmitTask(&ctx, req, resp);
+    };
+
+    std::vector<std::thread> ths;
+    std::vector<TaskResponse> resps(5);
+    std::vector<grpc::Status> sts(5);
+    for (int i = 0; i < 5; ++i) {
+        ths.emplace_back([&, i] { sts[i] = submit("slow", "k-slow", &resps[i]); });
+        if (i == 0) {
+            while (handled.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TaskResponse other;
+    EXPECT_TRUE(submit("other", "k-other", &other).ok());     // 执行器另一个线程没被重复请求占住
+    EXPECT_EQ(handled.load(), 2);
+    release.set_value();
+    for (auto& th : ths) th.join();
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(sts[i].ok()) << sts[i].error_message();
+        EXPECT_EQ(resps[i].task().error_msg(), "run-1");
+    }
+
+    // 执行中失败：自己回 INTERNAL，等着的重复请求回 ABORTED；key 不被占着，重发成功
+    std::promise<void> release2;
+    gate = release2.get_future().share();
+    handled = 0;
+    TaskResponse r1, r2;
+    grpc::Status s1;
+    std::thread first([&] { s1 = submit("slow-boom", "k-boom", &r1); });
+    while (handled.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::thread dup([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));   // 重复请求先到、挂上
+        release2.set_value();
+    });
+    grpc::Status s2 = submit("slow-boom", "k-boom", &r2);
+    first.join();
+    dup.join();
+    EXPECT_EQ(s1.error_code(), grpc::StatusCode::INTERNAL);
+    EXPECT_EQ(s2.error_code(), grpc::StatusCode::ABORTED);
+    EXPECT_EQ(handled.load(), 1);
+    handled = 2;                                  // 之后的执行不再抛
+    EXPECT_TRUE(submit("again-boom", "k-boom", &r2).ok());
+    EXPECT_EQ(r2.task().error_msg(), "run-3");
+    server.Shutdown();
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     dts::InitGlog(argv[0], true /* =unit-test */); // 只打 ERROR 到 stderr
@@ -0,0 +1,594 @@
+#include "grpc_client.hpp"
+#include "callback_client.hpp"
+#include <gtest/gtest.h>
+#include <grpcpp/grpcpp.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <map>
+#include <set>
+
+using namespace dts;
+
+namespace {
+
+// 最小回显服务：记录每个调用的对端地址，用来数客户端实际建了几条连接
+class EchoService final : public TaskService::Service {
+public:
+    grpc::Status SubmitTask(grpc::ServerContext* ctx, const PbTask* req,
+                            TaskResponse* resp) override {
+        if (submit_delay_ms > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(submit_delay_ms.load()));
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            peers_.insert(ctx->peer());
+            // flaky：每个 key 的第一次回 UNAVAILABLE，之后照常执行
+            if (flaky && attempts_[req->idempotency_key()]++ == 0)
+                return grpc::Status(grpc::StatusCode::UNAVAILABLE, "injected");
+            ++executed_[req->idempotency_key()];
+        }
+        *resp->mutable_task() = *req;
+        resp->mutable_task()->set_state(dts::proto::SUCCESS);
+        return grpc::Status::OK;
+    }
+
+    grpc::Status QueryStatus(grpc::ServerContext*, const QueryRequest* req, PbTask* resp) override {
+        const int n = queries_.fetch_add(1);
+        if (req->task_id().empty()) return grpc::Status(grpc::StatusCode::NOT_FOUND, "empty id");
+        // 每 slow_every 次查询有一次卡住 300ms，模拟长尾
+        if (slow_every > 0 && n % slow_every == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        resp->set_task_id(req->task_id());
+        resp->set_state(dts::proto::RUNNING);
+        return grpc::Status::OK;
+    }
+
+    grpc::Status CancelTask(grpc::ServerContext*, const CancelRequest* req,
+                            CancelResponse* resp) override {
+        resp->set_success(req->task_id() == "cancel-me");
+        return grpc::Status::OK;
+    }
+
+    // 默认不发任何结果，直到客户端取消。
+    // listen_total > 0 时按游标发结果 1..listen_total，每条流只发 listen_per_stream 条就以 UNAVAILABLE 断开
+    grpc::Status ListenResults(grpc::ServerContext* ctx, const SubscribeRequest* req,
+                               grpc::ServerWriter<TaskResult>* writer) override {
+        ++listens;
+        if (listen_total > 0) {
+            std::uint64_t seq = req->resume_after() + 1;
+            TaskResult msg;
+            msg.set_first_seq(seq);
+            for (int i = 0; i < listen_per_stream && seq <= static_cast<std::uint64_t>(listen_total); ++i)
+                msg.add_tasks()->set_task_id(std::to_string(seq++));
+            writer->Write(msg);
+            if (seq <= static_cast<std::uint64_t>(listen_total))
+                return grpc::Status(grpc::StatusCode::UNAVAILABLE, "injected drop");
+        }
+        while (!ctx->IsCancelled()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return grpc::Status::CANCELLED;
+    }
+
+    // 批量提交：逐批回 ack；id 以 "bad" 开头的单条失败。batch_abort_after > 0 时收满这么多批就以
+    // RESOURCE_EXHAUSTED 断流
+    grpc::Status SubmitTasks(grpc::ServerContext*,
+                             grpc::ServerReaderWriter<BatchAck, TaskBatch>* stream) override {
+        TaskBatch in;
+        int batches = 0;
+        while (stream->Read(&in)) {
+            ++batches_seen;
+            if (batch_abort_after > 0 && batches++ >= batch_abort_after)
+                return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "injected overload");
+            BatchAck ack;
+            ack.set_batch_id(in.batch_id());
+            for (const auto& t : in.tasks()) {
+                auto* a = ack.add_acks();
+                a->set_task_id(t.task_id());
+                if (t.task_id().rfind("bad", 0) == 0) {
+                    a->set_state(dts::proto::FAILED);
+                    a->set_error_msg("rejected " + t.task_id());
+                } else {
+                    a->set_state(dts::proto::PENDING);
+                }
+            }
+            stream->Write(ack);
+        }
+        return grpc::Status::OK;
+    }
+
+    std::size_t DistinctPeers() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return peers_.size();
+    }
+    int Queries() const { return queries_.load(); }
+    std::map<std::string, int> Executed() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return executed_;
+    }
+
+    std::atomic<bool> flaky{false};
+    std::atomic<int> slow_every{0};
+    std::atomic<int> submit_delay_ms{0};
+    std::atomic<int> listen_total{0};
+    std::atomic<int> listen_per_stream{0};
+    std::atomic<int> listens{0};
+    std::atomic<int> batch_abort_after{0};
+    std::atomic<int> batches_seen{0};
+
+private:
+    std::mutex mu_;
+    std::set<std::string> peers_;
+    std::map<std::string, int> attempts_, executed_;
+    std::atomic<int> queries_{0};
+};
+
+class GrpcClientPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port_);
+        builder.RegisterService(&service_);
+        server_ = builder.BuildAndStart();
+        ASSERT_NE(port_, 0);
+    }
+    void TearDown() override { server_->Shutdown(); }
+
+    std::string Target() const { return "127.0.0.1:" + std::to_string(port_); }
+
+    // 固定并发窗口下压 total 个异步提交，返回 rpc/s
+    static double Pump(GrpcClient& client, int total, int window) {
+        std::deque<std::future<Task>> inflight;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < total; ++i) {
+            if (static_cast<int>(inflight.size()) >= window) {
+                inflight.front().get();
+                inflight.pop_front();
+            }
+            Task t;
+            t.task_id = std::to_string(i);
+            inflight.push_back(client.submit_task_async(std::move(t)));
+        }
+        while (!inflight.empty()) {
+            EXPECT_EQ(inflight.front().get().state, TaskState::SUCCESS);
+            inflight.pop_front();
+        }
+        return total / std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    EchoService service_;
+    std::unique_ptr<grpc::Server> server_;
+    int port_ = 0;
+};
+
+} // namespace
+
+// 每个通道是一条独立连接，调用按负载分摊，结束后在途计数全部归零
+TEST_F(GrpcClientPoolTest, ChannelsAreSeparateConnections) {
+    ClientOptions opts;
+    opts.channels = 4;
+    opts.cq_threads = 2;
+    opts.keepalive_time_ms = 10'000;
+    opts.stream_window_bytes = 1 << 20;
+    GrpcClient client(Target(), opts);
+    ASSERT_EQ(client.channel_count(), 4u);
+
+    Pump(client, 2'000, 64);
+    EXPECT_EQ(service_.DistinctPeers(), 4u);
+    // 计数在 tag 析构时归还，略晚于 future 就绪
+    auto idle = [&] {
+        for (int i = 0; i < 100; ++i) {
+            auto v = client.channel_load();
+            if (std::all_of(v.begin(), v.end(), [](int n) { return n == 0; })) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    };
+    EXPECT_TRUE(idle());
+
+    Task t;
+    t.task_id = "sync";
+    EXPECT_EQ(client.submit_task_sync(std::move(t)).task_id, "sync");
+    EXPECT_TRUE(idle());
+}
+
+// 回环压测：单连接单 CQ 线程 vs 默认连接池（按核数），打印吞吐对比。
+// 两万次调用下连接数始终等于通道数：连接跨调用复用，池不随调用增长
+TEST_F(GrpcClientPoolTest, LoopbackThroughput) {
+    constexpr int kTotal = 20'000, kWindow = 256;
+
+    ClientOptions single;
+    single.channels = 1;
+    single.cq_threads = 1;
+    double base = 0, pooled = 0;
+    std::size_t channels = 0;
+    {
+        GrpcClient client(Target(), single);
+        base = Pump(client, kTotal, kWindow);
+    }
+    EXPECT_EQ(service_.DistinctPeers(), 1u);
+    {
+        GrpcClient client(Target());
+        channels = client.channel_count();
+        EXPECT_EQ(channels, std::max(1u, std::thread::hardware_concurrency()));
+        pooled = Pump(client, kTotal, kWindow);
+    }
+    EXPECT_EQ(service_.DistinctPeers(), 1 + channels);
+    std::cout << "[ClientPool] cores=" << std::thread::hardware_concurrency()
+              << " single=" << static_cast<long>(base) << " rpc/s"
+              << " pooled=" << static_cast<long>(pooled) << " rpc/s"
+              << " x" << pooled / base << std::endl;
+    // 单核机器上两者持平；池化不该让吞吐明显倒退
+    EXPECT_GT(pooled, base / 2);
+}
+
+// 批量提交：ack 按提交顺序一一对应，单条失败带错误信息；future 只完成一次，完成后流即释放
+TEST_F(GrpcClientPoolTest, SubmitBatchAsync) {
+    ClientOptions opts;
+    opts.channels = 2;
+    opts.cq_threads = 1;
+    GrpcClient client(Target(), opts);
+
+    std::vector<Task> tasks(1000);
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+        tasks[i].task_id = (i % 7 == 3 ? "bad-" : "ok-") + std::to_string(i);
+    auto fut = client.submit_batch_async(tasks, 64);
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    auto acks = fut.get();
+    ASSERT_EQ(acks.size(), tasks.size());
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < acks.size(); ++i) {
+        EXPECT_EQ(acks[i].task_id, tasks[i].task_id);
+        if (i % 7 == 3) {
+            ++failed;
+            EXPECT_EQ(acks[i].state, TaskState::FAILED);
+            EXPECT_EQ(acks[i].error_msg, "rejected " + tasks[i].task_id);
+        } else {
+            EXPECT_EQ(acks[i].state, TaskState::PENDING);
+            EXPECT_TRUE(acks[i].error_msg.empty());
+        }
+    }
+    EXPECT_EQ(failed, 143u);
+    EXPECT_EQ(service_.batches_seen.load(), 16);    // ceil(1000 / 64)
+
+    // 空批：不发任何 TaskBatch，直接以空 ack 完成
+    auto none = client.submit_batch_async({});
+    ASSERT_EQ(none.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(none.get().empty());
+
+    // 完成后 tag 已归还通道计数：没有第二次完成在路上
+    for (int i = 0; i < 100; ++i) {
+        auto v = client.channel_load();
+        if (std::all_of(v.begin(), v.end(), [](int n) { return n == 0; })) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto load = client.channel_load();
+    EXPECT_TRUE(std::all_of(load.begin(), load.end(), [](int n) { return n == 0; }));
+}
+
+// 中途断流：future 以服务端的状态失败一次，而不是被改写成缺 ack
+TEST_F(GrpcClientPoolTest, SubmitBatchAsyncStreamError) {
+    service_.batch_abort_after = 2;
+    GrpcClient client(Target());
+    std::vector<Task> tasks(500);
+    for (std::size_t i = 0; i < tasks.size(); ++i) tasks[i].task_id = std::to_string(i);
+    auto fut = client.submit_batch_async(std::move(tasks), 50);
+    ASSERT_EQ(fut.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    try {
+        fut.get();
+        FAIL() << "expected GrpcError";
+    } catch (const GrpcError& e) {
+        EXPECT_EQ(e.code(), grpc::StatusCode::RESOURCE_EXHAUSTED);
+    }
+}
+
+// 慢回调跑在回调线程上：同一 CQ 线程上的其它调用照常完成
+TEST_F(GrpcClientPoolTest, SlowCallbackDoesNotStallCompletions) {
+    ClientOptions opts;
+    opts.channels = 1;
+    opts.cq_threads = 1;
+    GrpcClient client(Target(), opts);
+
+    std::promise<std::thread::id> cb_thread;
+    Task slow;
+    slow.task_id = "slow";
+    client.submit_task_async(std::move(slow), [&](const Task&, grpc::Status) {
+        cb_thread.set_value(std::this_thread::get_id());
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }).get();
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        Task t;
+        t.task_id = std::to_string(i);
+        EXPECT_EQ(client.submit_task_async(std::move(t)).get().task_id, std::to_string(i));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(250));
+    EXPECT_NE(cb_thread.get_future().get(), std::this_thread::get_id());
+}
+
+// 析构时取消还开着的监听流：不挂住，最终状态按序交给回调
+TEST_F(GrpcClientPoolTest, DestructorCancelsOpenStreams) {
+    std::atomic<int> final_calls{0};
+    grpc::StatusCode code = grpc::StatusCode::OK;
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        GrpcClient client(Target());
+        client.listen_results("c1", [&](const Task&, grpc::Status st) {
+            code = st.error_code();
+            ++final_calls;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::seconds(1));
+    EXPECT_EQ(final_calls.load(), 1);
+    EXPECT_EQ(code, grpc::StatusCode::CANCELLED);
+}
+
+// 可重试错误按退避重发，同一任务的各次尝试带同一个 idempotency_key
+TEST_F(GrpcClientPoolTest, RetriesCarryIdempotencyKey) {
+    service_.flaky = true;
+    ClientOptions opts;
+    opts.retry.initial_backoff = std::chrono::milliseconds(5);
+    GrpcClient client(Target(), opts);
+
+    for (int i = 0; i < 10; ++i) {
+        Task t;
+        t.task_id = "r" + std::to_string(i);
+        EXPECT_EQ(client.submit_task_async(std::move(t)).get().task_id, "r" + std::to_string(i));
+    }
+    Task s;
+    s.task_id = "sync";
+    EXPECT_FALSE(client.submit_task_sync(std::move(s)).idempotency_key.empty());
+
+    auto executed = service_.Executed();
+    EXPECT_EQ(executed.size(), 11u);
+    for (auto& [key, n] : executed) {
+        EXPECT_EQ(key.size(), 32u);
+        EXPECT_EQ(n, 1);
+    }
+
+    // 关掉重试：错误原样抛给调用方
+    Task once;
+    once.task_id = "once";
+    RetryPolicy no_retry;
+    no_retry.max_attempts = 1;
+    once.idempotency_key = "k-once";
+    try {
+        client.submit_task_async(std::move(once), nullptr, {.retry = no_retry}).get();
+        FAIL() << "expected UNAVAILABLE";
+    } catch (const GrpcError& e) {
+        EXPECT_EQ(e.code(), grpc::StatusCode::UNAVAILABLE);
+    }
+}
+
+// 每次调用都有截止时间：慢服务端上拿到 DEADLINE_EXCEEDED，而不是一直挂着
+TEST_F(GrpcClientPoolTest, DeadlineBoundsSlowCalls) {
+    service_.submit_delay_ms = 500;
+    GrpcClient client(Target());
+
+    auto t0 = std::chrono::steady_clock::now();
+    Task t;
+    t.task_id = "slow";
+    try {
+        client.submit_task_async(std::move(t), nullptr, {.timeout = std::chrono::milliseconds(50)}).get();
+        FAIL() << "expected DEADLINE_EXCEEDED";
+    } catch (const GrpcError& e) {
+        EXPECT_EQ(e.code(), grpc::StatusCode::DEADLINE_EXCEEDED);
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(400));
+}
+
+// 长尾查询：对冲后最慢的一次也远低于注入的 300ms
+TEST_F(GrpcClientPoolTest, HedgedQueriesCutTail) {
+    service_.slow_every = 10;
+    auto worst = [&](GrpcClient& client) {
+        std::chrono::steady_clock::duration max{};
+        for (int i = 0; i < 60; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            EXPECT_EQ(client.query_status_async("q" + std::to_string(i)).get().task_id,
+                      "q" + std::to_string(i));
+            max = std::max(max, std::chrono::steady_clock::now() - t0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(max);
+    };
+
+    ClientOptions plain;
+    plain.channels = 2;
+    GrpcClient base(Target(), plain);
+    const auto base_worst = worst(base);
+
+    ClientOptions hedged = plain;
+    hedged.hedge.max_attempts = 2;
+    hedged.hedge.initial_delay = std::chrono::milliseconds(20);
+    GrpcClient client(Target(), hedged);
+    const auto hedged_worst = worst(client);
+
+    std::cout << "[Hedge] worst plain=" << base_worst.count() << "ms hedged="
+              << hedged_worst.count() << "ms delay=" << client.hedge_delay().count() << "ms"
+              << std::endl;
+    EXPECT_GE(base_worst, std::chrono::milliseconds(300));
+    EXPECT_LT(hedged_worst, std::chrono::milliseconds(150));
+
+    // 确定性错误不对冲
+    service_.slow_every = 0;
+    int before = service_.Queries();
+    EXPECT_THROW(client.query_status_async("").get(), GrpcError);
+    EXPECT_EQ(service_.Queries() - before, 1);
+
+    // 哪些错误不作数由 HedgePolicy 自己决定，与提交的 RetryPolicy 无关；
+    // 不作数的失败没有别的尝试在途时立即补发
+    ClientOptions tolerant = plain;
+    tolerant.hedge.max_attempts = 2;
+    tolerant.hedge.initial_delay = std::chrono::seconds(5);
+    tolerant.hedge.non_fatal = {grpc::StatusCode::NOT_FOUND};
+    GrpcClient retries(Target(), tolerant);
+    before = service_.Queries();
+    auto t0 = std::chrono::steady_clock::now();
+    EXPECT_THROW(retries.query_status_async("").get(), GrpcError);
+    EXPECT_EQ(service_.Queries() - before, 2);
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::seconds(1));
+}
+
+// 监听流被服务端断开后带游标重连：结果不重不漏，用户回调看不到中间的断线
+TEST_F(GrpcClientPoolTest, ListenResumesAfterDrop) {
+    service_.listen_total = 10;
+    service_.listen_per_stream = 3;
+    ClientOptions opts;
+    opts.retry.initial_backoff = std::chrono::milliseconds(5);
+    GrpcClient client(Target(), opts);
+
+    std::mutex mu;
+    std::vector<std::string> ids;
+    std::vector<grpc::StatusCode> errors;
+    std::promise<void> all;
+    client.listen_results("c1", [&](const Task& t, grpc::Status st) {
+        std::lock_guard<std::mutex> lk(mu);
+        if (!st.ok()) {
+            errors.push_back(st.error_code());
+            return;
+        }
+        ids.push_back(t.task_id);
+        if (ids.size() == 10) all.set_value();
+    });
+    ASSERT_EQ(all.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    std::lock_guard<std::mutex> lk(mu);
+    for (int i = 0; i < 10; ++i) EXPECT_EQ(ids[i], std::to_string(i + 1));
+    EXPECT_TRUE(errors.empty());
+    EXPECT_EQ(service_.listens.load(), 4);
+}
+
+/* ---------- callback API 客户端 ---------- */
+namespace {
+
+// 反复提交 remaining 次：每次完成就在 gRPC 线程上原地再发下一次
+class LoopSubmit final : public SubmitCall {
+public:
+    LoopSubmit(CallbackClient& client, int n) : client_(client), remaining_(n) {}
+
+    void Begin() {
+        request().Clear();
+        request().set_task_id(std::to_string(remaining_));
+        client_.Start(this);
+    }
+    void Wait() { done_.get_future().wait(); }
+    int failures() const { return failures_; }
+
+protected:
+    void OnComplete(const grpc::Status& status) override {
+        if (!status.ok() || response().task().task_id() != request().task_id()) ++failures_;
+        if (--remaining_ > 0) Begin();
+        else done_.set_value();
+    }
+
+private:
+    CallbackClient& client_;
+    int remaining_;
+    int failures_ = 0;
+    std::promise<void> done_;
+};
+
+class CollectListen final : public ListenCall {
+public:
+    std::promise<grpc::Status> closed;
+
+protected:
+    void OnResult(Task&&) override {}
+    void OnClosed(const grpc::Status& status) override { closed.set_value(status); }
+};
+
+} // namespace
+
+TEST_F(GrpcClientPoolTest, CallbackClientTokensAndReactors) {
+    CallbackClient client(Target(), ClientOptions{.channels = 2});
+
+    std::promise<std::pair<Task, grpc::Status>> submitted;
+    Task t;
+    t.task_id = "cb";
+    client.submit(std::move(t), [&](Task&& r, grpc::Status st) {
+        submitted.set_value({std::move(r), st});
+    });
+    auto [task, st] = submitted.get_future().get();
+    ASSERT_TRUE(st.ok());
+    EXPECT_EQ(task.task_id, "cb");
+    EXPECT_EQ(task.state, TaskState::SUCCESS);
+
+    std::promise<grpc::Status> queried;
+    client.query_status("", [&](Task&&, grpc::Status s) { queried.set_value(s); });
+    EXPECT_EQ(queried.get_future().get().error_code(), grpc::StatusCode::NOT_FOUND);
+
+    std::promise<bool> cancelled;
+    auto on_cancel = [&](bool ok, grpc::Status) { cancelled.set_value(ok); };   // 左值令牌按值拷进调用
+    client.cancel_task("cancel-me", on_cancel);
+    EXPECT_TRUE(cancelled.get_future().get());
+
+    // 同一个调用对象连发 500 次，每次在上一次的 OnComplete 里发起
+    LoopSubmit loop(client, 500);
+    loop.Begin();
+    loop.Wait();
+    EXPECT_EQ(loop.failures(), 0);
+
+    // 超时套到每次新建的上下文上
+    service_.submit_delay_ms = 100;
+    LoopSubmit slow(client, 2);
+    slow.set_timeout(std::chrono::milliseconds(10));
+    slow.Begin();
+    slow.Wait();
+    EXPECT_EQ(slow.failures(), 2);
+    service_.submit_delay_ms = 0;
+
+    CollectListen listen;
+    client.Listen(&listen, "c1");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    listen.Cancel();
+    EXPECT_EQ(listen.closed.get_future().get().error_code(), grpc::StatusCode::CANCELLED);
+}
+
+// 回环压测：CQ 客户端（future）vs callback 客户端（复用调用对象），串行延迟与并发吞吐
+TEST_F(GrpcClientPoolTest, CallbackVsCqClient) {
+    constexpr int kSerial = 2'000, kTotal = 20'000, kWindow = 256;
+    ClientOptions opts;
+    opts.channels = 1;
+    opts.cq_threads = 1;
+    using Clock = std::chrono::steady_clock;
+    auto micros = [](Clock::duration d, int n) {
+        return std::chrono::duration<double, std::micro>(d).count() / n;
+    };
+
+    double cq_lat = 0, cq_rps = 0;
+    {
+        GrpcClient client(Target(), opts);
+        auto t0 = Clock::now();
+        for (int i = 0; i < kSerial; ++i) {
+            Task t;
+            t.task_id = std::to_string(i);
+            client.submit_task_async(std::move(t)).get();
+        }
+        cq_lat = micros(Clock::now() - t0, kSerial);
+        cq_rps = Pump(client, kTotal, kWindow);
+    }
+
+    double cb_lat = 0, cb_rps = 0;
+    {
+        CallbackClient client(Target(), opts);
+        LoopSubmit serial(client, kSerial);
+        auto t0 = Clock::now();
+        serial.Begin();
+        serial.Wait();
+        cb_lat = micros(Clock::now() - t0, kSerial);
+        EXPECT_EQ(serial.failures(), 0);
+
+        std::vector<std::unique_ptr<LoopSubmit>> window;
+        for (int i = 0; i < kWindow; ++i)
+            window.push_back(std::make_unique<LoopSubmit>(client, kTotal / kWindow));
+        t0 = Clock::now();
+        for (auto& w : window) w->Begin();
+        for (auto& w : window) w->Wait();
+        cb_rps = (kTotal / kWindow) * kWindow /
+                 std::chrono::duration<double>(Clock::now() - t0).count();
+        for (auto& w : window) EXPECT_EQ(w->failures(), 0);
+    }
+    std::cout << "[CallbackClient] latency cq=" << cq_lat << "us callback=" << cb_lat << "us; "
+              << "throughput cq=" << static_cast<long>(cq_rps) << " rpc/s callback="
+              << static_cast<long>(cb_rps) << " rpc/s" << std::endl;
+}
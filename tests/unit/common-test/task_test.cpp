@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "task.hpp"
+#include "utils.hpp"
+#include "arena_pool.hpp"
+#include "task_table.hpp"
 #include <chrono>
 
 namespace dts {
@@ -18,6 +21,8 @@ protected:
         task.func_params = {{"n", 10}, {"extra", "test"}};  // 嵌套 JSON
         task.required = {2.5, 1024};
         task.shard = {0, 1};
+        task.parent_ids = {"uuid-1000", "uuid-1001"};
+        task.child_count = 2;
         task.timeout_ms = 30000;
         task.max_retry = 3;
         task.retry_count = 0;
@@ -44,6 +49,8 @@ TEST_F(TaskSerializationTest, SerializeAndDeserialize) {
     EXPECT_EQ(deserialized_task.task_id, task.task_id);
     EXPECT_EQ(deserialized_task.client_id, task.client_id);
     EXPECT_EQ(deserialized_task.priority, task.priority);
+    EXPECT_EQ(deserialized_task.parent_ids, task.parent_ids);
+    EXPECT_EQ(deserialized_task.child_count, task.child_count);
     EXPECT_EQ(deserialized_task.state, task.state);
     EXPECT_EQ(deserialized_task.func_name, task.func_name);
     EXPECT_EQ(deserialized_task.func_params["n"], task.func_params["n"]);
@@ -86,6 +93,136 @@ TEST_F(TaskSerializationTest, ComplexFuncParams) {
     EXPECT_EQ(deserialized_task.func_params["config"]["key2"], 42);
 }
 
+// 测试 arena 上的 proto 往返
+TEST_F(TaskSerializationTest, ProtoRoundTripOnArena) {
+    auto arena = ArenaPool::Acquire();
+    PbTask* proto = TaskToProto(task, arena.get());
+    EXPECT_EQ(proto->GetArena(), arena.get());
+    EXPECT_EQ(proto->func_params().GetArena(), arena.get());
+
+    Task back = TaskFromProto(*proto);
+    EXPECT_EQ(back.task_id, task.task_id);
+    EXPECT_EQ(back.parent_ids, task.parent_ids);
+    EXPECT_EQ(back.child_count, task.child_count);
+    EXPECT_EQ(back.client_id, task.client_id);
+    EXPECT_EQ(back.func_params["n"], 10);
+    EXPECT_EQ(back.func_params["extra"], "test");
+    EXPECT_EQ(back.result["output"], 55);
+    EXPECT_EQ(back.submit_ts, task.submit_ts);
+}
+
+// 测试 arena 在同一线程内回收复用
+TEST(ArenaPoolTest, RecyclesOnSameThread) {
+    std::size_t cached = ArenaPool::CachedOnThisThread();
+    google::protobuf::Arena* first = nullptr;
+    {
+        auto h = ArenaPool::Acquire();
+        first = h.get();
+        google::protobuf::Arena::CreateMessage<PbTask>(first)->set_task_id("x");
+    }
+    EXPECT_EQ(ArenaPool::CachedOnThisThread(), std::max<std::size_t>(cached, 1));
+
+    auto again = ArenaPool::Acquire();
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(again.get()->SpaceUsed(), 0u);
+}
+
+// 测试紧凑任务表：驻留、往返、失效句柄
+TEST_F(TaskSerializationTest, CompactTableRoundTrip) {
+    TaskTable table;
+    task.start_ts = task.submit_ts + 15;
+    auto h = table.insert(task);
+    ASSERT_TRUE(h);
+
+    const TaskHot* hot = table.hot(h);
+    ASSERT_NE(hot, nullptr);
+    EXPECT_EQ(hot->id, MakeTaskId(task.task_id));
+    EXPECT_EQ(StringInterner::clients().lookup(hot->client), task.client_id);
+    EXPECT_EQ(hot->cpu_millis, 2500u);
+    EXPECT_EQ(hot->start_ts(), task.start_ts);
+    EXPECT_EQ(hot->finish_ts(), 0);
+
+    Task back = table.materialize(h);
+    EXPECT_EQ(back.task_id, task.task_id);
+    EXPECT_EQ(back.client_id, task.client_id);
+    EXPECT_DOUBLE_EQ(back.required.cpu_core, task.required.cpu_core);
+    EXPECT_EQ(back.func_params["n"], 10);
+    EXPECT_EQ(back.start_ts, task.start_ts);
+    EXPECT_EQ(back.parent_ids, task.parent_ids);
+    EXPECT_EQ(back.child_count, task.child_count);
+
+    EXPECT_TRUE(table.erase(h));
+    EXPECT_EQ(table.hot(h), nullptr);            // 旧句柄失效
+    auto h2 = table.insert(task);                // 复用同一槽位，代数不同
+    EXPECT_EQ(h2.index, h.index);
+    EXPECT_NE(h2.generation, h.generation);
+}
+
+// 测试附件零拷贝：右值往返时缓冲区地址不变
+TEST_F(TaskSerializationTest, AttachmentMovesWithoutCopy) {
+    std::string blob(4 << 20, 'x');                   // 4 MiB
+    blob[123] = 'y';
+    const char* raw = blob.data();
+    task.inputs.push_back({"image", "application/octet-stream", Payload::Adopt(std::move(blob))});
+    ASSERT_EQ(task.inputs[0].data.span().data(), reinterpret_cast<const std::byte*>(raw));
+
+    auto arena = ArenaPool::Acquire();
+    PbTask* proto = TaskToProto(std::move(task), arena.get());
+    ASSERT_EQ(proto->inputs_size(), 1);
+    EXPECT_EQ(proto->inputs(0).chunks(0).data(), raw);
+    EXPECT_EQ(proto->func_params().fields().at("n").number_value(), 10);
+
+    Task back = TaskFromProto(std::move(*proto));
+    const Attachment* img = FindAttachment(back.inputs, "image");
+    ASSERT_NE(img, nullptr);
+    EXPECT_EQ(img->content_type, "application/octet-stream");
+    EXPECT_EQ(img->data.size(), 4u << 20);
+    EXPECT_EQ(img->data.view().data(), raw);
+    EXPECT_EQ(img->data.view()[123], 'y');
+    EXPECT_EQ(back.func_params["n"], 10);
+
+    // 共享的块走 const 路径，必须复制而不是偷走
+    Task copy = back;
+    PbTask pb = TaskToProto(copy);
+    EXPECT_NE(pb.inputs(0).chunks(0).data(), raw);
+    EXPECT_EQ(img->data.view().data(), raw);
+}
+
+TEST(PayloadTest, ChunkedAppendShares) {
+    Payload p = Payload::Copy(std::string_view("hello "));
+    Payload q = Payload::Copy(std::string_view("world"));
+    p.append(q);
+    EXPECT_EQ(p.size(), 11u);
+    EXPECT_EQ(p.chunk_count(), 2u);
+    EXPECT_FALSE(p.contiguous());
+    EXPECT_THROW(p.span(), std::logic_error);
+    EXPECT_EQ(p.flatten(), "hello world");
+    EXPECT_EQ(p.chunk(1).data(), q.span().data());
+}
+
+TEST(TaskTableTest, InternAndScan) {
+    auto a = StringInterner::clients().intern("tenant-a");
+    EXPECT_EQ(StringInterner::clients().intern("tenant-a"), a);
+    EXPECT_EQ(MakeTaskId("12345"), 12345u);
+
+    TaskTable table;
+    constexpr int N = 100'000;
+    Task t;
+    t.client_id = "tenant-a";
+    for (int i = 1; i <= N; ++i) {
+        t.task_id = std::to_string(i);
+        t.priority = i % 8;
+        table.insert(t);
+    }
+    EXPECT_EQ(table.size(), static_cast<std::size_t>(N));
+
+    std::size_t high = 0;
+    table.for_each_hot([&](TaskTable::Handle, TaskHot& h) {
+        if (h.priority == 7) ++high;
+    });
+    EXPECT_EQ(high, static_cast<std::size_t>(N / 8));
+}
+
 }  // namespace dts
 
 int main(int argc, char **argv) {
@@ -0,0 +1,260 @@
+#include "dag_tracker.hpp"
+#include "task_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+namespace {
+
+Task DagTask(const std::string& id, std::vector<std::string> parents = {}) {
+    Task t = MakeTask(id);
+    t.parent_ids = std::move(parents);
+    return t;
+}
+
+std::vector<std::string> Ids(const std::vector<DagTracker::Ready>& ready) {
+    std::vector<std::string> ids;
+    for (const auto& r : ready) ids.push_back(r.task.task_id);
+    return ids;
+}
+
+} // namespace
+
+TEST(DagTrackerTest, RejectsCyclesAndUnknownParents) {
+    DagTracker dag;
+    std::vector<DagTracker::Ready> ready;
+    EXPECT_FALSE(dag.submit({DagTask("a", {"b"}), DagTask("b", {"a"})}, ready));
+    EXPECT_FALSE(dag.submit({DagTask("a", {"a"})}, ready));
+    EXPECT_FALSE(dag.submit({DagTask("a", {"missing"})}, ready));
+    EXPECT_FALSE(dag.submit({DagTask("a"), DagTask("a")}, ready));
+    EXPECT_TRUE(ready.empty());
+    EXPECT_EQ(dag.size(), 0u);
+
+    ASSERT_TRUE(dag.submit({DagTask("a")}, ready));
+    EXPECT_FALSE(dag.submit({DagTask("a")}, ready));               // 与在册任务重名
+}
+
+// 菱形 a -> {b, c} -> d：d 等 b、c 都成功才放出，并带上关键上游的节点
+TEST(DagTrackerTest, DiamondReleasesOnLastParent) {
+    DagTracker dag;
+    std::vector<DagTracker::Ready> ready;
+    std::vector<std::string> skipped;
+    ASSERT_TRUE(dag.submit({DagTask("d", {"b", "c"}), DagTask("b", {"a"}), DagTask("c", {"a"}), DagTask("a")},
+                           ready));
+    EXPECT_EQ(Ids(ready), std::vector<std::string>{"a"});
+    EXPECT_EQ(ready[0].task.child_count, 2u);                         // 执行端据此留结果
+    EXPECT_EQ(dag.size(), 4u);
+
+    ready.clear();
+    EXPECT_TRUE(dag.complete("a", true, 7, ready, skipped));
+    EXPECT_FALSE(dag.complete("a", true, 7, ready, skipped));        // 重复报告
+    ASSERT_EQ(ready.size(), 2u);
+    EXPECT_EQ(ready[0].hint, 7u);
+    EXPECT_EQ(ready[1].hint, 7u);
+
+    ready.clear();
+    EXPECT_TRUE(dag.complete("b", true, 1, ready, skipped));
+    EXPECT_TRUE(ready.empty());
+    EXPECT_TRUE(dag.complete("c", true, 2, ready, skipped));
+    ASSERT_EQ(Ids(ready), std::vector<std::string>{"d"});
+    EXPECT_EQ(ready[0].task.child_count, 0u);
+    EXPECT_NE(ready[0].hint, NodeCapacityIndex::kNoNode);
+    EXPECT_TRUE(dag.complete("d", true, 2, ready, skipped));
+    EXPECT_TRUE(skipped.empty());
+    EXPECT_EQ(dag.size(), 0u);
+}
+
+// 上游失败：所有下游（含传递）跳过；取消未放出的任务同样
+TEST(DagTrackerTest, FailureAndCancelSkipDescendants) {
+    DagTracker dag;
+    std::vector<DagTracker::Ready> ready;
+    std::vector<std::string> skipped;
+    ASSERT_TRUE(dag.submit({DagTask("a"), DagTask("b", {"a"}), DagTask("c", {"b"}), DagTask("x"),
+                            DagTask("y", {"x"}), DagTask("z", {"y", "x"})},
+                           ready));
+    ASSERT_EQ(ready.size(), 2u);
+
+    ready.clear();
+    EXPECT_TRUE(dag.complete("a", false, 0, ready, skipped));
+    EXPECT_TRUE(ready.empty());
+    EXPECT_EQ(skipped, (std::vector<std::string>{"b", "c"}));
+
+    // z 还有上游 x 未结束：等 x 结束时才确定跳过
+    skipped.clear();
+    EXPECT_TRUE(dag.cancel("y", skipped));
+    EXPECT_FALSE(dag.cancel("x", skipped));                            // 已放出
+    EXPECT_TRUE(skipped.empty());
+    EXPECT_TRUE(dag.complete("x", true, 0, ready, skipped));
+    EXPECT_TRUE(ready.empty());
+    EXPECT_EQ(skipped, std::vector<std::string>{"z"});
+    EXPECT_EQ(dag.size(), 0u);
+}
+
+// 关键路径：最长链上的任务加一档优先级，同批放出的按剩余路径长短排
+TEST(DagTrackerTest, CriticalPathFirst) {
+    DagTracker dag;
+    std::vector<DagTracker::Ready> ready;
+    std::vector<std::string> skipped;
+    // root -> short；root -> long1 -> long2 -> long3
+    ASSERT_TRUE(dag.submit({DagTask("root"), DagTask("short", {"root"}), DagTask("long1", {"root"}),
+                            DagTask("long2", {"long1"}), DagTask("long3", {"long2"}), DagTask("lone")},
+                           ready));
+    ASSERT_EQ(Ids(ready), (std::vector<std::string>{"root", "lone"}));
+    EXPECT_EQ(ready[0].task.priority, 1u);
+    EXPECT_EQ(ready[1].task.priority, 0u);
+
+    ready.clear();
+    dag.complete("root", true, 3, ready, skipped);
+    ASSERT_EQ(Ids(ready), (std::vector<std::string>{"long1", "short"}));
+    EXPECT_EQ(ready[0].task.priority, 1u);
+    EXPECT_EQ(ready[1].task.priority, 0u);
+
+    // 估计耗时可换：short 很贵时它成为关键路径
+    DagTracker weighted([](const Task& t) { return t.task_id == "short" ? 100.0 : 1.0; });
+    ready.clear();
+    ASSERT_TRUE(weighted.submit({DagTask("root"), DagTask("short", {"root"}), DagTask("long1", {"root"}),
+                                 DagTask("long2", {"long1"})},
+                                ready));
+    ready.clear();
+    weighted.complete("root", true, 0, ready, skipped);
+    ASSERT_EQ(Ids(ready), (std::vector<std::string>{"short", "long1"}));
+    EXPECT_EQ(ready[0].task.priority, 1u);
+}
+
+// 宽扇入：多线程并发报告上游完成，汇点恰好放出一次
+TEST(DagTrackerTest, ConcurrentFanInReleasesOnce) {
+    constexpr int kParents = 20'000;
+    constexpr int kThreads = 4;
+    DagTracker dag;
+    std::vector<Task> tasks;
+    std::vector<std::string> parents;
+    for (int i = 0; i < kParents; ++i) {
+        tasks.push_back(DagTask("p" + std::to_string(i)));
+        parents.push_back(tasks.back().task_id);
+    }
+    tasks.push_back(DagTask("sink", parents));
+    std::vector<DagTracker::Ready> ready;
+    ASSERT_TRUE(dag.submit(std::move(tasks), ready));
+    ASSERT_EQ(ready.size(), static_cast<std::size_t>(kParents));
+
+    std::atomic<int> sinks{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kThreads; ++w) {
+        threads.emplace_back([&, w] {
+            std::vector<DagTracker::Ready> out;
+            std::vector<std::string> skipped;
+            for (int i = w; i < kParents; i += kThreads) {
+                dag.complete("p" + std::to_string(i), true, static_cast<std::uint32_t>(w), out, skipped);
+            }
+            for (auto& r : out) {
+                if (r.task.task_id == "sink") ++sinks;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sinks.load(), 1);
+    EXPECT_EQ(dag.size(), 1u);
+}
+
+// 重复报告同一任务结束、取消与最后一个上游的完成赛跑：各只有一方得手，节点不会在别人手里被释放
+TEST(DagTrackerTest, ConcurrentDuplicateCompleteAndCancel) {
+    constexpr int kRounds = 2000;
+    DagTracker dag;
+    int released = 0, cancelled = 0;
+    for (int r = 0; r < kRounds; ++r) {
+        const std::string p = "p" + std::to_string(r), c = "c" + std::to_string(r);
+        std::vector<DagTracker::Ready> ready;
+        ASSERT_TRUE(dag.submit({DagTask(p), DagTask(c, {p})}, ready));
+
+        // 取消 c 与完成 p 同时发生
+        std::atomic<bool> go{false};
+        std::vector<DagTracker::Ready> out;
+        std::vector<std::string> skipped_a, skipped_b;
+        bool cancel_ok = false;
+        std::thread canceller([&] {
+            while (!go.load(std::memory_order_acquire)) {}
+            cancel_ok = dag.cancel(c, skipped_b);
+        });
+        go.store(true, std::memory_order_release);
+        EXPECT_TRUE(dag.complete(p, true, 0, out, skipped_a));
+        canceller.join();
+        ASSERT_NE(cancel_ok, out.size() == 1u);
+        if (cancel_ok) {
+            ++cancelled;
+            EXPECT_EQ(dag.size(), 0u);
+            continue;
+        }
+        ++released;
+
+        // 同一个下游被两个执行端重复报告结束
+        std::atomic<int> wins{0};
+        go.store(false);
+        std::vector<std::thread> reporters;
+        for (int k = 0; k < 2; ++k) {
+            reporters.emplace_back([&] {
+                std::vector<DagTracker::Ready> none;
+                std::vector<std::string> skipped;
+                while (!go.load(std::memory_order_acquire)) {}
+                if (dag.complete(c, true, 0, none, skipped)) ++wins;
+            });
+        }
+        go.store(true, std::memory_order_release);
+        for (auto& t : reporters) t.join();
+        EXPECT_EQ(wins.load(), 1);
+        EXPECT_EQ(dag.size(), 0u);
+    }
+    EXPECT_EQ(released + cancelled, kRounds);
+}
+
+// 调度器：上游结束即放出下游，下游放到上游所在节点；失败连带取消
+TEST(DagTrackerTest, SchedulerColocatesChildren) {
+    std::vector<std::pair<std::uint32_t, Task>> running;
+    NodeCapacityIndex nodes = MakeNodes(4, Resource{8, 8192});
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                        [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                            for (auto& t : batch) running.emplace_back(node, std::move(t));
+                        });
+    // 4 条两段流水线 + 1 个会失败的上游
+    std::vector<Task> dag;
+    for (int i = 0; i < 4; ++i) {
+        dag.push_back(DagTask("map" + std::to_string(i)));
+        dag.back().required = Resource{6, 1024};                      // 一个节点只放得下一个 map
+        dag.push_back(DagTask("reduce" + std::to_string(i), {"map" + std::to_string(i)}));
+    }
+    dag.push_back(DagTask("bad"));
+    dag.push_back(DagTask("after_bad", {"bad"}));
+    ASSERT_TRUE(sched.submit_dag(std::move(dag)));
+    EXPECT_FALSE(sched.submit(DagTask("orphan", {"nowhere"})));
+    EXPECT_EQ(sched.pending(), 5u);
+
+    EXPECT_EQ(sched.run_cycle(), 5u);
+    std::map<std::string, std::uint32_t> where;
+    auto finished = std::move(running);
+    running.clear();
+    for (auto& [node, t] : finished) {
+        where[t.task_id] = node;
+        t.state = t.task_id == "bad" ? TaskState::FAILED : TaskState::SUCCESS;
+        auto skipped = sched.finish(node, t);
+        if (t.task_id == "bad") {
+            EXPECT_EQ(skipped, std::vector<std::string>{"after_bad"});
+        }
+    }
+    EXPECT_EQ(sched.pending(), 4u);
+    EXPECT_EQ(sched.run_cycle(), 4u);
+    for (auto& [node, t] : running) {
+        const std::string parent = "map" + t.task_id.substr(6);
+        EXPECT_EQ(node, where[parent]) << t.task_id;
+    }
+    EXPECT_EQ(sched.stats().co_located, 4u);
+    EXPECT_EQ(sched.in_dag(), 4u);
+}
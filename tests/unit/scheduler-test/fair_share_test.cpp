@@ -0,0 +1,152 @@
+#include "fair_share.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace dts;
+
+namespace {
+
+Task MakeTask(const std::string& client, int i, double cpu = 1) {
+    Task t;
+    t.task_id = client + "-" + std::to_string(i);
+    t.client_id = client;
+    t.required = Resource{cpu, 256};
+    return t;
+}
+
+std::map<std::string, int> CountByClient(const std::vector<Task>& tasks) {
+    std::map<std::string, int> n;
+    for (auto& t : tasks) ++n[t.client_id];
+    return n;
+}
+
+} // namespace
+
+// 积压的租户按权重分配，成本按主导资源计
+TEST(FairShareTest, WeightedShares) {
+    FairShareQueue q;
+    q.set_tenant("gold", TenantConfig{3.0, {}});
+    for (int i = 0; i < 4000; ++i) {
+        ASSERT_TRUE(q.push(MakeTask("gold", i)));
+        ASSERT_TRUE(q.push(MakeTask("free", i)));
+        ASSERT_TRUE(q.push(MakeTask("fat", i, 2)));   // 每个任务成本翻倍
+    }
+    std::vector<Task> out;
+    ASSERT_EQ(q.drain(out, 2000), 2000u);
+    auto n = CountByClient(out);
+    // 额度 24 : 8 : 8 → 任务数 24 : 8 : 4
+    EXPECT_NEAR(n["gold"] / static_cast<double>(n["free"]), 3.0, 0.1);
+    EXPECT_NEAR(n["free"] / static_cast<double>(n["fat"]), 2.0, 0.1);
+    EXPECT_EQ(q.size(), 12000u - 2000u);
+}
+
+// 洪水租户不会饿死小租户：第一批里就有小租户的任务
+TEST(FairShareTest, FloodDoesNotStarve) {
+    FairShareQueue q;
+    for (int i = 0; i < 50'000; ++i) q.push(MakeTask("flood", i));
+    for (int i = 0; i < 5; ++i) q.push(MakeTask("small", i));
+    std::vector<Task> out;
+    q.drain(out, 64);
+    EXPECT_EQ(CountByClient(out)["small"], 5);
+}
+
+// 非正权重被拒绝、沿用默认权重；深度透支的租户一次 drain 内就能补回额度继续取，不空转也不卡住
+TEST(FairShareTest, RejectsNonPositiveWeightAndRecoversFromOverdraft) {
+    FairShareQueue q;
+    EXPECT_FALSE(q.set_tenant("zero", TenantConfig{0.0, {}}));
+    EXPECT_FALSE(q.set_tenant("zero", TenantConfig{-1.0, {}}));
+    EXPECT_FALSE(q.set_tenant("zero", TenantConfig{std::nan(""), {}}));
+    for (int i = 0; i < 3; ++i) q.push(MakeTask("zero", i));
+    std::vector<Task> out;
+    EXPECT_EQ(q.drain(out, 8), 3u);
+    EXPECT_TRUE(q.empty());
+
+    // 一个成本 100 的任务把额度透支到 -92，之后的小任务仍在同一次 drain 里取到
+    q.push(MakeTask("big", 0, 100));
+    for (int i = 1; i <= 10; ++i) q.push(MakeTask("big", i));
+    out.clear();
+    EXPECT_EQ(q.drain(out, 5), 5u);
+    EXPECT_EQ(out[0].task_id, "big-0");
+
+    // 环上有多个透支租户：先回正的先取
+    FairShareQueue multi;
+    multi.push(MakeTask("a", 0, 50));
+    multi.push(MakeTask("b", 0, 20));
+    for (int i = 1; i <= 4; ++i) {
+        multi.push(MakeTask("a", i));
+        multi.push(MakeTask("b", i));
+    }
+    out.clear();
+    ASSERT_EQ(multi.drain(out, 3), 3u);
+    EXPECT_EQ(out[2].client_id, "b");
+}
+
+// 额度用满就摘环，release 后恢复；requeue 退还占用
+TEST(FairShareTest, QuotaThrottlesUntilRelease) {
+    FairShareQueue q;
+    q.set_tenant("capped", TenantConfig{1.0, Resource{2, 0}});
+    for (int i = 0; i < 10; ++i) q.push(MakeTask("capped", i));
+    for (int i = 0; i < 3; ++i) q.push(MakeTask("other", i));
+
+    std::vector<Task> out;
+    q.drain(out, 100);
+    auto n = CountByClient(out);
+    EXPECT_EQ(n["capped"], 2);
+    EXPECT_EQ(n["other"], 3);
+    EXPECT_DOUBLE_EQ(q.in_use("capped").cpu_core, 2);
+
+    out.clear();
+    EXPECT_EQ(q.drain(out, 100), 0u);
+    q.release("capped", Resource{1, 256});
+    EXPECT_EQ(q.drain(out, 100), 1u);
+
+    q.requeue(std::move(out[0]));
+    EXPECT_DOUBLE_EQ(q.in_use("capped").cpu_core, 1);
+    EXPECT_TRUE(q.cancel("capped-9"));
+    EXPECT_FALSE(q.cancel("capped-9"));
+    EXPECT_EQ(q.size(), 7u);
+}
+
+// 基准：1000 个租户、20 万任务，入队与 DRR 出队速率，对照不分租户的 TaskQueue
+TEST(FairShareTest, ThousandTenantThroughput) {
+    constexpr int kTenants = 1000, kTasks = 200'000;
+    using Clock = std::chrono::steady_clock;
+    auto rate = [](int n, Clock::duration d) {
+        return static_cast<long>(n / std::chrono::duration<double>(d).count());
+    };
+    std::vector<Task> tasks;
+    tasks.reserve(kTasks);
+    for (int i = 0; i < kTasks; ++i) tasks.push_back(MakeTask("c" + std::to_string(i % kTenants), i, 0.5 + i % 3));
+
+    FairShareQueue fair;
+    for (int c = 0; c < kTenants; ++c) fair.set_tenant("c" + std::to_string(c), TenantConfig{1.0 + c % 4, {}});
+    auto copy = tasks;
+    auto t0 = Clock::now();
+    for (auto& t : copy) fair.push(std::move(t));
+    const auto fair_push = Clock::now() - t0;
+    std::vector<Task> out;
+    out.reserve(kTasks);
+    t0 = Clock::now();
+    while (fair.drain(out, 4096) > 0) {}
+    const auto fair_drain = Clock::now() - t0;
+    ASSERT_EQ(out.size(), static_cast<std::size_t>(kTasks));
+
+    TaskQueue plain;
+    out.clear();
+    t0 = Clock::now();
+    for (auto& t : tasks) plain.push(std::move(t));
+    const auto plain_push = Clock::now() - t0;
+    t0 = Clock::now();
+    while (plain.pop_batch(out, 4096) > 0) {}
+    const auto plain_drain = Clock::now() - t0;
+
+    std::cout << "[FairShare] tenants=" << kTenants << " tasks=" << kTasks
+              << " push=" << rate(kTasks, fair_push) << "/s drain=" << rate(kTasks, fair_drain) << "/s"
+              << " (plain TaskQueue push=" << rate(kTasks, plain_push) << "/s pop=" << rate(kTasks, plain_drain)
+              << "/s)" << std::endl;
+}
@@ -0,0 +1,241 @@
+#include "preemptor.hpp"
+#include "task_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+namespace {
+
+Task PriorityTask(const std::string& id, std::uint32_t priority, double cpu = 1) {
+    Task t = MakeTask(id, cpu);
+    t.priority = priority;
+    t.func_params = nlohmann::json::object();
+    return t;
+}
+
+} // namespace
+
+// 受害者：优先级最低的先挑，同级挑跑得最短的；各节点比较后取代价最小的
+TEST(PreemptorTest, PicksLowestPriorityLeastProgress) {
+    NodeCapacityIndex nodes = MakeNodes(2, Resource{4, 4096});
+    Preemptor pre(PreemptionOptions{.enabled = true});
+    std::map<std::string, Task> running;
+    auto run = [&](std::uint32_t node, Task t, std::int64_t start) {
+        nodes.reserve(node, t.required);
+        pre.on_dispatch(node, t, start);
+        running[t.task_id] = std::move(t);
+    };
+    Task mid = PriorityTask("mid", 0);
+    mid.retry_count = 2;
+    mid.func_params = {{"x", 1}};
+    run(0, PriorityTask("old", 0), 0);
+    run(0, mid, 500);
+    run(0, PriorityTask("new", 0), 900);
+    run(0, PriorityTask("p3", 3), 950);
+    for (int i = 0; i < 4; ++i) run(1, PriorityTask("n1-" + std::to_string(i), 1), 990);
+
+    std::vector<Preemptor::Victim> victims;
+    EXPECT_FALSE(pre.preempt(PriorityTask("low", 3, 2), nodes, 1000, victims));         // 不够抢占的优先级
+    EXPECT_FALSE(pre.preempt(PriorityTask("big", 7, 5), nodes, 1000, victims));         // 哪个节点都放不下
+    ASSERT_TRUE(pre.preempt(PriorityTask("urgent", 7, 2), nodes, 1000, victims));
+    ASSERT_EQ(victims.size(), 2u);
+    EXPECT_EQ(victims[0].node, 0u);
+    EXPECT_EQ(victims[0].task_id, "new");
+    EXPECT_EQ(victims[1].task_id, "mid");
+    EXPECT_TRUE(running["mid"].cancelled->load());
+    EXPECT_FALSE(running["old"].cancelled->load());
+    EXPECT_FALSE(pre.preempt(PriorityTask("urgent", 7, 2), nodes, 1000, victims));      // claim 未了结不重复抢
+    EXPECT_EQ(pre.claim("urgent"), 0u);
+    std::vector<std::uint32_t> claimed;
+    pre.claimed_nodes(claimed);
+    EXPECT_EQ(claimed, std::vector<std::uint32_t>{0});
+
+    // 受害者回队：retry_count 不变，带上 checkpoint，换新的取消标志
+    mid = running["mid"];
+    mid.state = TaskState::CANCELLED;
+    mid.result = {{"checkpoint", 42}};
+    auto again = pre.on_finish(mid);
+    ASSERT_TRUE(again);
+    EXPECT_EQ(again->retry_count, 2u);
+    EXPECT_EQ(again->func_params["checkpoint"], 42);
+    EXPECT_EQ(again->func_params["x"], 1);
+    EXPECT_EQ(again->state, TaskState::PENDING);
+    EXPECT_FALSE(again->cancelled->load());
+    // 信号到达前已跑完的按成功算，不回队
+    Task fresh = running["new"];
+    fresh.state = TaskState::SUCCESS;
+    EXPECT_FALSE(pre.on_finish(fresh));
+    claimed.clear();
+    pre.claimed_nodes(claimed);
+    EXPECT_TRUE(claimed.empty());
+
+    pre.on_dispatch(0, PriorityTask("urgent", 7, 2), 1100);
+    EXPECT_EQ(pre.claim("urgent"), NodeCapacityIndex::kNoNode);
+    EXPECT_EQ(pre.stats().preempted, 2u);
+    EXPECT_EQ(pre.stats().requeued, 1u);
+}
+
+// 调度器：放不下的紧急任务触发抢占，受害者退出后紧急任务放到空出的节点，受害者原样回队
+TEST(PreemptorTest, SchedulerRequeuesVictims) {
+    std::int64_t now = 1000;
+    std::vector<std::pair<std::uint32_t, Task>> running;
+    std::vector<std::pair<std::uint32_t, std::string>> cancelled;
+    std::vector<Task> resumed;
+    SchedulerOptions opt;
+    opt.clock = [&] { return now; };
+    opt.preemption.enabled = true;
+    NodeCapacityIndex nodes = MakeNodes(2, Resource{2, 4096});
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                        [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                            for (auto& t : batch) {
+                                if (t.func_params.contains("checkpoint")) resumed.push_back(t);
+                                running.emplace_back(node, std::move(t));
+                            }
+                        }, opt);
+    sched.set_cancel_hook([&](std::uint32_t node, const std::string& id) { cancelled.emplace_back(node, id); });
+
+    for (int i = 0; i < 4; ++i) {
+        Task t = PriorityTask("bg" + std::to_string(i), 0);
+        t.retry_count = 1;
+        sched.submit(std::move(t));
+    }
+    ASSERT_EQ(sched.run_cycle(), 4u);
+    sched.submit(PriorityTask("urgent", 7, 2));
+    now += 10;
+    EXPECT_EQ(sched.run_cycle(), 0u);
+    ASSERT_EQ(cancelled.size(), 2u);
+    EXPECT_EQ(cancelled[0].first, cancelled[1].first);
+    const std::uint32_t victim_node = cancelled[0].first;
+    EXPECT_EQ(sched.stats().preempted, 2u);
+
+    // 一个受害者退出后节点仍被留着，别的任务进不去
+    sched.submit(PriorityTask("filler", 0));
+    auto exit = [&](const std::string& id) {
+        auto it = std::find_if(running.begin(), running.end(), [&](const auto& r) { return r.second.task_id == id; });
+        ASSERT_NE(it, running.end());
+        ASSERT_TRUE(it->second.cancelled->load());
+        it->second.state = TaskState::CANCELLED;
+        it->second.result = {{"checkpoint", "half"}};
+        EXPECT_TRUE(sched.finish(it->first, it->second).empty());
+        running.erase(it);
+    };
+    exit(cancelled[0].second);
+    now += 10;
+    EXPECT_EQ(sched.run_cycle(), 0u);
+    exit(cancelled[1].second);
+    now += 10;
+    ASSERT_EQ(sched.run_cycle(), 1u);
+    EXPECT_EQ(running.back().second.task_id, "urgent");
+    EXPECT_EQ(running.back().first, victim_node);
+
+    // 另一节点陆续空出后，回队的受害者原样重新下发
+    for (int round = 0; round < 3 && resumed.size() < 2; ++round) {
+        for (auto it = running.begin(); it != running.end();) {
+            if (it->second.task_id == "urgent") {
+                ++it;
+                continue;
+            }
+            it->second.state = TaskState::SUCCESS;
+            sched.finish(it->first, it->second);
+            it = running.erase(it);
+        }
+        now += 10;
+        sched.run_cycle();
+    }
+    ASSERT_EQ(resumed.size(), 2u);
+    for (const auto& t : resumed) {
+        EXPECT_TRUE(t.task_id.starts_with("bg"));
+        EXPECT_EQ(t.retry_count, 1u);
+        EXPECT_EQ(t.func_params["checkpoint"], "half");
+        EXPECT_FALSE(t.cancelled->load());
+    }
+    EXPECT_EQ(sched.preemption().requeued, 2u);
+}
+
+// 模拟：50 个 8 核节点被 5~20s 的低优先级任务占满且一直有积压，每 100ms 来一个 2 核 200ms 的紧急任务。
+// 对比开/关抢占时紧急任务的排队时间（到达到下发）；被抢占的任务按 checkpoint 续跑
+TEST(PreemptorTest, UrgentQueueingDelaySimulation) {
+    constexpr int kNodes = 50;
+    constexpr std::int64_t kStep = 10, kDuration = 30'000, kUrgentEvery = 100;
+    auto simulate = [&](bool preempt) {
+        std::int64_t now = 0;
+        SchedulerOptions opt;
+        opt.clock = [&] { return now; };
+        opt.preemption.enabled = preempt;
+        NodeCapacityIndex nodes = MakeNodes(kNodes, Resource{8, 32768});
+        struct Run {
+            std::uint32_t node;
+            std::int64_t  start;
+            std::int64_t  end;
+            Task          task;
+        };
+        std::vector<Run> running;
+        std::map<std::string, std::int64_t> arrived;
+        std::vector<std::int64_t> delays;
+        TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                            [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                                for (auto& t : batch) {
+                                    std::int64_t d = 200;
+                                    if (t.priority == 0) {
+                                        d = 5000 + static_cast<std::int64_t>(std::hash<std::string>{}(t.task_id) % 15001);
+                                        d -= t.func_params.value("checkpoint", std::int64_t{0});
+                                    } else if (auto it = arrived.find(t.task_id); it != arrived.end()) {
+                                        delays.push_back(now - it->second);
+                                        arrived.erase(it);
+                                    }
+                                    running.push_back(Run{node, now, now + d, std::move(t)});
+                                }
+                            }, opt);
+
+        std::uint64_t bg = 0, urgent = 0;
+        for (; now < kDuration; now += kStep) {
+            while (sched.pending() < 64) sched.submit(PriorityTask("bg" + std::to_string(bg++), 0));
+            if (now % kUrgentEvery == 0) {
+                Task t = PriorityTask("urgent" + std::to_string(urgent++), 7, 2);
+                t.submit_ts = now;
+                arrived[t.task_id] = now;
+                sched.submit(std::move(t));
+            }
+            sched.run_cycle();
+            // 执行端：到点结束；被抢占的在下一步交回已完成的进度
+            for (std::size_t i = 0; i < running.size();) {
+                Run& r = running[i];
+                const bool stop = r.task.cancelled->load();
+                if (!stop && r.end > now + kStep) {
+                    ++i;
+                    continue;
+                }
+                if (stop) {
+                    r.task.state = TaskState::CANCELLED;
+                    r.task.result = {{"checkpoint", r.task.func_params.value("checkpoint", std::int64_t{0}) +
+                                                        now + kStep - r.start}};
+                } else {
+                    r.task.state = TaskState::SUCCESS;
+                }
+                sched.finish(r.node, r.task);
+                running[i] = std::move(running.back());
+                running.pop_back();
+            }
+        }
+        // 到最后还没下发的按排到结束算
+        for (const auto& [_, at] : arrived) delays.push_back(now - at);
+        std::sort(delays.begin(), delays.end());
+        const std::int64_t p50 = delays[delays.size() / 2];
+        const std::int64_t p99 = delays[delays.size() * 99 / 100];
+        std::cout << "[Preemption] " << (preempt ? "on " : "off") << " urgent=" << delays.size()
+                  << " queueing p50=" << p50 << "ms p99=" << p99 << "ms max=" << delays.back()
+                  << "ms preempted=" << sched.preemption().preempted << std::endl;
+        return delays.back();
+    };
+    const auto off = simulate(false);
+    const auto on = simulate(true);
+    EXPECT_LE(on, 3 * kStep);                            // 抢占一轮、受害者退出一步、再放置一轮
+    EXPECT_GT(off, 10 * on);
+}
@@ -0,0 +1,26 @@
+// scheduler_test_util.hpp
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "task.hpp"
+#include "scheduling_algorithm.hpp"
+
+namespace dts::test {
+
+// 调度器测试共用的任务与节点构造
+inline Task MakeTask(const std::string& id, double cpu = 1, std::uint64_t mem = 256) {
+    Task t;
+    t.task_id = id;
+    t.required = Resource{cpu, mem};
+    return t;
+}
+
+// n 个同规格节点，id 为 "node-<i>"
+inline NodeCapacityIndex MakeNodes(int n, const Resource& each) {
+    NodeCapacityIndex idx(each);
+    for (int i = 0; i < n; ++i) idx.add_node("node-" + std::to_string(i), each);
+    return idx;
+}
+
+} // namespace dts::test
@@ -0,0 +1,249 @@
+#include "scheduling_algorithm.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dts;
+
+namespace {
+
+Task MakeTask(double cpu, std::uint64_t mem, std::uint32_t priority = 0) {
+    Task t;
+    t.required = Resource{cpu, mem};
+    t.priority = priority;
+    return t;
+}
+
+} // namespace
+
+// 选剩余最少但放得下的节点；两维都要满足
+TEST(SchedulingAlgorithmTest, BestFitBothDimensions) {
+    NodeCapacityIndex idx(Resource{16, 65536});
+    const auto big   = idx.add_node("big", Resource{16, 65536});
+    const auto small = idx.add_node("small", Resource{4, 8192});
+    const auto lean  = idx.add_node("lean", Resource{8, 1024});
+
+    EXPECT_EQ(idx.best_fit(Resource{2, 512}), small);       // lean 的 CPU 更多，small 更紧
+    EXPECT_EQ(idx.best_fit(Resource{6, 512}), lean);
+    EXPECT_EQ(idx.best_fit(Resource{6, 4096}), big);        // lean 内存不够
+    EXPECT_EQ(idx.best_fit(Resource{32, 1}), NodeCapacityIndex::kNoNode);
+
+    ASSERT_TRUE(idx.reserve(small, Resource{4, 1024}));
+    EXPECT_FALSE(idx.reserve(small, Resource{0.5, 0}));
+    EXPECT_EQ(idx.best_fit(Resource{1, 512}), lean);
+    idx.release(small, Resource{100, 100'000});              // 不超过容量
+    EXPECT_DOUBLE_EQ(idx.node(small).free.cpu_core, 4);
+    EXPECT_EQ(idx.node(small).free.mem_mb, 8192u);
+
+    idx.set_schedulable(small, false);
+    EXPECT_EQ(idx.best_fit(Resource{1, 512}), lean);
+    idx.set_schedulable(small, true);
+    EXPECT_EQ(idx.best_fit(Resource{1, 512}), small);
+}
+
+// 一批任务：大任务先放，不超卖，高优先级在资源不够时优先
+TEST(SchedulingAlgorithmTest, BinPackingBatch) {
+    NodeCapacityIndex idx(Resource{8, 16384});
+    for (const char* id : {"a", "b", "c"}) idx.add_node(id, Resource{8, 16384});
+
+    // 按到达顺序 first-fit 会让 4 个 2 核占满 a、两个 6 核各占一台，最后的 4 核放不下；
+    // 先放大的则 6+2、6+2、4+2+2 刚好装满
+    std::vector<Task> batch = {MakeTask(2, 1024), MakeTask(2, 1024), MakeTask(2, 1024), MakeTask(2, 1024),
+                               MakeTask(6, 1024), MakeTask(6, 1024), MakeTask(4, 1024)};
+    BinPackingAlgorithm algo;
+    std::vector<std::uint32_t> out;
+    ASSERT_EQ(algo.place(batch, idx, out), batch.size());
+    double used[3] = {0, 0, 0};
+    for (std::size_t i = 0; i < batch.size(); ++i) used[out[i]] += batch[i].required.cpu_core;
+    for (double u : used) EXPECT_DOUBLE_EQ(u, 8.0);
+    EXPECT_NE(out[4], out[5]);
+
+    NodeCapacityIndex one(Resource{4, 4096});
+    one.add_node("only", Resource{4, 4096});
+    std::vector<Task> contended = {MakeTask(4, 1024, 0), MakeTask(4, 1024, 7)};
+    ASSERT_EQ(algo.place(contended, one, out), 1u);
+    EXPECT_EQ(out[0], NodeCapacityIndex::kNoNode);
+    EXPECT_EQ(out[1], 0u);
+}
+
+// 基准：1 万节点、20 万任务一批放置；与逐节点扫描的 first-fit 对比，并校验不超卖
+TEST(SchedulingAlgorithmTest, LargeBatchNearLinear) {
+    constexpr int kNodes = 10'000, kTasks = 200'000;
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> cores(1, 8), mem_gb(1, 16);
+
+    std::vector<Resource> shapes;
+    for (int i = 0; i < kNodes; ++i) shapes.push_back(Resource{16.0 * (1 + i % 4), 32768ull * (1 + i % 4)});
+    std::vector<Task> tasks;
+    tasks.reserve(kTasks);
+    for (int i = 0; i < kTasks; ++i) tasks.push_back(MakeTask(cores(rng) * 0.5, mem_gb(rng) * 512ull, i % 4));
+
+    NodeCapacityIndex idx(Resource{64, 131072});
+    for (int i = 0; i < kNodes; ++i) idx.add_node("n" + std::to_string(i), shapes[i]);
+    BinPackingAlgorithm algo;
+    std::vector<std::uint32_t> out;
+    auto t0 = Clock::now();
+    const std::size_t placed = algo.place(tasks, idx, out);
+    const auto packed = Clock::now() - t0;
+
+    std::vector<Resource> used(kNodes);
+    for (int i = 0; i < kTasks; ++i) {
+        if (out[i] == NodeCapacityIndex::kNoNode) continue;
+        used[out[i]].cpu_core += tasks[i].required.cpu_core;
+        used[out[i]].mem_mb += tasks[i].required.mem_mb;
+    }
+    for (int i = 0; i < kNodes; ++i) {
+        ASSERT_LE(used[i].cpu_core, shapes[i].cpu_core + 1e-9);
+        ASSERT_LE(used[i].mem_mb, shapes[i].mem_mb);
+    }
+
+    // 对照：在装满后的集群上逐节点扫描 first-fit（抽 1% 的任务，按比例折算）；
+    // 集群空闲时扫描很快就命中，代价主要在集群接近满的时候
+    std::vector<Resource> free(kNodes);
+    for (int i = 0; i < kNodes; ++i) {
+        free[i] = Resource{shapes[i].cpu_core - used[i].cpu_core, shapes[i].mem_mb - used[i].mem_mb};
+    }
+    std::size_t naive_placed = 0;
+    t0 = Clock::now();
+    for (int i = 0; i < kTasks / 100; ++i) {
+        for (auto& f : free) {
+            if (NodeCapacityIndex::Fits(f, tasks[i].required)) {
+                f.cpu_core -= tasks[i].required.cpu_core;
+                f.mem_mb -= tasks[i].required.mem_mb;
+                ++naive_placed;
+                break;
+            }
+        }
+    }
+    const auto naive = (Clock::now() - t0) * 100;
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << "[BinPacking] nodes=" << kNodes << " tasks=" << kTasks << " placed=" << placed
+              << " time=" << ms(packed).count() << "ms"
+              << " (linear scan on loaded cluster est. " << ms(naive).count() << "ms)" << std::endl;
+    EXPECT_GT(placed, static_cast<std::size_t>(kTasks / 2));
+}
+
+namespace {
+
+Task KeyedTask(const std::string& func, std::uint32_t shard, double cpu = 1) {
+    Task t = MakeTask(cpu, 256);
+    t.func_name = func;
+    t.shard = Shard{shard, 64};
+    return t;
+}
+
+} // namespace
+
+// 重跑同一批键：每个键回到上次的节点
+TEST(LocalityAwareAlgorithmTest, RerunsLandOnSameNode) {
+    NodeCapacityIndex idx(Resource{32, 65536});
+    for (int i = 0; i < 20; ++i) idx.add_node("n" + std::to_string(i), Resource{32, 65536});
+    std::vector<Task> batch;
+    for (std::uint32_t s = 0; s < 40; ++s) batch.push_back(KeyedTask("etl", s));
+
+    LocalityAwareAlgorithm algo;
+    std::vector<std::uint32_t> first, second;
+    ASSERT_EQ(algo.place(batch, idx, first), batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) idx.release(first[i], batch[i].required);
+    ASSERT_EQ(algo.place(batch, idx, second), batch.size());
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(algo.stats().recent_hits, batch.size());
+
+    // 换一个算法实例（没有“最近”记录），一致性哈希仍给出同样的归属
+    for (std::size_t i = 0; i < batch.size(); ++i) idx.release(second[i], batch[i].required);
+    LocalityAwareAlgorithm fresh;
+    std::vector<std::uint32_t> third;
+    fresh.place(batch, idx, third);
+    EXPECT_EQ(first, third);
+}
+
+// 单个热键不会压垮一个节点：占用份额不超过 load_factor 倍平均（外加一个任务）
+TEST(LocalityAwareAlgorithmTest, HotKeyLoadIsBounded) {
+    NodeCapacityIndex idx(Resource{32, 65536});
+    for (int i = 0; i < 10; ++i) idx.add_node("n" + std::to_string(i), Resource{32, 65536});
+    std::vector<Task> batch(200, KeyedTask("hot", 0));
+    LocalityAwareAlgorithm algo;
+    std::vector<std::uint32_t> out;
+    ASSERT_EQ(algo.place(batch, idx, out), batch.size());
+
+    std::vector<int> per_node(10, 0);
+    for (auto n : out) ++per_node[n];
+    const double avg = 200.0 / 10;
+    for (int n : per_node) EXPECT_LE(n, 1.25 * avg + 1);
+    EXPECT_GT(algo.stats().spilled, 0u);
+}
+
+// 加一个节点只搬走约 1/n 的键
+TEST(LocalityAwareAlgorithmTest, AddingNodeMovesFewKeys) {
+    std::vector<Task> batch;
+    for (std::uint32_t s = 0; s < 1000; ++s) batch.push_back(KeyedTask("k" + std::to_string(s), s, 0.01));
+    auto place = [&](int n_nodes) {
+        NodeCapacityIndex idx(Resource{64, 1 << 20});
+        for (int i = 0; i < n_nodes; ++i) idx.add_node("n" + std::to_string(i), Resource{64, 1 << 20});
+        // 宽松的负载上限，只看哈希归属
+        LocalityAwareAlgorithm algo(LocalityAwareAlgorithm::Options{100.0});
+        std::vector<std::uint32_t> out;
+        algo.place(batch, idx, out);
+        return out;
+    };
+    const auto before = place(10), after = place(11);
+    int moved = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i) moved += before[i] != after[i];
+    EXPECT_LT(moved, 200);                             // 理想值约 1000/11
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (before[i] != after[i]) {
+            EXPECT_EQ(after[i], 10u);   // 只会搬去新节点
+        }
+    }
+}
+
+// 模拟：100 个节点、500 个分片反复处理，统计落在“跑过该键的节点”的比例；对照 bin-packing
+TEST(LocalityAwareAlgorithmTest, WarmCacheHitRate) {
+    constexpr int kNodes = 100, kKeys = 500, kRounds = 20, kPerRound = 2000;
+    auto simulate = [&](SchedulingAlgorithm& algo) {
+        NodeCapacityIndex idx(Resource{16, 65536});
+        for (int i = 0; i < kNodes; ++i) idx.add_node("n" + std::to_string(i), Resource{16, 65536});
+        std::vector<std::vector<bool>> warm(kNodes, std::vector<bool>(kKeys, false));
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> pick(0, kKeys - 1);
+        std::size_t hits = 0, total = 0;
+        double worst = 0;
+        for (int r = 0; r < kRounds; ++r) {
+            std::vector<Task> batch;
+            std::vector<int> keys;
+            for (int i = 0; i < kPerRound; ++i) {
+                keys.push_back(std::min(pick(rng), pick(rng)));       // 偏向小编号的热分片
+                batch.push_back(KeyedTask("scan", static_cast<std::uint32_t>(keys.back()), 0.5));
+            }
+            std::vector<std::uint32_t> out;
+            algo.place(batch, idx, out);
+            std::vector<double> load(kNodes, 0);
+            for (int i = 0; i < kPerRound; ++i) {
+                if (out[i] == NodeCapacityIndex::kNoNode) continue;
+                ++total;
+                hits += warm[out[i]][keys[i]];
+                warm[out[i]][keys[i]] = true;
+                load[out[i]] += 0.5;
+            }
+            const double avg = std::accumulate(load.begin(), load.end(), 0.0) / kNodes;
+            worst = std::max(worst, *std::max_element(load.begin(), load.end()) / avg);
+            for (int i = 0; i < kPerRound; ++i) {
+                if (out[i] != NodeCapacityIndex::kNoNode) idx.release(out[i], batch[i].required);
+            }
+        }
+        return std::make_pair(static_cast<double>(hits) / static_cast<double>(total), worst);
+    };
+    BinPackingAlgorithm packing;
+    LocalityAwareAlgorithm locality;
+    const auto [pack_hit, pack_worst] = simulate(packing);
+    const auto [loc_hit, loc_worst] = simulate(locality);
+    std::cout << "[Locality] warm-cache hit rate: locality=" << loc_hit << " (max/avg load " << loc_worst
+              << "), bin-packing=" << pack_hit << " (max/avg load " << pack_worst << ")" << std::endl;
+    EXPECT_GT(loc_hit, pack_hit);
+}
@@ -0,0 +1,151 @@
+#include "sharded_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+// 并发预留不超卖，快照按版本跟上
+TEST(ClusterStateTest, ConcurrentReserveNeverOvercommits) {
+    ClusterState cluster(MakeNodes(1, Resource{100, 1 << 20}));
+    std::atomic<int> granted{0};
+    std::vector<std::thread> ths;
+    for (int t = 0; t < 8; ++t) {
+        ths.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) granted += cluster.try_reserve(0, Resource{1, 16});
+        });
+    }
+    for (auto& th : ths) th.join();
+    EXPECT_EQ(granted.load(), 100);
+    EXPECT_EQ(cluster.snapshot()->node(0).free.cpu_core, 0);
+    cluster.release(0, Resource{500, 1 << 30});          // 不超过容量
+    EXPECT_DOUBLE_EQ(cluster.free(0).cpu_core, 100);
+    EXPECT_EQ(cluster.snapshot()->node(0).free.mem_mb, 1u << 20);
+}
+
+// 多分片同时放置：总下发量受共享容量约束
+TEST(ShardedSchedulerTest, SharedCapacityAcrossShards) {
+    std::atomic<int> dispatched{0};
+    ShardedSchedulerOptions opt;
+    opt.shards = 4;
+    ShardedScheduler sched([] { return std::make_unique<BinPackingAlgorithm>(); }, MakeNodes(2, Resource{5, 8192}),
+                           [&](std::size_t, std::uint32_t, const std::string&, std::vector<Task>&& batch) {
+                               dispatched += static_cast<int>(batch.size());
+                           }, opt);
+    for (int i = 0; i < 1000; ++i) ASSERT_TRUE(sched.submit(MakeTask(std::to_string(i))));
+    sched.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    sched.stop();
+    EXPECT_EQ(dispatched.load(), 10);
+    EXPECT_EQ(sched.pending(), 990u);
+    EXPECT_DOUBLE_EQ(sched.cluster().free(0).cpu_core + sched.cluster().free(1).cpu_core, 0);
+
+    EXPECT_TRUE(sched.cancel("999"));
+    EXPECT_FALSE(sched.cancel("999"));
+}
+
+// DAG 由第一个任务所属分片跟踪；下游被别的分片偷去下发，finish 仍能推进
+TEST(ShardedSchedulerTest, DagAcrossShards) {
+    ShardedSchedulerOptions opt;
+    opt.shards = 2;
+    std::vector<std::tuple<std::size_t, std::uint32_t, Task>> done;
+    ShardedScheduler sched([] { return std::make_unique<BinPackingAlgorithm>(); }, MakeNodes(2, Resource{64, 65536}),
+                           [&](std::size_t shard, std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                               for (auto& t : batch) done.emplace_back(shard, node, std::move(t));
+                           }, opt);
+    std::vector<Task> dag;
+    dag.push_back(MakeTask("root"));
+    for (int i = 0; i < 8; ++i) {
+        dag.push_back(MakeTask("leaf" + std::to_string(i)));
+        dag.back().parent_ids = {"root"};
+    }
+    ASSERT_TRUE(sched.submit_dag(std::move(dag)));
+    const std::size_t owner = ShardedScheduler::OwnerOf("root", 2);
+    EXPECT_EQ(sched.shard(owner).in_dag(), 9u);
+
+    sched.shard(owner).run_cycle();
+    ASSERT_EQ(done.size(), 1u);
+    auto [shard, node, root] = std::move(done.front());
+    done.clear();
+    root.state = TaskState::SUCCESS;
+    EXPECT_TRUE(sched.finish(shard, node, root).empty());
+    EXPECT_EQ(sched.shard(owner).pending(), 8u);
+
+    // 另一分片空闲，偷走一部分下游去下发；结束时回到 owner 推进
+    sched.shard(1 - owner).run_cycle();
+    EXPECT_GT(sched.shard(1 - owner).stats().stolen, 0u);
+    sched.shard(owner).run_cycle();
+    ASSERT_EQ(done.size(), 8u);
+    for (auto& [s, n, t] : done) {
+        t.state = TaskState::SUCCESS;
+        sched.finish(s, n, t);
+    }
+    EXPECT_EQ(sched.shard(owner).in_dag(), 0u);
+    // 汇总各分片：下游跟着 root 放在同一节点
+    const auto total = sched.stats();
+    EXPECT_EQ(total.co_located, sched.shard(0).stats().co_located + sched.shard(1).stats().co_located);
+    EXPECT_GT(total.co_located, 0u);
+    EXPECT_EQ(total.dispatched, 9u);
+    EXPECT_DOUBLE_EQ(sched.cluster().free(0).cpu_core + sched.cluster().free(1).cpu_core, 128);
+}
+
+// 空闲分片从积压分片偷任务
+TEST(ShardedSchedulerTest, IdleShardSteals) {
+    std::vector<std::size_t> by_shard(2, 0);
+    ShardedSchedulerOptions opt;
+    opt.shards = 2;
+    ShardedScheduler sched([] { return std::make_unique<BinPackingAlgorithm>(); }, MakeNodes(4, Resource{64, 65536}),
+                           [&](std::size_t shard, std::uint32_t, const std::string&, std::vector<Task>&& batch) {
+                               by_shard[shard] += batch.size();
+                           }, opt);
+    int submitted = 0;
+    for (int i = 0; submitted < 100; ++i) {
+        const auto id = std::to_string(i);
+        if (ShardedScheduler::OwnerOf(id, 2) != 0) continue;
+        ASSERT_TRUE(sched.submit(MakeTask(id)));
+        ++submitted;
+    }
+    EXPECT_EQ(sched.shard(1).pending(), 0u);
+    EXPECT_EQ(sched.shard(1).run_cycle(), 50u);          // 偷一半
+    EXPECT_EQ(sched.shard(1).stats().stolen, 50u);
+    EXPECT_EQ(sched.shard(0).run_cycle(), 50u);
+    EXPECT_EQ(by_shard[0] + by_shard[1], 100u);
+}
+
+// 基准：1000 节点，分片数 1/2/4，下发即完成；吞吐随分片数的变化（受本机核数限制）
+TEST(ShardedSchedulerTest, ShardScalingBenchmark) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int kTasks = 200'000;
+    for (std::size_t shards : {1, 2, 4}) {
+        ShardedSchedulerOptions opt;
+        opt.shards = shards;
+        opt.scheduler.max_batch = 2048;
+        ShardedScheduler* self = nullptr;
+        ShardedScheduler sched([] { return std::make_unique<BinPackingAlgorithm>(); },
+                               MakeNodes(1000, Resource{32, 65536}),
+                               [&](std::size_t shard, std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                                   for (auto& t : batch) self->release(shard, node, t.required, t.client_id);
+                               }, opt);
+        self = &sched;
+        for (int i = 0; i < kTasks; ++i) sched.submit(MakeTask(std::to_string(i), 0.5 * (1 + i % 4), 512));
+        const auto t0 = Clock::now();
+        sched.start();
+        while (sched.stats().dispatched < static_cast<std::uint64_t>(kTasks)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        sched.stop();
+        const auto st = sched.stats();
+        std::cout << "[ShardedScheduler] cpus=" << std::thread::hardware_concurrency() << " shards=" << shards
+                  << " throughput=" << static_cast<long>(kTasks / secs) << "/s"
+                  << " conflicts=" << st.conflicts << " stolen=" << st.stolen << std::endl;
+        EXPECT_EQ(st.dispatched, static_cast<std::uint64_t>(kTasks));
+    }
+}
@@ -0,0 +1,222 @@
+#include "speculator.hpp"
+#include "task_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+namespace {
+
+Task FuncTask(const std::string& id, const std::string& func = "map") {
+    Task t = MakeTask(id);
+    t.func_name = func;
+    return t;
+}
+
+struct Running {
+    std::uint32_t node;
+    Task          task;
+};
+
+// 测试夹具：假时钟 + 4 个节点，先用 30 个 100ms 的任务喂出耗时分布
+struct SpecFixture {
+    std::int64_t now = 1'000'000;
+    std::vector<Running> running;
+    std::vector<std::pair<std::uint32_t, std::string>> cancelled;
+    std::unique_ptr<TaskScheduler> sched;
+
+    SpecFixture() {
+        SchedulerOptions opt;
+        opt.clock = [this] { return now; };
+        opt.speculation.enabled = true;
+        opt.speculation.scan_interval = std::chrono::milliseconds(0);
+        opt.speculation.max_fraction = 1.0;
+        NodeCapacityIndex nodes = MakeNodes(4, Resource{64, 65536});
+        sched = std::make_unique<TaskScheduler>(
+            std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+            [this](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                for (auto& t : batch) running.push_back(Running{node, std::move(t)});
+            }, opt);
+        sched->set_cancel_hook([this](std::uint32_t node, const std::string& id) { cancelled.emplace_back(node, id); });
+
+        for (int i = 0; i < 30; ++i) sched->submit(FuncTask("warm" + std::to_string(i)));
+        sched->run_cycle();
+        now += 100;
+        for (auto& r : running) {
+            r.task.state = TaskState::SUCCESS;
+            sched->finish(r.node, r.task);
+        }
+        running.clear();
+    }
+
+    Running Take(const std::string& id) {
+        auto it = std::find_if(running.begin(), running.end(), [&](const Running& r) { return r.task.task_id == id; });
+        Running r = std::move(*it);
+        running.erase(it);
+        return r;
+    }
+};
+
+} // namespace
+
+TEST(RuntimeStatsTest, Percentiles) {
+    RuntimeStats stats;
+    for (int ms = 1; ms <= 100; ++ms) stats.record("f", ms);
+    EXPECT_FALSE(stats.percentile("g", 0.5));
+    EXPECT_FALSE(stats.percentile("f", 0.5, 101));
+    const auto p50 = *stats.percentile("f", 0.5);
+    const auto p90 = *stats.percentile("f", 0.9);
+    EXPECT_GE(p50, 50);
+    EXPECT_LE(p50, 60);
+    EXPECT_GE(p90, 90);
+    EXPECT_LE(p90, 107);
+
+    // 衰减：新样本很快盖过旧分布
+    RuntimeStats decaying(64);
+    for (int i = 0; i < 64; ++i) decaying.record("f", 10);
+    for (int i = 0; i < 128; ++i) decaying.record("f", 1000);
+    EXPECT_GE(*decaying.percentile("f", 0.5), 1000);
+}
+
+// 掉队任务在别的节点起副本；副本先成功，原任务经钩子与 cancelled 标志中止，其结束不再作数
+TEST(SpeculatorTest, CopyWinsAndOriginalIsCancelled) {
+    SpecFixture f;
+    Task slow = FuncTask("slow");
+    slow.client_id = "tenant-a";
+    slow.func_params = {{"k", 1}};
+    ASSERT_TRUE(f.sched->submit(std::move(slow)));
+    f.sched->run_cycle();
+    ASSERT_EQ(f.running.size(), 1u);
+    const std::uint32_t home = f.running[0].node;
+
+    f.now += 120;                                      // 未到 p90 * 1.5
+    EXPECT_EQ(f.sched->run_cycle(), 0u);
+    f.now += 100;
+    EXPECT_EQ(f.sched->run_cycle(), 1u);
+    Running copy = f.Take("slow~spec");
+    EXPECT_NE(copy.node, home);
+    // 副本由紧凑任务表还原：参数与租户不变，取消标志独立
+    EXPECT_EQ(copy.task.func_name, "map");
+    EXPECT_EQ(copy.task.client_id, "tenant-a");
+    EXPECT_EQ(copy.task.func_params["k"], 1);
+    EXPECT_NE(copy.task.cancelled, f.running[0].task.cancelled);
+    EXPECT_EQ(f.sched->stats().speculated, 1u);
+    EXPECT_EQ(f.sched->run_cycle(), 0u);               // 一个任务只发一个副本
+
+    copy.task.state = TaskState::SUCCESS;
+    f.now += 90;
+    f.sched->finish(copy.node, copy.task);
+    ASSERT_EQ(f.cancelled.size(), 1u);
+    EXPECT_EQ(f.cancelled[0], std::make_pair(home, std::string("slow")));
+    Running orig = f.Take("slow");
+    EXPECT_TRUE(orig.task.cancelled->load());
+    orig.task.state = TaskState::CANCELLED;
+    EXPECT_FALSE(f.sched->settle(orig.node, orig.task));
+    EXPECT_EQ(f.sched->speculation().won, 1u);
+    EXPECT_EQ(f.sched->speculation().lost, 0u);
+}
+
+// 原任务先成功：副本被中止，记一次白跑；副本失败而原任务还在跑时不作数
+TEST(SpeculatorTest, OriginalWinsAndFailedCopyDoesNotCount) {
+    SpecFixture f;
+    f.sched->submit(FuncTask("a"));
+    f.sched->submit(FuncTask("b"));
+    f.sched->run_cycle();
+    f.now += 300;
+    EXPECT_EQ(f.sched->run_cycle(), 2u);
+
+    Running orig_a = f.Take("a");
+    orig_a.task.state = TaskState::SUCCESS;
+    ASSERT_EQ(f.sched->settle(orig_a.node, orig_a.task), std::optional<std::string>("a"));
+    ASSERT_EQ(f.cancelled.size(), 1u);
+    EXPECT_EQ(f.cancelled[0].second, "a~spec");
+    Running copy_a = f.Take("a~spec");
+    EXPECT_TRUE(copy_a.task.cancelled->load());
+    copy_a.task.state = TaskState::CANCELLED;
+    EXPECT_FALSE(f.sched->settle(copy_a.node, copy_a.task));
+    EXPECT_EQ(f.sched->speculation().lost, 1u);
+
+    Running copy_b = f.Take("b~spec");
+    copy_b.task.state = TaskState::FAILED;
+    EXPECT_FALSE(f.sched->settle(copy_b.node, copy_b.task));
+    Running orig_b = f.Take("b");
+    orig_b.task.state = TaskState::SUCCESS;
+    EXPECT_EQ(f.sched->settle(orig_b.node, orig_b.task), std::optional<std::string>("b"));
+    EXPECT_EQ(f.cancelled.size(), 1u);
+}
+
+// 模拟：20 个节点里 2 个慢 10 倍，每个作业 160 个分片任务，作业完成时间由最慢的分片决定。
+// 对比开/关推测执行的作业完成时间
+TEST(SpeculatorTest, StragglerSimulation) {
+    constexpr int kNodes = 20, kSlow = 2, kJobs = 20, kTasksPerJob = 160;
+    constexpr std::int64_t kStep = 10;
+    auto simulate = [&](bool speculate) {
+        std::int64_t now = 0;
+        SchedulerOptions opt;
+        opt.clock = [&] { return now; };
+        opt.speculation.enabled = speculate;
+        opt.speculation.scan_interval = std::chrono::milliseconds(kStep);
+        opt.speculation.min_elapsed_ms = 50;
+        NodeCapacityIndex nodes = MakeNodes(kNodes, Resource{4, 16384});
+        struct Run {
+            std::uint32_t node;
+            std::int64_t  end;
+            Task          task;
+        };
+        std::vector<Run> running;
+        TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                            [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                                for (auto& t : batch) {
+                                    // 80~120ms，慢节点 10 倍
+                                    std::int64_t d = 80 + static_cast<std::int64_t>(std::hash<std::string>{}(t.task_id) % 41);
+                                    if (node < kSlow) d *= 10;
+                                    running.push_back(Run{node, now + d, std::move(t)});
+                                }
+                            }, opt);
+
+        std::vector<std::int64_t> makespans;
+        for (int job = 0; job < kJobs; ++job) {
+            const std::int64_t start = now;
+            std::set<std::string> left;
+            for (int i = 0; i < kTasksPerJob; ++i) {
+                const std::string id = "j" + std::to_string(job) + "-" + std::to_string(i);
+                left.insert(id);
+                sched.submit(FuncTask(id));
+            }
+            while (!left.empty()) {
+                sched.run_cycle();
+                now += kStep;
+                for (std::size_t i = 0; i < running.size();) {
+                    Run& r = running[i];
+                    const bool aborted = r.task.cancelled->load();
+                    if (!aborted && r.end > now) {
+                        ++i;
+                        continue;
+                    }
+                    r.task.state = aborted ? TaskState::CANCELLED : TaskState::SUCCESS;
+                    if (auto id = sched.settle(r.node, r.task); id && !aborted) left.erase(*id);
+                    running[i] = std::move(running.back());
+                    running.pop_back();
+                }
+            }
+            makespans.push_back(now - start);
+        }
+        // 第一个作业用来攒耗时样本，不计
+        std::int64_t total = 0;
+        for (int j = 1; j < kJobs; ++j) total += makespans[j];
+        const auto st = sched.speculation();
+        std::cout << "[Speculation] " << (speculate ? "on " : "off") << " mean job makespan="
+                  << total / (kJobs - 1) << "ms launched=" << st.launched << " won=" << st.won
+                  << " lost=" << st.lost << std::endl;
+        return total / (kJobs - 1);
+    };
+    const auto off = simulate(false);
+    const auto on = simulate(true);
+    EXPECT_LT(on * 3, off * 2);                          // 实测约缩短一半
+}
@@ -0,0 +1,161 @@
+#include "task_queue.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dts;
+
+namespace {
+
+Task MakeTask(const std::string& id, std::uint32_t priority = 0) {
+    Task t;
+    t.task_id = id;
+    t.priority = priority;
+    return t;
+}
+
+} // namespace
+
+// 高优先级先出；同一优先级先进先出；超出档位的并入最高档
+TEST(TaskQueueTest, PriorityLanesAndFifo) {
+    TaskQueue q;
+    EXPECT_TRUE(q.push(MakeTask("low-1", 0)));
+    EXPECT_TRUE(q.push(MakeTask("high-1", 5)));
+    EXPECT_TRUE(q.push(MakeTask("low-2", 0)));
+    EXPECT_TRUE(q.push(MakeTask("top", 100)));
+    EXPECT_TRUE(q.push(MakeTask("high-2", 5)));
+    EXPECT_FALSE(q.push(MakeTask("high-1", 1)));        // 同 id 还在排队
+    EXPECT_EQ(q.size(), 5u);
+    EXPECT_EQ(q.lane_depth(TaskQueue::kLanes - 1), 1u);
+
+    std::vector<std::string> order;
+    while (auto t = q.pop()) order.push_back(t->task_id);
+    EXPECT_EQ(order, (std::vector<std::string>{"top", "high-1", "high-2", "low-1", "low-2"}));
+    EXPECT_TRUE(q.empty());
+    EXPECT_TRUE(q.push(MakeTask("high-1", 5)));         // 出队后可以再入队
+}
+
+// 取消只打墓碑：出队跳过，计数立即扣除，持有方能看到取消标志
+TEST(TaskQueueTest, CancelTombstones) {
+    TaskQueue q;
+    std::vector<std::shared_ptr<std::atomic<bool>>> flags;
+    for (int i = 0; i < 100; ++i) {
+        Task t = MakeTask(std::to_string(i), i % 3);
+        flags.push_back(t.cancelled);
+        ASSERT_TRUE(q.push(std::move(t)));
+    }
+    for (int i = 0; i < 100; i += 2) EXPECT_TRUE(q.cancel(std::to_string(i)));
+    EXPECT_FALSE(q.cancel("0"));                        // 已取消
+    EXPECT_FALSE(q.cancel("nope"));
+    EXPECT_EQ(q.size(), 50u);
+    EXPECT_FALSE(q.contains("0"));
+    EXPECT_TRUE(q.contains("1"));
+    EXPECT_TRUE(flags[0]->load());
+    EXPECT_FALSE(flags[1]->load());
+
+    std::vector<Task> out;
+    EXPECT_EQ(q.pop_batch(out, 1'000), 50u);
+    for (auto& t : out) EXPECT_EQ(std::stoi(t.task_id) % 2, 1);
+    for (std::size_t i = 1; i < out.size(); ++i) EXPECT_GE(out[i - 1].priority, out[i].priority);
+    EXPECT_FALSE(q.cancel("1"));                        // 已出队
+    for (std::size_t l = 0; l < TaskQueue::kLanes; ++l) EXPECT_EQ(q.lane_depth(l), 0u);
+}
+
+// 多生产者/多消费者/并发取消：每个任务恰好被取走或取消一次
+TEST(TaskQueueTest, ConcurrentPushPopCancel) {
+    constexpr int kProducers = 4, kConsumers = 4, kPerProducer = 20'000;
+    TaskQueue q;
+    std::atomic<int> produced{0}, popped{0}, cancelled{0};
+    std::atomic<bool> producing{true};
+    std::vector<std::vector<std::string>> got(kConsumers);
+
+    std::vector<std::thread> ths;
+    for (int p = 0; p < kProducers; ++p) {
+        ths.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                ASSERT_TRUE(q.push(MakeTask(std::to_string(p * kPerProducer + i), i % 4)));
+                ++produced;
+                if (i % 7 == 0 && q.cancel(std::to_string(p * kPerProducer + i / 2))) ++cancelled;
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        ths.emplace_back([&, c] {
+            std::vector<Task> batch;
+            while (producing.load() || !q.empty()) {
+                batch.clear();
+                if (q.pop_batch(batch, 32) == 0) std::this_thread::yield();
+                for (auto& t : batch) got[c].push_back(std::move(t.task_id));
+                popped += static_cast<int>(batch.size());
+            }
+        });
+    }
+    for (int p = 0; p < kProducers; ++p) ths[p].join();
+    producing = false;
+    for (std::size_t i = kProducers; i < ths.size(); ++i) ths[i].join();
+
+    EXPECT_EQ(produced.load(), kProducers * kPerProducer);
+    EXPECT_EQ(popped.load() + cancelled.load(), kProducers * kPerProducer);
+    std::set<std::string> unique;
+    for (auto& v : got) unique.insert(v.begin(), v.end());
+    EXPECT_EQ(unique.size(), static_cast<std::size_t>(popped.load()));
+    EXPECT_TRUE(q.empty());
+}
+
+// 基准：100 万深度下的入队/出队速率（单线程灌满再批量取空；再测 4+4 线程并发）
+TEST(TaskQueueTest, MillionDepthThroughput) {
+    constexpr int kDepth = 1'000'000;
+    using Clock = std::chrono::steady_clock;
+    auto rate = [](int n, Clock::duration d) {
+        return static_cast<long>(n / std::chrono::duration<double>(d).count());
+    };
+
+    TaskQueue q;
+    std::vector<Task> tasks;
+    tasks.reserve(kDepth);
+    for (int i = 0; i < kDepth; ++i) tasks.push_back(MakeTask(std::to_string(i), i % 8));
+
+    auto t0 = Clock::now();
+    for (auto& t : tasks) q.push(std::move(t));
+    const auto enq = Clock::now() - t0;
+    ASSERT_EQ(q.size(), static_cast<std::size_t>(kDepth));
+
+    tasks.clear();
+    t0 = Clock::now();
+    while (q.pop_batch(tasks, 256) == 256) {}
+    const auto deq = Clock::now() - t0;
+    ASSERT_EQ(tasks.size(), static_cast<std::size_t>(kDepth));
+
+    // 并发：预灌 1M，再由 4 个生产者和 4 个消费者同时各做 kOps 次
+    constexpr int kThreads = 4, kOps = 100'000;
+    for (int i = 0; i < kDepth; ++i) q.push(MakeTask("d" + std::to_string(i), i % 8));
+    std::atomic<int> done{0};
+    std::vector<std::thread> ths;
+    t0 = Clock::now();
+    for (int p = 0; p < kThreads; ++p) {
+        ths.emplace_back([&, p] {
+            for (int i = 0; i < kOps; ++i) q.push(MakeTask(std::to_string(p) + "-" + std::to_string(i), i % 8));
+        });
+        ths.emplace_back([&] {
+            std::vector<Task> batch;
+            for (int n = 0; n < kOps;) {
+                batch.clear();
+                n += static_cast<int>(q.pop_batch(batch, std::min(64, kOps - n)));
+            }
+            done += kOps;
+        });
+    }
+    for (auto& th : ths) th.join();
+    const auto mixed = Clock::now() - t0;
+    EXPECT_EQ(q.size(), static_cast<std::size_t>(kDepth));
+
+    std::cout << "[TaskQueue] depth=" << kDepth << " enqueue=" << rate(kDepth, enq) << "/s"
+              << " dequeue(batch 256)=" << rate(kDepth, deq) << "/s"
+              << " mixed " << kThreads << "P+" << kThreads << "C=" << rate(2 * kThreads * kOps, mixed)
+              << " ops/s" << std::endl;
+}
@@ -0,0 +1,111 @@
+#include "task_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+// 一轮内同一节点的任务合成一条消息
+TEST(TaskSchedulerTest, OneMessagePerNodePerCycle) {
+    std::map<std::string, std::vector<std::string>> got;
+    int messages = 0;
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), MakeNodes(3, Resource{8, 8192}),
+                        [&](std::uint32_t, const std::string& node_id, std::vector<Task>&& batch) {
+                            ++messages;
+                            for (auto& t : batch) got[node_id].push_back(t.task_id);
+                        });
+    for (int i = 0; i < 24; ++i) ASSERT_TRUE(sched.submit(MakeTask(std::to_string(i))));
+    EXPECT_EQ(sched.run_cycle(), 24u);
+    EXPECT_EQ(messages, 3);
+    for (auto& [node, ids] : got) EXPECT_EQ(ids.size(), 8u) << node;
+    EXPECT_EQ(sched.stats().messages, 3u);
+    EXPECT_EQ(sched.pending(), 0u);
+}
+
+// 放不下的回队，资源归还后下一轮下发
+TEST(TaskSchedulerTest, RequeueUntilReleased) {
+    std::vector<std::pair<std::uint32_t, Task>> running;
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), MakeNodes(1, Resource{2, 4096}),
+                        [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                            for (auto& t : batch) running.emplace_back(node, std::move(t));
+                        });
+    for (int i = 0; i < 4; ++i) sched.submit(MakeTask(std::to_string(i)));
+    EXPECT_TRUE(sched.cancel("3"));
+    EXPECT_EQ(sched.run_cycle(), 2u);
+    EXPECT_EQ(sched.pending(), 1u);
+    EXPECT_EQ(sched.stats().requeued, 1u);
+    EXPECT_EQ(sched.run_cycle(), 0u);
+
+    sched.release(running[0].first, running[0].second.required, running[0].second.client_id);
+    EXPECT_EQ(sched.run_cycle(), 1u);
+    EXPECT_EQ(running.back().second.task_id, "2");
+}
+
+// 轮间隔随积压缩短
+TEST(TaskSchedulerTest, IntervalFollowsBacklog) {
+    SchedulerOptions opt;
+    opt.max_batch = 100;
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), MakeNodes(1, Resource{1, 1024}),
+                        [](std::uint32_t, const std::string&, std::vector<Task>&&) {}, opt);
+    sched.run_cycle();
+    EXPECT_EQ(sched.interval(), opt.max_interval);
+    for (int i = 0; i < 151; ++i) sched.submit(MakeTask(std::to_string(i)));
+    sched.run_cycle();                                   // 放下 1 个，余 150 > max_batch
+    EXPECT_EQ(sched.interval(), opt.min_interval);
+    for (int i = 60; i < 151; ++i) sched.cancel(std::to_string(i));
+    sched.run_cycle();                                   // 余 59：间隔在两端之间
+    EXPECT_GT(sched.interval(), opt.min_interval);
+    EXPECT_LT(sched.interval(), opt.max_interval);
+}
+
+// 基准：1000 个模拟节点，任务下发即完成；对比每轮 4096 与每轮 1 个（逐任务决策、逐任务消息）
+TEST(TaskSchedulerTest, ThousandNodeBenchmark) {
+    using Clock = std::chrono::steady_clock;
+    auto run = [](std::size_t max_batch, int total) {
+        SchedulerOptions opt;
+        opt.max_batch = max_batch;
+        std::vector<Clock::time_point> submitted(total);
+        std::vector<std::int64_t> latency_us;
+        latency_us.reserve(total);
+        TaskScheduler* self = nullptr;
+        TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), MakeNodes(1000, Resource{32, 65536}),
+                            [&](std::uint32_t node, const std::string&, std::vector<Task>&& batch) {
+                                const auto now = Clock::now();
+                                for (auto& t : batch) {
+                                    latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                                        now - submitted[std::stoi(t.task_id)]).count());
+                                    self->release(node, t.required, t.client_id);
+                                }
+                            }, opt);
+        self = &sched;
+        sched.start();
+        const auto t0 = Clock::now();
+        for (int i = 0; i < total; ++i) {
+            submitted[i] = Clock::now();
+            sched.submit(MakeTask(std::to_string(i), 0.5 * (1 + i % 4), 512ull * (1 + i % 8)));
+        }
+        while (sched.stats().dispatched < static_cast<std::uint64_t>(total)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        sched.stop();
+        std::sort(latency_us.begin(), latency_us.end());
+        const auto st = sched.stats();
+        std::cout << "[TaskScheduler] nodes=1000 batch=" << max_batch << " tasks=" << total
+                  << " throughput=" << static_cast<long>(total / secs) << "/s"
+                  << " latency p50=" << latency_us[latency_us.size() / 2] << "us"
+                  << " p99=" << latency_us[latency_us.size() * 99 / 100] << "us"
+                  << " cycles=" << st.cycles << " messages=" << st.messages << std::endl;
+        return total / secs;
+    };
+    const double batched = run(4096, 200'000);
+    const double per_task = run(1, 20'000);
+    EXPECT_GT(batched, per_task);
+}
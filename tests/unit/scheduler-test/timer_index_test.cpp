@@ -0,0 +1,172 @@
+#include "timer_index.hpp"
+#include "cron_spec.hpp"
+#include "task_scheduler.hpp"
+#include "scheduler_test_util.hpp"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace dts;
+using namespace dts::test;
+
+namespace {
+
+constexpr std::int64_t kMin = 60'000;
+constexpr std::int64_t kDay = 86'400'000;
+constexpr std::int64_t k2024 = 1704067200000;   // 2024-01-01 00:00 UTC，周一
+
+} // namespace
+
+TEST(CronSpecTest, ParseRejectsBadSpecs) {
+    EXPECT_FALSE(CronSpec::Parse(""));
+    EXPECT_FALSE(CronSpec::Parse("* * * *"));
+    EXPECT_FALSE(CronSpec::Parse("60 * * * *"));
+    EXPECT_FALSE(CronSpec::Parse("*/0 * * * *"));
+    EXPECT_FALSE(CronSpec::Parse("5-1 * * * *"));
+    EXPECT_FALSE(CronSpec::Parse("@every 10"));
+    EXPECT_FALSE(CronSpec::Parse("@every 0s"));
+    EXPECT_TRUE(CronSpec::Parse("*/15 9-18 * * 1-5"));
+    EXPECT_TRUE(CronSpec::Parse("0 0 1,15 * 7"));
+}
+
+TEST(CronSpecTest, NextAfter) {
+    auto every = CronSpec::Parse("@every 90s");
+    ASSERT_TRUE(every);
+    EXPECT_EQ(every->next_after(1000), 91'000);
+
+    auto quarter = CronSpec::Parse("*/15 * * * *");
+    EXPECT_EQ(quarter->next_after(k2024), k2024 + 15 * kMin);            // 严格晚于
+    EXPECT_EQ(quarter->next_after(k2024 + 1), k2024 + 15 * kMin);
+
+    // 工作日 9 点：周六 00:00 之后是下周一 09:00
+    auto weekday = CronSpec::Parse("0 9 * * 1-5");
+    EXPECT_EQ(weekday->next_after(k2024 + 5 * kDay), k2024 + 7 * kDay + 9 * 60 * kMin);
+
+    // 日与周都受限时取“或”：1 号或周日
+    auto either = CronSpec::Parse("0 0 1 * 0");
+    EXPECT_EQ(either->next_after(k2024), k2024 + 6 * kDay);             // 1 月 7 日周日
+
+    // 闰日
+    auto leap = CronSpec::Parse("30 12 29 2 *");
+    EXPECT_EQ(leap->next_after(k2024), k2024 + 59 * kDay + 12 * 60 * kMin + 30 * kMin);
+    EXPECT_EQ(CronSpec::Parse("0 0 30 2 *")->next_after(k2024), CronSpec::kNever);
+}
+
+TEST(TimerIndexTest, ReleasesInDueOrderAndBatches) {
+    TimerIndex timers;
+    for (int i = 9; i >= 0; --i) ASSERT_TRUE(timers.schedule(MakeTask(std::to_string(i)), 100 + i));
+    EXPECT_FALSE(timers.schedule(MakeTask("3"), 5));
+    EXPECT_EQ(timers.next_due(), 100);
+
+    std::vector<Task> out;
+    EXPECT_EQ(timers.release_due(99, out, 100), 0u);
+    EXPECT_EQ(timers.release_due(105, out, 4), 4u);                    // 批上限
+    EXPECT_EQ(timers.release_due(105, out, 100), 2u);
+    ASSERT_EQ(out.size(), 6u);
+    for (int i = 0; i < 6; ++i) EXPECT_EQ(out[i].task_id, std::to_string(i));
+    EXPECT_EQ(timers.size(), 4u);
+    EXPECT_EQ(timers.next_due(), 106);
+}
+
+TEST(TimerIndexTest, CancelLeavesTombstone) {
+    TimerIndex timers;
+    for (int i = 0; i < 200; ++i) timers.schedule(MakeTask(std::to_string(i)), i);
+    EXPECT_TRUE(timers.cancel("0"));
+    EXPECT_FALSE(timers.cancel("0"));
+    EXPECT_EQ(timers.next_due(), 1);
+    for (int i = 1; i < 150; ++i) timers.cancel(std::to_string(i));    // 过半触发重建
+    EXPECT_EQ(timers.size(), 50u);
+    EXPECT_EQ(timers.next_due(), 150);
+    // 取消后同 id 可重新登记，旧墓碑不会被当成它弹出
+    EXPECT_TRUE(timers.schedule(MakeTask("0"), 1000));
+    std::vector<Task> out;
+    EXPECT_EQ(timers.release_due(999, out, 1000), 50u);
+    EXPECT_EQ(timers.release_due(1000, out, 1000), 1u);
+    EXPECT_EQ(out.back().task_id, "0");
+}
+
+TEST(TimerIndexTest, SchedulerHoldsDelayedAndRecurring) {
+    std::int64_t now = k2024;
+    SchedulerOptions opt;
+    opt.clock = [&] { return now; };
+    std::vector<std::string> got;
+    NodeCapacityIndex nodes = MakeNodes(1, Resource{64, 65536});
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                        [&](std::uint32_t, const std::string&, std::vector<Task>&& batch) {
+                            for (auto& t : batch) got.push_back(t.task_id);
+                        }, opt);
+
+    Task later = MakeTask("later");
+    later.not_before_ts = now + 5000;
+    Task every = MakeTask("tick");
+    every.recurrence = "@every 10s";
+    Task bad = MakeTask("bad");
+    bad.recurrence = "every minute";
+    ASSERT_TRUE(sched.submit(later));
+    ASSERT_TRUE(sched.submit(every));
+    EXPECT_FALSE(sched.submit(bad));
+    ASSERT_TRUE(sched.submit(MakeTask("now")));
+    EXPECT_EQ(sched.delayed(), 2u);
+
+    sched.run_cycle();
+    EXPECT_EQ(got, std::vector<std::string>{"now"});
+
+    now += 5000;
+    sched.run_cycle();
+    now += 5000;
+    sched.run_cycle();
+    now += 35'000;                                                      // 落后 3 次：只补一次
+    sched.run_cycle();
+    EXPECT_EQ(got, (std::vector<std::string>{"now", "later", "tick#" + std::to_string(k2024 + 10'000),
+                                             "tick#" + std::to_string(k2024 + 20'000)}));
+    EXPECT_EQ(sched.delayed(), 1u);
+    EXPECT_EQ(sched.stats().fired, 3u);
+
+    EXPECT_TRUE(sched.cancel("tick"));
+    now += kDay;
+    sched.run_cycle();
+    EXPECT_EQ(got.size(), 4u);
+    EXPECT_EQ(sched.delayed(), 0u);
+}
+
+// 基准：大量未来任务登记进调度器后，空转一轮只看堆顶，与登记数无关；到期后按批放出
+TEST(TimerIndexTest, FutureTasksCostNothingUntilDue) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int kTasks = 250'000;
+    std::int64_t now = k2024;
+    SchedulerOptions opt;
+    opt.clock = [&] { return now; };
+    std::size_t dispatched = 0;
+    NodeCapacityIndex nodes = MakeNodes(1, Resource{1e9, 1ull << 40});
+    TaskScheduler sched(std::make_unique<BinPackingAlgorithm>(), std::move(nodes),
+                        [&](std::uint32_t, const std::string&, std::vector<Task>&& batch) {
+                            dispatched += batch.size();
+                        }, opt);
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < kTasks; ++i) {
+        Task t = MakeTask(std::to_string(i));
+        t.not_before_ts = now + kDay + (i * 7919LL) % kDay;             // 未来一天内打散
+        sched.submit(std::move(t));
+    }
+    const double insert_s = std::chrono::duration<double>(Clock::now() - t0).count();
+    ASSERT_EQ(sched.delayed(), static_cast<std::size_t>(kTasks));
+
+    constexpr int kIdle = 10'000;
+    t0 = Clock::now();
+    for (int i = 0; i < kIdle; ++i) sched.run_cycle();
+    const double idle_us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / kIdle;
+    EXPECT_EQ(dispatched, 0u);
+
+    now += 2 * kDay;
+    t0 = Clock::now();
+    while (dispatched < static_cast<std::size_t>(kTasks)) sched.run_cycle();
+    const double release_s = std::chrono::duration<double>(Clock::now() - t0).count();
+    EXPECT_EQ(sched.delayed(), 0u);
+
+    std::cout << "[TimerIndex] tasks=" << kTasks << " insert=" << insert_s << "s"
+              << " idle_cycle=" << idle_us << "us release_all=" << release_s << "s" << std::endl;
+    EXPECT_LT(idle_us, 50.0);
+}
@@ -6,6 +6,7 @@
 #include <boost/asio.hpp>
 #include <nlohmann/json.hpp>
 #include "task_executor.hpp"
+#include "task_pool.hpp"
 #include "task.hpp"
 #include "utils.hpp"
 #include <boost/asio/error.hpp>
@@ -66,7 +67,7 @@ protected:
     }
 };
 
-/* ---------------- 7 条用例 ---------------- */
+/* ---------------- 8 条用例 ---------------- */
 
 TEST_F(TaskExecutorTest, RegisterAndSuccess)
 {
@@ -163,4 +164,98 @@ TEST_F(TaskExecutorTest, UnknownFunction)
     exe->execute_task(t);
     wait_done(t);
     EXPECT_EQ(t->state, TaskState::FAILED);
-}
\ No newline at end of file
+}
+
+// DAG 下游在同一节点上直接拿到上游的 result 与输出附件；下游都取过的上游结果随即释放
+TEST_F(TaskExecutorTest, ParentResultsPassLocally)
+{
+    exe->register_function("produce", [](const json& p, std::shared_ptr<Task> t) {
+        t->outputs.push_back(Attachment{"blob", "application/octet-stream", Payload::Copy("xyz")});
+        return json{{"result", p.value("v", 0)}};
+    });
+    exe->register_function("sum_parents", [](const json& p, std::shared_ptr<Task> t) {
+        int sum = 0;
+        for (auto& [id, r] : p["parents"].items()) sum += r["result"].get<int>();
+        return json{{"result", sum}, {"inputs", t->inputs.size()}};
+    });
+    auto a = make_task("produce", json{{"v", 3}}, 1000);
+    auto b = make_task("produce", json{{"v", 4}}, 1000);
+    a->task_id = "a";
+    b->task_id = "b";
+    a->child_count = 2;
+    b->child_count = 1;
+    exe->execute_task(a);
+    exe->execute_task(b);
+    wait_done(a);
+    wait_done(b);
+
+    auto c = make_task("sum_parents", json::object(), 1000);
+    c->task_id = "c";
+    c->parent_ids = {"a", "b", "elsewhere"};
+    exe->execute_task(c);
+    wait_done(c);
+    ASSERT_EQ(c->state, TaskState::SUCCESS);
+    EXPECT_EQ(c->result["result"], 7);
+    EXPECT_EQ(c->result["inputs"], 2);
+    ASSERT_NE(FindAttachment(c->inputs, "a/blob"), nullptr);
+    EXPECT_EQ(exe->results().size(), 1u);              // b 已被唯一的下游取走，c 没有下游不存
+
+    auto d = make_task("sum_parents", json::object(), 1000);
+    d->task_id = "d";
+    d->parent_ids = {"a"};
+    exe->execute_task(d);
+    wait_done(d);
+    ASSERT_EQ(d->state, TaskState::SUCCESS);
+    EXPECT_EQ(d->result["result"], 3);
+    EXPECT_EQ(exe->results().size(), 0u);
+}
+
+TEST_F(TaskExecutorTest, PreemptReturnsCheckpoint)
+{
+    // 每步 10ms，从 checkpoint 续跑，看到取消标志时交回进度
+    exe->register_function("steps", [](const json& p, std::shared_ptr<Task> task) {
+        for (int i = p.value("checkpoint", 0); i < 30; ++i) {
+            if (task->cancelled->load()) return json{{"checkpoint", i}};
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return json{{"result", "done"}};
+    });
+    auto t = make_task("steps", json::object(), 5000);
+    t->task_id = "steps-1";
+    exe->execute_task(t);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    EXPECT_FALSE(exe->preempt("nowhere"));
+    ASSERT_TRUE(exe->preempt("steps-1"));
+    wait_done(t);
+    ASSERT_EQ(t->state, TaskState::CANCELLED);
+    const int done = t->result["checkpoint"].get<int>();
+    EXPECT_GT(done, 0);
+    EXPECT_EQ(t->retry_count, 0u);
+    EXPECT_FALSE(exe->preempt("steps-1"));             // 已结束
+
+    auto again = make_task("steps", json{{"checkpoint", done}}, 5000);
+    again->task_id = "steps-1";
+    exe->execute_task(again);
+    wait_done(again);
+    EXPECT_EQ(again->state, TaskState::SUCCESS);
+    EXPECT_EQ(again->result["result"], "done");
+}
+
+TEST(TaskPoolTest, RecycleAcrossThreadsAndHighWater)
+{
+    auto base = TaskPool::stats();
+    {
+        std::vector<std::shared_ptr<Task>> batch;
+        for (int i = 0; i < 1000; ++i) batch.push_back(TaskPool::make());
+        EXPECT_EQ(TaskPool::stats().live, base.live + 1000);
+        // 在另一线程释放，块经仓库回流
+        std::thread([b = std::move(batch)]() mutable { b.clear(); }).join();
+    }
+    auto after = TaskPool::stats();
+    EXPECT_EQ(after.live, base.live);
+    EXPECT_GE(after.high_water, base.live + 1000);
+
+    auto t = TaskPool::make();
+    EXPECT_FALSE(t->cancelled->load());
+    EXPECT_EQ(t->state, TaskState::PENDING);
+}